@@ -166,28 +166,34 @@ async function dnsLookup() {
 }
 
 // Port Scanner
+let psFound = []; // open ports streamed over /wsdisc
 async function doPortScan() {
   const host = $("psIp").value;
   const pStr = $("psPorts").value;
   if (!host || !pStr) return alert("Missing Target/Ports");
 
-  const ports = pStr.split(',').map(s => parseInt(s.trim())).filter(n => !isNaN(n));
   $("psOut").textContent = `Starting scan on ${host}...`;
+  psFound = [];
 
   try {
-    // Start Scan
-    await apiPost("/api/portscan", { host, ports });
+    // Start Scan; ports takes ranges like "1-1024,4352"
+    await apiPost("/api/portscan", { host, ports: pStr.replace(/\s+/g, "") });
 
     // Poll
     const interval = setInterval(async () => {
       try {
         const r = await apiGet("/api/portscan/status");
         if (r.running) {
-          $("psOut").textContent = `Scanning... ${r.progress}%`;
+          $("psOut").textContent = `Scanning... ${r.progress}% (${Math.round(r.portsPerSec)} ports/s)\n` +
+            `Open: ${psFound.join(", ") || "-"}`;
+        } else if (r.error) {
+          clearInterval(interval);
+          $("psOut").textContent = "Scan failed: " + r.error;
         } else {
           clearInterval(interval);
           const open = r.open.join(", ");
-          $("psOut").innerHTML = `Scan Complete.\nOpen Ports: ${open.length ? open : "None"}`;
+          $("psOut").textContent = `Scan Complete: ${r.scanned} ports in ${(r.elapsedMs / 1000).toFixed(1)}s` +
+            ` (${Math.round(r.portsPerSec)} ports/s).\nOpen Ports: ${open.length ? open : "None"}`;
         }
       } catch (e) {
         clearInterval(interval);
@@ -250,14 +256,54 @@ async function scanCached() {
 }
 
 // Websockets
-let wsLog, wsTerm, wsRS232, wsProxy, wsDisc, wsUdp, wsTcpServer;
+let wsLog, wsTerm, wsRS232, wsProxy, wsDisc, wsUdp, wsTcpServer, wsMacro;
+
+// Binary data frames (layout in include/WsStream.h). Data sockets opt in on
+// open; wsMsg() turns either kind of message into the JSON-shaped object the
+// handlers below expect, rendering hex/ascii here instead of on the ESP32.
+function wsOptBinary(ws) {
+  ws.binaryType = "arraybuffer";
+  ws.addEventListener("open", () => ws.send(JSON.stringify({ action: "binary", on: true })));
+}
+
+function wsMsg(data) {
+  if (typeof data === "string") return JSON.parse(data);
+  const v = new DataView(data);
+  const ch = v.getUint8(1), dir = v.getUint8(2);
+  const bytes = new Uint8Array(data, 16, v.getUint16(14, true));
+  const ip = new Uint8Array(data, 8, 4).join(".");
+  const msg = {
+    type: dir ? "tx" : "rx",
+    ts: v.getUint32(4, true),
+    from: ip, port: v.getUint16(12, true),
+    hex: Array.from(bytes, b => b.toString(16).toUpperCase().padStart(2, "0")).join(" "),
+    ascii: String.fromCharCode(...Array.from(bytes, b => b >= 32 && b <= 126 ? b : 46)),
+  };
+  if (ch === 3) { msg.type = "data"; msg.dir = dir ? "TX(client->target)" : "RX(target->client)"; }
+  return msg;
+}
 
 
 function logLine(s) {
   const el = $("log"); if (el) { const d = document.createElement("div"); d.textContent = s; el.appendChild(d); el.scrollTop = el.scrollHeight; }
 }
 
-function connectLogWs() {
+// Same shape as the lines the firmware pushes on /ws.
+function logRecLine(r) {
+  const tag = r.level === "info" ? "" : `[${r.level[0].toUpperCase()}] `;
+  return tag + (r.module === "app" ? "" : r.module + ": ") + r.text;
+}
+
+let logHistoryLoaded = false;
+
+async function connectLogWs() {
+  if (!logHistoryLoaded) {
+    logHistoryLoaded = true;
+    try {
+      const j = await apiGet("/api/logs?fields=level,module,text");
+      j.records.forEach((r) => logLine(logRecLine(r)));
+    } catch (e) { }
+  }
   const proto = location.protocol === "https:" ? "wss" : "ws";
   wsLog = new WebSocket(`${proto}://${location.host}/ws`);
   wsLog.onmessage = (e) => logLine(e.data);
@@ -267,9 +313,10 @@ function connectLogWs() {
 function connectTermWs() {
   const proto = location.protocol === "https:" ? "wss" : "ws";
   wsTerm = new WebSocket(`${proto}://${location.host}/term`);
+  wsOptBinary(wsTerm);
   wsTerm.onmessage = (e) => {
     try {
-      const msg = JSON.parse(e.data);
+      const msg = wsMsg(e.data);
       if (msg.type === "status") $("termOut").innerHTML += `<div class="muted">STATUS: ${msg.connected ? "Connected" : "Discon"}</div>`;
       else if (msg.type === "rx") $("termOut").innerHTML += `<div><span class="rx">RX</span> ${esc(msg.ascii)}</div>`;
       else if (msg.type === "tx") $("termOut").innerHTML += `<div><span class="tx">TX</span> ok</div>`;
@@ -284,9 +331,10 @@ function connectTermWs() {
 function connectRS232Ws() {
   const proto = location.protocol === "https:" ? "wss" : "ws";
   wsRS232 = new WebSocket(`${proto}://${location.host}/wsrs232`);
+  wsOptBinary(wsRS232);
   wsRS232.onmessage = (e) => {
     try {
-      const msg = JSON.parse(e.data);
+      const msg = wsMsg(e.data);
       if (msg.type === "status") {
         if (msg.baud && $("rs232Baud")) $("rs232Baud").value = msg.baud;
         if ($("rs232Invert") && msg.invert !== undefined) $("rs232Invert").checked = msg.invert;
@@ -312,7 +360,10 @@ function connectDiscWs() {
   wsDisc.onmessage = (e) => {
     try {
       const msg = JSON.parse(e.data);
-      if (msg.ip) {
+      if (msg.type === "port") {
+        psFound.push(msg.port);
+        $("psOut").textContent += `\nOpen: ${msg.port}`;
+      } else if (msg.ip) {
         const d = document.createElement("div");
         d.innerHTML = `<b>${msg.ip}</b> ${msg.openPorts.join(",")}`;
         $("discOut").appendChild(d);
@@ -322,12 +373,34 @@ function connectDiscWs() {
   wsDisc.onclose = () => setTimeout(connectDiscWs, 2000);
 }
 
+function connectMacroWs() {
+  const proto = location.protocol === "https:" ? "wss" : "ws";
+  wsMacro = new WebSocket(`${proto}://${location.host}/wsmacro`);
+  wsMacro.onmessage = (e) => {
+    try {
+      const msg = JSON.parse(e.data);
+      if (msg.type === "step" && msg.runId === traceRunId) {
+        $("macroTraceRows").insertAdjacentHTML("beforeend", traceRow(msg.step));
+      } else if (msg.type === "run") {
+        if (msg.run.state === "running" && msg.run.macroId === traceMacroId && $("macroTrace").style.display !== "none") {
+          traceRunId = msg.run.runId;
+          $("macroTraceTitle").textContent = `Run #${msg.run.runId}: ${msg.run.name} (running)`;
+          $("macroTraceRows").innerHTML = "";
+        }
+        loadMacros();
+      }
+    } catch { }
+  };
+  wsMacro.onclose = () => setTimeout(connectMacroWs, 2000);
+}
+
 function connectUdpWs() {
   const proto = location.protocol === "https:" ? "wss" : "ws";
   wsUdp = new WebSocket(`${proto}://${location.host}/wsudp`);
+  wsOptBinary(wsUdp);
   wsUdp.onmessage = (e) => {
     try {
-      const msg = JSON.parse(e.data);
+      const msg = wsMsg(e.data);
       if (msg.type === "rx") {
         $("udpOut").innerHTML += `<div><span class="rx">RX</span> ${msg.from}:${msg.port} ${esc(msg.ascii)}</div>`;
         $("udpOut").scrollTop = $("udpOut").scrollHeight;
@@ -340,9 +413,10 @@ function connectUdpWs() {
 function connectTcpServerWs() {
   const proto = location.protocol === "https:" ? "wss" : "ws";
   wsTcpServer = new WebSocket(`${proto}://${location.host}/wstcpserver`);
+  wsOptBinary(wsTcpServer);
   wsTcpServer.onmessage = (e) => {
     try {
-      const msg = JSON.parse(e.data);
+      const msg = wsMsg(e.data);
       if (msg.type === "rx") {
         $("tcpServerOut").innerHTML += `<div><span class="rx">RX</span> ${msg.from} ${esc(msg.ascii)}</div>`;
         $("tcpServerOut").scrollTop = $("tcpServerOut").scrollHeight;
@@ -381,6 +455,7 @@ window.onload = async () => {
   connectDiscWs();
   connectUdpWs();
   connectTcpServerWs();
+  connectMacroWs();
 
   loadWifiForm();
   refreshHealth();
@@ -426,6 +501,16 @@ window.onload = async () => {
     mdnsCust.style.display = mdnsSel.value === "custom" ? "block" : "none";
   };
 
+  const renderMdns = (res) => {
+    $("mdnsOut").innerHTML = "";
+    (res.results || []).forEach(r => {
+      const txt = Object.entries(r.txt || {}).map(([k, v]) => v ? `${k}=${v}` : k).join(" ");
+      $("mdnsOut").innerHTML += `<div class="item"><b>${esc(r.instance || r.hostname)}</b> ${esc(r.type)}<br>
+          ${esc(r.hostname)} ${r.ip}:${r.port}
+          ${txt ? `<br><span class="small">${esc(txt)}</span>` : ""}</div>`;
+    });
+  };
+
   $("btnMdnsScan").onclick = async () => {
     $("mdnsOut").textContent = "Scanning...";
     let svc = mdnsSel.value === "custom" ? mdnsCust.value : mdnsSel.value;
@@ -434,22 +519,21 @@ window.onload = async () => {
     // Auto-fix common mistakes if user types full string
     if (svc.includes("._tcp")) svc = svc.replace("._tcp", "");
     if (svc.includes("._udp")) svc = svc.replace("._udp", "");
+    const filter = svc === "all" ? "" : `?type=${encodeURIComponent(svc + "._" + proto)}`;
 
     try {
-      await apiPost("/api/mdns/scan", { service: svc, proto: proto });
+      await apiPost("/api/mdns/scan", svc === "all" ? {} : { service: svc, proto: proto });
 
-      // Poll for results (mDNS query runs on background task)
+      // Poll for results (mDNS queries run from the main loop). Cached
+      // entries show straight away and fill in as the refresh lands.
       const interval = setInterval(async () => {
         try {
-          const res = await apiGet("/api/mdns/status");
+          const res = await apiGet("/api/mdns/status" + filter);
+          renderMdns(res);
           if (res.running) {
-            $("mdnsOut").textContent = "Scanning...";
+            $("mdnsOut").innerHTML += `<div class="small">Querying ${res.querying.length} service types...</div>`;
           } else {
             clearInterval(interval);
-            $("mdnsOut").innerHTML = "";
-            (res.results || []).forEach(r => {
-              $("mdnsOut").innerHTML += `<div class="item"><b>${r.hostname}</b> ${r.ip}:${r.port}</div>`;
-            });
             if (!res.results?.length) $("mdnsOut").textContent = "No devices found.";
           }
         } catch (e) { clearInterval(interval); $("mdnsOut").textContent = "Error: " + e; }
@@ -457,7 +541,6 @@ window.onload = async () => {
     } catch (e) { $("mdnsOut").textContent = "Error: " + e.message; }
   };
 
-
   // SSDP
   if ($("btnSsdp")) $("btnSsdp").onclick = async () => {
     $("ssdpOut").textContent = "Sending M-SEARCH...";
@@ -468,13 +551,16 @@ window.onload = async () => {
         try {
           const res = await apiGet("/api/ssdp/status");
           if (res.running) {
-            $("ssdpOut").textContent = `Scanning... Found ${res.results.length} devices...`;
+            $("ssdpOut").textContent = res.fetching
+              ? `Reading ${res.fetching} device descriptions...`
+              : `Scanning... Found ${res.results.length} devices...`;
           } else {
             clearInterval(interval);
             $("ssdpOut").innerHTML = "";
             (res.results || []).forEach(r => {
               $("ssdpOut").innerHTML += `<div class="item">
                   <b>${esc(r.friendlyName || r.ip)}</b> <br>
+                  ${r.manufacturer || r.modelName ? `<span class="small">${esc([r.manufacturer, r.modelName].filter(Boolean).join(" "))}</span> <br>` : ""}
                   <span class="small">${esc(r.usn || r.st)}</span> <br>
                   <a href="${r.url}" target="_blank">${r.url}</a>
                 </div>`;
@@ -545,15 +631,15 @@ window.onload = async () => {
     if (!ip) return alert("IP required");
     $("pjlOut").textContent = `> ${cmd}\nSending...`;
     try {
-      await apiPost("/api/pjlink", { ip, pass: $("pjlPass").value, cmd });
+      const { req } = await apiPost("/api/pjlink", { ip, pass: $("pjlPass").value, cmd });
 
       for (let i = 0; i < 30; i++) {
         await new Promise(r => setTimeout(r, 200));
-        let res = await apiGet("/api/pjlink/status");
-        if (res.status === "done") {
+        let res = await apiGet(`/api/pjlink/status?req=${req}`);
+        if (res.status === "done" || res.status === "error") {
           $("pjlOut").textContent = `> ${cmd}\n< ${res.response}`;
-          return res.response;
-        } else if (res.status === "idle") {
+          return res.status === "done" ? res.response : "ERROR";
+        } else if (res.status === "unknown") {
           return "ERROR";
         }
       }
@@ -573,8 +659,11 @@ window.onload = async () => {
     const ip = $("pjlIp").value;
     if (!ip) return;
 
+    // All four go out on one projector session; the ESP32 queues them.
+    let [pwr, err, inpt, lamp] = await Promise.all(
+      ["%1POWR ?", "%1ERST ?", "%1INPT ?", "%1LAMP ?"].map(sendPjl));
+
     // Power
-    let pwr = await sendPjl("%1POWR ?");
     if (pwr.includes("=0")) $("pjlStatusPwr").textContent = "OFF";
     else if (pwr.includes("=1")) $("pjlStatusPwr").textContent = "ON";
     else if (pwr.includes("=2")) $("pjlStatusPwr").textContent = "COOLING";
@@ -582,7 +671,6 @@ window.onload = async () => {
     else $("pjlStatusPwr").textContent = pwr.replace('%1POWR=', '') || "ERR";
 
     // Errors (Fan, Lamp, Temp, Cover, Filter, Other)
-    let err = await sendPjl("%1ERST ?");
     if (err.includes("=")) {
       let code = err.split("=")[1].trim();
       let hasErr = false;
@@ -594,11 +682,9 @@ window.onload = async () => {
     }
 
     // Input
-    let inpt = await sendPjl("%1INPT ?");
     if (inpt.includes("=")) $("pjlStatusInpt").textContent = inpt.split("=")[1].trim();
 
     // Lamp
-    let lamp = await sendPjl("%1LAMP ?");
     if (lamp.includes("=")) $("pjlStatusLamp").textContent = lamp.split("=")[1].split(" ")[0] + " hrs";
   };
 
@@ -882,7 +968,7 @@ async function loadDashboard() {
 
     // Quick macros on dashboard
     try {
-      const macros = await apiGet("/api/macros");
+      const { macros } = await apiGet("/api/macros");
       const dm = $("dashMacros");
       if (dm) {
         if (macros.length === 0) {
@@ -902,21 +988,29 @@ let macroStepCount = 0;
 
 async function loadMacros() {
   try {
-    const macros = await apiGet("/api/macros");
+    const { macros, runs } = await apiGet("/api/macros");
     const el = $("macroList");
     if (!el) return;
     if (macros.length === 0) {
       el.innerHTML = '<div class="sub">No macros saved. Click "+ New Macro" to create one.</div>';
       return;
     }
+    // runs come newest first
+    const runLabel = (m) => {
+      const r = runs.find(r => r.macroId === m.id);
+      if (!r) return '';
+      if (r.state === 'done') return ` | last run: ${r.failedSteps ? r.failedSteps + ' failed' : 'ok'}, jitter max ${r.jitterMaxMs ?? 0} ms`;
+      return ` | ${r.state} ${r.step}/${r.steps}`;
+    };
     el.innerHTML = macros.map(m => `
       <div class="item" style="display:flex; align-items:center; gap:10px">
         <span style="font-size:24px">${m.icon || '▶'}</span>
         <div style="flex:1">
           <b>${esc(m.name)}</b>
-          <div class="small muted">${m.stepCount} step${m.stepCount !== 1 ? 's' : ''}</div>
+          <div class="small muted">${m.stepCount} step${m.stepCount !== 1 ? 's' : ''}${runLabel(m)}</div>
         </div>
         <button class="btn primary" onclick="runMacro('${m.id}')">Run</button>
+        <button class="btn" onclick="showMacroTrace('${m.id}')">Trace</button>
         <button class="btn" onclick="editMacro('${m.id}')">Edit</button>
         <button class="btn danger" onclick="deleteMacro('${m.id}')">✕</button>
       </div>
@@ -929,6 +1023,7 @@ function openMacroEditor(macro) {
   $("macroEditorTitle").textContent = macro ? "Edit Macro" : "New Macro";
   $("macroName").value = macro ? macro.name : "";
   $("macroIcon").value = macro ? (macro.icon || "▶") : "▶";
+  $("macroSpacing").value = macro?.spacing || "";
   $("macroEditId").value = macro ? macro.id : "";
   $("macroSteps").innerHTML = "";
   macroStepCount = 0;
@@ -969,6 +1064,10 @@ window.addMacroStep = (step) => {
       </select>
       <input class="ms-delay" type="number" placeholder="Delay ms" style="width:80px" value="${step?.delay || step?.delayMs || 500}" />
     </div>
+    <div class="row" style="margin-top:5px">
+      <input class="ms-expect grow" placeholder="TCP: wait for reply (e.g. \\r\\n or >)" value="${esc(step?.expect || '')}" />
+      <input class="ms-timeout" type="number" placeholder="Timeout ms" style="width:100px" value="${step?.timeout || ''}" />
+    </div>
   `;
   $("macroSteps").appendChild(div);
 };
@@ -983,6 +1082,8 @@ function collectMacroSteps() {
       payload: div.querySelector(".ms-payload").value,
       suffix: div.querySelector(".ms-suffix").value,
       delay: parseInt(div.querySelector(".ms-delay").value) || 500,
+      expect: div.querySelector(".ms-expect").value,
+      timeout: parseInt(div.querySelector(".ms-timeout").value) || 0,
       mode: "ascii"
     });
   });
@@ -996,6 +1097,7 @@ async function saveMacro() {
     id: $("macroEditId").value || undefined,
     name,
     icon: $("macroIcon").value || "▶",
+    spacing: parseInt($("macroSpacing").value) || 0,
     steps: collectMacroSteps()
   };
   try {
@@ -1006,10 +1108,41 @@ async function saveMacro() {
   } catch (e) { alert("Error: " + e.message); }
 }
 
+// Trace of a macro's latest run; step rows are appended live from /wsmacro.
+let traceMacroId = null, traceRunId = null;
+
+function traceRow(s) {
+  const late = s.actualMs - s.plannedMs;
+  return `<tr>
+    <td>${s.i + 1}</td><td>${s.type}</td><td>${esc(s.target)}</td>
+    <td>${s.actualMs}</td><td>${late > 0 ? late : 0}</td>
+    <td>${s.type !== 'tcp' ? '' : s.reused ? 'reused' : s.connectMs + ' ms'}</td>
+    <td>${s.bytesSent}</td><td>${s.respBytes ?? ''}</td>
+    <td>${s.respLatencyMs ? s.respLatencyMs + ' ms' : ''}</td>
+    <td>${s.durationMs} ms</td><td>${s.outcome}</td>
+  </tr>`;
+}
+
+window.showMacroTrace = async (id) => {
+  traceMacroId = id;
+  try {
+    const t = await apiGet("/api/macros/trace?id=" + encodeURIComponent(id));
+    traceRunId = t.runId;
+    $("macroTraceTitle").textContent = `Run #${t.runId}: ${t.name} (${t.state}, jitter max ${t.jitterMaxMs ?? 0} ms)`;
+    $("macroTraceRows").innerHTML = t.trace.map(traceRow).join('');
+    $("macroTrace").style.display = "block";
+  } catch (e) {
+    traceRunId = null;
+    alert("No recent run of this macro.");
+  }
+};
+
 async function editMacro(id) {
   try {
     const macro = await apiGet("/api/macros/get?id=" + id);
     openMacroEditor(macro);
+    const errors = macro.plan?.errors || [];
+    if (errors.length) alert("This macro won't run until fixed:\n" + errors.join("\n"));
   } catch (e) { alert("Error: " + e.message); }
 }
 
@@ -0,0 +1,104 @@
+// Throughput of the Utils hex/ASCII encoders against the original
+// char-at-a-time String versions. Standalone; host/README.md has the
+// command that builds and runs it.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <vector>
+
+#include "Utils.h"
+
+// Utils.cpp's genId() needs this; HostCore.cpp (and its main) isn't linked.
+uint32_t esp_random() { return 4; }
+
+static String legacyHex(const uint8_t *data, size_t len) {
+  static const char *h = "0123456789ABCDEF";
+  String out;
+  out.reserve(len * 3);
+  for (size_t i = 0; i < len; i++) {
+    out += h[(data[i] >> 4) & 0xF];
+    out += h[data[i] & 0xF];
+    if (i + 1 < len)
+      out += ' ';
+  }
+  return out;
+}
+
+static String legacyAscii(const uint8_t *data, size_t len) {
+  String out;
+  out.reserve(len);
+  for (size_t i = 0; i < len; i++) {
+    char c = (char)data[i];
+    out += (c >= 32 && c <= 126) ? c : '.';
+  }
+  return out;
+}
+
+static volatile size_t sink;
+
+// Returns MB/s of input consumed by fn over roughly 200 ms.
+template <typename F> static double run(size_t len, F fn) {
+  using clock = std::chrono::steady_clock;
+  size_t bytes = 0;
+  auto start = clock::now();
+  double secs = 0;
+  do {
+    for (int i = 0; i < 256; i++) {
+      sink = sink + fn();
+      bytes += len;
+    }
+    secs = std::chrono::duration<double>(clock::now() - start).count();
+  } while (secs < 0.2);
+  return bytes / secs / 1e6;
+}
+
+int main() {
+  // Mostly-printable traffic with control bytes mixed in, like device
+  // responses.
+  std::vector<uint8_t> data(2048);
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = (i % 17 == 16) ? '\r' : (uint8_t)(32 + (i * 7) % 95);
+
+  // Check the new kernels against the old ones before timing them.
+  for (size_t len = 0; len <= 1100; len++) {
+    if (bytesToHex(data.data(), len) != legacyHex(data.data(), len) ||
+        bytesToAscii(data.data(), len) != legacyAscii(data.data(), len)) {
+      printf("mismatch at len %zu\n", len);
+      return 1;
+    }
+  }
+  std::vector<uint8_t> all(256);
+  for (size_t i = 0; i < all.size(); i++)
+    all[i] = (uint8_t)i;
+  if (bytesToHex(all.data(), 256) != legacyHex(all.data(), 256) ||
+      bytesToAscii(all.data(), 256) != legacyAscii(all.data(), 256)) {
+    printf("mismatch on 0x00..0xFF\n");
+    return 1;
+  }
+
+  static char buf[2048 * 3];
+  printf("%-6s %-14s %10s %10s %8s\n", "size", "encoder", "before", "after",
+         "speedup");
+  for (size_t len : {16, 256, 2048}) {
+    const uint8_t *d = data.data();
+    double hexOld = run(len, [&] { return legacyHex(d, len).length(); });
+    double hexStr = run(len, [&] { return bytesToHex(d, len).length(); });
+    double hexBuf =
+        run(len, [&] { return bytesToHex(d, len, buf, sizeof(buf)); });
+    double ascOld = run(len, [&] { return legacyAscii(d, len).length(); });
+    double ascStr = run(len, [&] { return bytesToAscii(d, len).length(); });
+    double ascBuf =
+        run(len, [&] { return bytesToAscii(d, len, buf, sizeof(buf)); });
+    printf("%-6zu %-14s %10.1f %10.1f %7.1fx\n", len, "hex String", hexOld,
+           hexStr, hexStr / hexOld);
+    printf("%-6zu %-14s %10.1f %10.1f %7.1fx\n", len, "hex buffer", hexOld,
+           hexBuf, hexBuf / hexOld);
+    printf("%-6zu %-14s %10.1f %10.1f %7.1fx\n", len, "ascii String", ascOld,
+           ascStr, ascStr / ascOld);
+    printf("%-6zu %-14s %10.1f %10.1f %7.1fx\n", len, "ascii buffer", ascOld,
+           ascBuf, ascBuf / ascOld);
+  }
+  printf("(MB/s of input)\n");
+  return 0;
+}
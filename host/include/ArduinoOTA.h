@@ -0,0 +1,18 @@
+#pragma once
+
+// Espota push updates have no meaning on the host; the object exists so
+// main.cpp compiles unchanged.
+
+#include <Arduino.h>
+
+class ArduinoOTAClass {
+public:
+  ArduinoOTAClass &setHostname(const char *) { return *this; }
+  ArduinoOTAClass &setPassword(const char *) { return *this; }
+  ArduinoOTAClass &setPort(uint16_t) { return *this; }
+  void begin() {}
+  void end() {}
+  void handle() {}
+};
+
+extern ArduinoOTAClass ArduinoOTA;
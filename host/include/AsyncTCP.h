@@ -0,0 +1,167 @@
+#pragma once
+
+// Host build of AsyncTCP. A single "async_tcp" thread polls every async socket
+// and runs callbacks with hostAsyncLock() held, matching the one-task
+// callback model of the ESP32 library. Clients are never deleted by the
+// library: the owner deletes them (typically from onDisconnect).
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+
+#define ASYNC_MAX_ACK_TIME 5000
+#define ASYNC_WRITE_FLAG_COPY 0x01
+#define ASYNC_WRITE_FLAG_MORE 0x02
+
+// lwIP error codes surfaced through onError.
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_TIMEOUT -3
+#define ERR_ABRT -13
+#define ERR_RST -14
+#define ERR_CLSD -15
+#define ERR_CONN -11
+
+class AsyncClient;
+class AsyncServer;
+
+typedef std::function<void(void *, AsyncClient *)> AcConnectHandler;
+typedef std::function<void(void *, AsyncClient *, size_t len, uint32_t time)>
+    AcAckHandler;
+typedef std::function<void(void *, AsyncClient *, int8_t error)>
+    AcErrorHandler;
+typedef std::function<void(void *, AsyncClient *, void *data, size_t len)>
+    AcDataHandler;
+typedef std::function<void(void *, AsyncClient *, uint32_t time)>
+    AcTimeoutHandler;
+
+class AsyncClient {
+public:
+  AsyncClient();
+  ~AsyncClient();
+
+  bool connect(IPAddress ip, uint16_t port);
+  bool connect(const char *host, uint16_t port);
+  void close(bool now = false);
+  void stop() { close(false); }
+  int8_t abort();
+  bool free();
+
+  bool canSend();
+  size_t space();
+  size_t add(const char *data, size_t size,
+             uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+  bool send();
+  size_t write(const char *data);
+  size_t write(const char *data, size_t size,
+               uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+
+  uint8_t state() const { return (uint8_t)_state; }
+  bool connecting() const { return _state == Connecting; }
+  bool connected() const { return _state == Connected; }
+  bool disconnecting() const { return _state == Closing; }
+  bool disconnected() const { return _state == Idle; }
+  bool freeable() const { return _state == Idle; }
+
+  void setRxTimeout(uint32_t timeoutSec) { _rxTimeoutSec = timeoutSec; }
+  uint32_t getRxTimeout() const { return _rxTimeoutSec; }
+  void setAckTimeout(uint32_t timeoutMs) { _ackTimeoutMs = timeoutMs; }
+  uint32_t getAckTimeout() const { return _ackTimeoutMs; }
+  void setNoDelay(bool nodelay);
+  bool getNoDelay();
+
+  IPAddress remoteIP() const { return _remoteIp; }
+  uint16_t remotePort() const { return _remotePort; }
+  IPAddress localIP() const { return _localIp; }
+  uint16_t localPort() const { return _localPort; }
+
+  void onConnect(AcConnectHandler cb, void *arg = nullptr);
+  void onDisconnect(AcConnectHandler cb, void *arg = nullptr);
+  void onAck(AcAckHandler cb, void *arg = nullptr);
+  void onError(AcErrorHandler cb, void *arg = nullptr);
+  void onData(AcDataHandler cb, void *arg = nullptr);
+  void onTimeout(AcTimeoutHandler cb, void *arg = nullptr);
+  void onPoll(AcConnectHandler cb, void *arg = nullptr);
+
+  static const char *errorToString(int8_t error);
+
+  // Host internals (used by the event loop and AsyncServer).
+  enum State { Idle, Connecting, Connected, Closing };
+  explicit AsyncClient(int fd);
+  uint64_t hostId() const { return _id; }
+  int hostFd() const { return _fd; }
+  bool hostWantsWrite() const {
+    return _state == Connecting || !_out.empty();
+  }
+  bool hostWantsRead() const {
+    return _state == Connected || _state == Closing;
+  }
+  void hostOnReadable();
+  void hostOnWritable();
+  void hostOnPollTick(uint32_t now);
+
+private:
+  friend class AsyncServer;
+  void cacheAddresses();
+  void finishConnect();
+  void fail(int8_t err);
+  void teardown(bool notify);
+
+  uint64_t _id;
+  int _fd = -1;
+  State _state = Idle;
+  std::string _out;
+  IPAddress _remoteIp;
+  uint16_t _remotePort = 0;
+  IPAddress _localIp;
+  uint16_t _localPort = 0;
+  uint32_t _rxTimeoutSec = 0;
+  uint32_t _ackTimeoutMs = ASYNC_MAX_ACK_TIME;
+  uint32_t _lastRx = 0;
+  uint32_t _lastPoll = 0;
+  uint32_t _writeStart = 0;
+
+  AcConnectHandler _connectCb;
+  void *_connectArg = nullptr;
+  AcConnectHandler _discardCb;
+  void *_discardArg = nullptr;
+  AcAckHandler _ackCb;
+  void *_ackArg = nullptr;
+  AcErrorHandler _errorCb;
+  void *_errorArg = nullptr;
+  AcDataHandler _recvCb;
+  void *_recvArg = nullptr;
+  AcTimeoutHandler _timeoutCb;
+  void *_timeoutArg = nullptr;
+  AcConnectHandler _pollCb;
+  void *_pollArg = nullptr;
+};
+
+class AsyncServer {
+public:
+  explicit AsyncServer(uint16_t port);
+  AsyncServer(IPAddress addr, uint16_t port);
+  ~AsyncServer();
+
+  void onClient(AcConnectHandler cb, void *arg);
+  void begin();
+  void end();
+  void setNoDelay(bool nodelay) { _noDelay = nodelay; }
+  bool getNoDelay() const { return _noDelay; }
+  uint8_t status() const { return _fd >= 0 ? 1 : 0; }
+  uint16_t port() const { return _port; }
+
+  // Host internals.
+  uint64_t hostId() const { return _id; }
+  int hostFd() const { return _fd; }
+  void hostOnAcceptable();
+
+private:
+  uint64_t _id;
+  int _fd = -1;
+  IPAddress _addr;
+  uint16_t _port;
+  bool _noDelay = false;
+  AcConnectHandler _connectCb;
+  void *_connectArg = nullptr;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+// ICMP echo via an unprivileged datagram socket (needs
+// net.ipv4.ping_group_range to include the user; otherwise pings fail).
+
+#include <Arduino.h>
+
+class PingClass {
+public:
+  bool ping(IPAddress dest, byte count = 5);
+  bool ping(const char *host, byte count = 5);
+  float averageTime() const { return _avgMs; }
+
+private:
+  float _avgMs = 0;
+};
+
+extern PingClass Ping;
@@ -0,0 +1,555 @@
+#pragma once
+
+// Host build of ESPAsyncWebServer (HTTP/1.1 + RFC 6455 WebSocket) on top of
+// the host AsyncTCP. Routing, static file lookup (including ".gz"
+// variants), 304 handling and the one-response-per-connection model follow
+// the ESP32 library so handler behaviour matches the board.
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <FS.h>
+#include <WiFi.h>
+#include <deque>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#define DEFAULT_MAX_WS_CLIENTS 8
+#define WS_MAX_QUEUED_MESSAGES 32
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncResponseStream;
+class AsyncWebSocket;
+class AsyncWebHandler;
+
+class AsyncWebParameter {
+public:
+  AsyncWebParameter(const String &name, const String &value, bool form = false,
+                    bool file = false, size_t size = 0)
+      : _name(name), _value(value), _size(size), _isForm(form),
+        _isFile(file) {}
+  const String &name() const { return _name; }
+  const String &value() const { return _value; }
+  size_t size() const { return _size; }
+  bool isPost() const { return _isForm; }
+  bool isFile() const { return _isFile; }
+
+private:
+  String _name;
+  String _value;
+  size_t _size;
+  bool _isForm;
+  bool _isFile;
+};
+
+class AsyncWebHeader {
+public:
+  AsyncWebHeader(const String &name, const String &value)
+      : _name(name), _value(value) {}
+  const String &name() const { return _name; }
+  const String &value() const { return _value; }
+  String toString() const { return _name + ": " + _value + "\r\n"; }
+
+private:
+  String _name;
+  String _value;
+};
+
+typedef std::function<void(AsyncWebServerRequest *request)>
+    ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request,
+                           const String &filename, size_t index, uint8_t *data,
+                           size_t len, bool final)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data,
+                           size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest *request)>
+    ArRequestFilterFunction;
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)>
+    AwsResponseFiller;
+
+// ── Responses ──
+
+class AsyncWebServerResponse {
+public:
+  AsyncWebServerResponse() = default;
+  virtual ~AsyncWebServerResponse() = default;
+  void setCode(int code) { _code = code; }
+  int code() const { return _code; }
+  void setContentLength(size_t len) { _contentLength = len; }
+  void setContentType(const String &type) { _contentType = type; }
+  void addHeader(const String &name, const String &value) {
+    _headers.emplace_back(name, value);
+  }
+
+  // Host: materialise the body. Returns false for chunked bodies.
+  virtual void hostBody(std::string &out) = 0;
+  virtual bool hostChunked() const { return false; }
+  std::string hostAssemble(bool headOnly);
+
+protected:
+  int _code = 200;
+  String _contentType;
+  size_t _contentLength = (size_t)-1;
+  std::vector<AsyncWebHeader> _headers;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+public:
+  AsyncBasicResponse(int code, const String &contentType = String(),
+                     const String &content = String());
+  void hostBody(std::string &out) override { out = _content.str(); }
+
+private:
+  String _content;
+};
+
+class AsyncProgmemResponse : public AsyncWebServerResponse {
+public:
+  AsyncProgmemResponse(int code, const String &contentType,
+                       const uint8_t *content, size_t len);
+  void hostBody(std::string &out) override {
+    out.assign((const char *)_content, _len);
+  }
+
+private:
+  const uint8_t *_content;
+  size_t _len;
+};
+
+class AsyncFileResponse : public AsyncWebServerResponse {
+public:
+  AsyncFileResponse(fs::FS &fs, const String &path,
+                    const String &contentType = String(),
+                    bool download = false);
+  void hostBody(std::string &out) override { out = _data; }
+  bool found() const { return _found; }
+
+private:
+  std::string _data;
+  bool _found = false;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse {
+public:
+  AsyncChunkedResponse(const String &contentType, AwsResponseFiller callback);
+  void hostBody(std::string &out) override;
+  bool hostChunked() const override { return true; }
+
+private:
+  AwsResponseFiller _filler;
+};
+
+class AsyncCallbackResponse : public AsyncWebServerResponse {
+public:
+  AsyncCallbackResponse(const String &contentType, size_t len,
+                        AwsResponseFiller callback);
+  void hostBody(std::string &out) override;
+
+private:
+  AwsResponseFiller _filler;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+  AsyncResponseStream(const String &contentType, size_t bufferSize);
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t *data, size_t len) override;
+  using Print::write;
+  size_t available() const { return _content.size(); }
+  void hostBody(std::string &out) override { out.swap(_content); }
+
+private:
+  std::string _content;
+};
+
+// ── Requests ──
+
+class AsyncWebServerRequest {
+public:
+  AsyncWebServerRequest(AsyncWebServer *server, AsyncClient *client);
+  ~AsyncWebServerRequest();
+
+  AsyncClient *client() { return _client; }
+  uint8_t version() const { return _version; }
+  WebRequestMethodComposite method() const { return _method; }
+  const String &url() const { return _url; }
+  const String &host() const { return _host; }
+  const String &contentType() const { return _contentType; }
+  size_t contentLength() const { return _contentLength; }
+  const char *methodToString() const;
+
+  void send(AsyncWebServerResponse *response);
+  void send(int code, const String &contentType = String(),
+            const String &content = String());
+  void send(fs::FS &fs, const String &path,
+            const String &contentType = String(), bool download = false);
+  void send(const String &contentType, size_t len, AwsResponseFiller callback);
+  void sendChunked(const String &contentType, AwsResponseFiller callback);
+  void redirect(const String &url);
+
+  AsyncWebServerResponse *beginResponse(int code,
+                                        const String &contentType = String(),
+                                        const String &content = String());
+  AsyncWebServerResponse *beginResponse(fs::FS &fs, const String &path,
+                                        const String &contentType = String(),
+                                        bool download = false);
+  AsyncWebServerResponse *beginResponse(const String &contentType, size_t len,
+                                        AwsResponseFiller callback);
+  AsyncWebServerResponse *beginResponse_P(int code, const String &contentType,
+                                          const uint8_t *content, size_t len);
+  AsyncWebServerResponse *beginChunkedResponse(const String &contentType,
+                                               AwsResponseFiller callback);
+  AsyncResponseStream *beginResponseStream(const String &contentType,
+                                           size_t bufferSize = 1460);
+
+  size_t headers() const { return _headerList.size(); }
+  bool hasHeader(const String &name) const;
+  AsyncWebHeader *getHeader(const String &name) const;
+  AsyncWebHeader *getHeader(size_t num) const;
+  String header(const char *name) const;
+
+  size_t params() const { return _params.size(); }
+  bool hasParam(const String &name, bool post = false,
+                bool file = false) const;
+  AsyncWebParameter *getParam(const String &name, bool post = false,
+                              bool file = false) const;
+  AsyncWebParameter *getParam(size_t num) const;
+  size_t args() const { return params(); }
+  String arg(const String &name) const;
+  bool hasArg(const char *name) const;
+
+  void *_tempObject = nullptr;
+
+  // Host internals.
+  void hostOnData(const uint8_t *data, size_t len);
+  bool hostSent() const { return _sent; }
+  void hostDetachClient() { _client = nullptr; }
+  const std::string &hostBody() const { return _body; }
+
+private:
+  bool parseHead();
+  void parseQuery(const String &query, bool post);
+  void parseMultipart();
+  void dispatch();
+
+  AsyncWebServer *_server;
+  AsyncClient *_client;
+  std::string _rx;
+  std::string _body;
+  bool _headDone = false;
+  bool _dispatched = false;
+  bool _sent = false;
+  uint8_t _version = 1;
+  WebRequestMethodComposite _method = HTTP_GET;
+  String _url;
+  String _host;
+  String _contentType;
+  size_t _contentLength = 0;
+  String _boundary;
+  std::vector<AsyncWebHeader *> _headerList;
+  std::vector<AsyncWebParameter *> _params;
+  AsyncWebHandler *_handler = nullptr;
+};
+
+// ── Handlers ──
+
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() = default;
+  AsyncWebHandler &setFilter(ArRequestFilterFunction fn) {
+    _filter = fn;
+    return *this;
+  }
+  bool filter(AsyncWebServerRequest *request) {
+    return !_filter || _filter(request);
+  }
+  virtual bool canHandle(AsyncWebServerRequest *) { return false; }
+  virtual void handleRequest(AsyncWebServerRequest *) {}
+  virtual void handleUpload(AsyncWebServerRequest *, const String &, size_t,
+                            uint8_t *, size_t, bool) {}
+  virtual void handleBody(AsyncWebServerRequest *, uint8_t *, size_t, size_t,
+                          size_t) {}
+  virtual bool isRequestHandlerTrivial() { return true; }
+
+protected:
+  ArRequestFilterFunction _filter;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+  void setUri(const String &uri) { _uri = uri; }
+  void setMethod(WebRequestMethodComposite method) { _method = method; }
+  void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+  void onUpload(ArUploadHandlerFunction fn) { _onUpload = fn; }
+  void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+  void handleUpload(AsyncWebServerRequest *request, const String &filename,
+                    size_t index, uint8_t *data, size_t len,
+                    bool final) override;
+  void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len,
+                  size_t index, size_t total) override;
+  bool isRequestHandlerTrivial() override { return !_onRequest; }
+
+private:
+  String _uri;
+  WebRequestMethodComposite _method = HTTP_ANY;
+  ArRequestHandlerFunction _onRequest;
+  ArUploadHandlerFunction _onUpload;
+  ArBodyHandlerFunction _onBody;
+};
+
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+  AsyncStaticWebHandler(const char *uri, fs::FS &fs, const char *path,
+                        const char *cacheControl);
+  AsyncStaticWebHandler &setIsDir(bool isDir) {
+    _isDir = isDir;
+    return *this;
+  }
+  AsyncStaticWebHandler &setDefaultFile(const char *filename) {
+    _defaultFile = filename;
+    return *this;
+  }
+  AsyncStaticWebHandler &setCacheControl(const char *cacheControl) {
+    _cacheControl = cacheControl;
+    return *this;
+  }
+  AsyncStaticWebHandler &setLastModified(const char *lastModified) {
+    _lastModified = lastModified;
+    return *this;
+  }
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+private:
+  bool getFile(AsyncWebServerRequest *request, String &outPath);
+  bool fileExists(const String &path, String &outPath);
+
+  String _uri;
+  String _path;
+  String _defaultFile = "index.htm";
+  String _cacheControl;
+  String _lastModified;
+  fs::FS &_fs;
+  bool _isDir;
+};
+
+// ── WebSocket ──
+
+typedef enum {
+  WS_EVT_CONNECT,
+  WS_EVT_DISCONNECT,
+  WS_EVT_PONG,
+  WS_EVT_ERROR,
+  WS_EVT_DATA
+} AwsEventType;
+
+typedef enum {
+  WS_DISCONNECTED,
+  WS_CONNECTED,
+  WS_DISCONNECTING
+} AwsClientStatus;
+
+typedef enum {
+  WS_CONTINUATION,
+  WS_TEXT,
+  WS_BINARY,
+  WS_DISCONNECT = 0x08,
+  WS_PING,
+  WS_PONG
+} AwsFrameType;
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocketClient {
+public:
+  AsyncWebSocketClient(AsyncClient *client, AsyncWebSocket *server,
+                       uint32_t id);
+  ~AsyncWebSocketClient();
+
+  uint32_t id() const { return _id; }
+  IPAddress remoteIP() const { return _remoteIp; }
+  uint16_t remotePort() const { return _remotePort; }
+  AwsClientStatus status() const { return _status; }
+  AsyncClient *client() { return _client; }
+  AsyncWebSocket *server() { return _server; }
+
+  void close(uint16_t code = 0, const char *message = nullptr);
+  void ping(const uint8_t *data = nullptr, size_t len = 0);
+  void keepAlivePeriod(uint16_t seconds) { _keepAlivePeriod = seconds; }
+  uint16_t keepAlivePeriod() const { return _keepAlivePeriod; }
+
+  bool queueIsFull() const;
+  size_t queueLen() const;
+  bool canSend() const { return !queueIsFull(); }
+
+  void text(const char *message, size_t len);
+  void text(const char *message);
+  void text(const String &message);
+  void binary(const uint8_t *message, size_t len);
+  void binary(const char *message, size_t len) {
+    binary((const uint8_t *)message, len);
+  }
+  void binary(const String &message) {
+    binary((const uint8_t *)message.c_str(), message.length());
+  }
+
+  // Host internals.
+  void hostOnData(const uint8_t *data, size_t len);
+  void hostOnAck(size_t len);
+  void hostOnDisconnect();
+
+private:
+  bool queueFrame(uint8_t opcode, const uint8_t *data, size_t len,
+                  bool control);
+
+  AsyncClient *_client;
+  AsyncWebSocket *_server;
+  uint32_t _id;
+  AwsClientStatus _status = WS_CONNECTED;
+  IPAddress _remoteIp;
+  uint16_t _remotePort;
+  uint16_t _keepAlivePeriod = 0;
+  std::string _rx;
+  std::deque<size_t> _inflight;
+  uint8_t _lastMessageOpcode = WS_TEXT;
+  uint32_t _fragment = 0;
+};
+
+typedef std::function<void(AsyncWebSocket *server, AsyncWebSocketClient *client,
+                           AwsEventType type, void *arg, uint8_t *data,
+                           size_t len)>
+    AwsEventHandler;
+
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+  explicit AsyncWebSocket(const String &url);
+  ~AsyncWebSocket() override;
+
+  const char *url() const { return _url.c_str(); }
+  void enable(bool e) { _enabled = e; }
+  bool enabled() const { return _enabled; }
+  bool availableForWriteAll();
+  bool availableForWrite(uint32_t id);
+
+  size_t count() const;
+  AsyncWebSocketClient *client(uint32_t id);
+  bool hasClient(uint32_t id) { return client(id) != nullptr; }
+
+  void close(uint32_t id, uint16_t code = 0, const char *message = nullptr);
+  void closeAll(uint16_t code = 0, const char *message = nullptr);
+  void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+
+  void ping(uint32_t id, const uint8_t *data = nullptr, size_t len = 0);
+  void pingAll(const uint8_t *data = nullptr, size_t len = 0);
+
+  void text(uint32_t id, const char *message, size_t len);
+  void text(uint32_t id, const char *message);
+  void text(uint32_t id, const String &message);
+  void textAll(const char *message, size_t len);
+  void textAll(const char *message);
+  void textAll(const String &message);
+  void binary(uint32_t id, const uint8_t *message, size_t len);
+  void binaryAll(const uint8_t *message, size_t len);
+  void binaryAll(const char *message, size_t len) {
+    binaryAll((const uint8_t *)message, len);
+  }
+  void binaryAll(const String &message) {
+    binaryAll((const uint8_t *)message.c_str(), message.length());
+  }
+
+  void onEvent(AwsEventHandler handler) { _eventHandler = handler; }
+
+  const std::list<AsyncWebSocketClient> &getClients() const {
+    return _clients;
+  }
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+  // Host internals.
+  void hostHandleEvent(AsyncWebSocketClient *client, AwsEventType type,
+                       void *arg, uint8_t *data, size_t len);
+
+private:
+  String _url;
+  bool _enabled = true;
+  uint32_t _nextId = 1;
+  std::list<AsyncWebSocketClient> _clients;
+  AwsEventHandler _eventHandler;
+};
+
+// ── Server ──
+
+class AsyncWebServer {
+public:
+  explicit AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+
+  void begin();
+  void end();
+
+  AsyncWebHandler &addHandler(AsyncWebHandler *handler);
+  bool removeHandler(AsyncWebHandler *handler);
+
+  AsyncCallbackWebHandler &on(const char *uri,
+                              ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler &on(const char *uri,
+                              WebRequestMethodComposite method,
+                              ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler &on(const char *uri,
+                              WebRequestMethodComposite method,
+                              ArRequestHandlerFunction onRequest,
+                              ArUploadHandlerFunction onUpload);
+  AsyncCallbackWebHandler &on(const char *uri,
+                              WebRequestMethodComposite method,
+                              ArRequestHandlerFunction onRequest,
+                              ArUploadHandlerFunction onUpload,
+                              ArBodyHandlerFunction onBody);
+
+  AsyncStaticWebHandler &serveStatic(const char *uri, fs::FS &fs,
+                                     const char *path,
+                                     const char *cacheControl = nullptr);
+
+  void onNotFound(ArRequestHandlerFunction fn) { _notFound = fn; }
+  void reset();
+
+  // Host internals.
+  AsyncWebHandler *hostFindHandler(AsyncWebServerRequest *request);
+  void hostNotFound(AsyncWebServerRequest *request);
+
+private:
+  AsyncServer _server;
+  std::vector<AsyncWebHandler *> _handlers;
+  std::vector<AsyncWebHandler *> _owned;
+  ArRequestHandlerFunction _notFound;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// Responder stub: the host advertises nothing (the OS resolver owns 5353).
+
+#include <Arduino.h>
+
+class MDNSResponder {
+public:
+  bool begin(const char *hostName) { return hostName && *hostName; }
+  void end() {}
+  bool addService(const char *, const char *, uint16_t) { return true; }
+  bool addService(const String &, const String &, uint16_t) { return true; }
+  void setInstanceName(const String &) {}
+};
+
+extern MDNSResponder MDNS;
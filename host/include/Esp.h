@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getHeapSize();
+  uint32_t getMaxAllocHeap();
+  uint8_t getChipRevision() { return 3; }
+  const char *getChipModel() { return "ESP32-HOST"; }
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint64_t getEfuseMac();
+  const char *getSdkVersion() { return "host"; }
+  [[noreturn]] void restart();
+};
+
+extern EspClass ESP;
+
+uint32_t esp_random();
+void esp_fill_random(void *buf, size_t len);
+int64_t esp_timer_get_time();
@@ -0,0 +1,77 @@
+#pragma once
+
+// Host build of the Arduino FS layer: a directory on disk stands in for the
+// flash partition.
+
+#include <Arduino.h>
+#include <cstdio>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+public:
+  File() = default;
+  File(FILE *fp, const String &path, const String &name, bool dir);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+  size_t read(uint8_t *buf, size_t size);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  operator bool() const { return _h && (_h->fp || _h->dir); }
+  const char *path() const { return _h ? _h->path.c_str() : ""; }
+  const char *name() const { return _h ? _h->name.c_str() : ""; }
+  bool isDirectory() const { return _h && _h->dir; }
+
+private:
+  struct Handle {
+    FILE *fp = nullptr;
+    String path;
+    String name;
+    bool dir = false;
+    ~Handle();
+  };
+  std::shared_ptr<Handle> _h;
+};
+
+class FS {
+public:
+  explicit FS(const char *root) : _root(root) {}
+  File open(const String &path, const char *mode = FILE_READ,
+            bool create = false);
+  bool exists(const String &path);
+  bool remove(const String &path);
+  bool rename(const String &from, const String &to);
+  bool mkdir(const String &path);
+  bool rmdir(const String &path);
+
+  // Host: absolute on-disk location of a firmware path.
+  String hostPath(const String &path) const;
+  void hostSetRoot(const String &root) { _root = root; }
+
+protected:
+  String _root;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
@@ -0,0 +1,38 @@
+#pragma once
+
+// Minimal HTTPClient: requests go through the supplied WiFiClient. Over
+// WiFiClientSecure (the only use in the firmware) connect fails, so GET
+// returns HTTPC_ERROR_CONNECTION_REFUSED.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+typedef enum {
+  HTTPC_DISABLE_FOLLOW_REDIRECTS,
+  HTTPC_STRICT_FOLLOW_REDIRECTS,
+  HTTPC_FORCE_FOLLOW_REDIRECTS
+} followRedirects_t;
+
+class HTTPClient {
+public:
+  bool begin(WiFiClient &client, const String &url);
+  void end();
+  void setTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+  void setFollowRedirects(followRedirects_t follow) { (void)follow; }
+  int GET();
+  String getString() { return _payload; }
+  int getSize() const { return (int)_payload.length(); }
+  static String errorToString(int error);
+
+private:
+  WiFiClient *_client = nullptr;
+  String _host;
+  String _path;
+  uint16_t _port = 80;
+  uint16_t _timeoutMs = 5000;
+  String _payload;
+};
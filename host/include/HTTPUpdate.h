@@ -0,0 +1,36 @@
+#pragma once
+
+// Pull OTA stub: updates always fail (see WiFiClientSecure.h).
+
+#include <HTTPClient.h>
+#include <Update.h>
+
+enum HTTPUpdateResult {
+  HTTP_UPDATE_FAILED,
+  HTTP_UPDATE_NO_UPDATES,
+  HTTP_UPDATE_OK
+};
+typedef HTTPUpdateResult t_httpUpdate_return;
+
+class HTTPUpdate {
+public:
+  void rebootOnUpdate(bool reboot) { (void)reboot; }
+  void setFollowRedirects(followRedirects_t follow) { (void)follow; }
+  t_httpUpdate_return update(WiFiClient &client, const String &url,
+                             int command = U_FLASH) {
+    HTTPClient http;
+    http.begin(client, url);
+    int code = http.GET();
+    http.end();
+    (void)command;
+    _lastError = code < 0 ? HTTPClient::errorToString(code)
+                          : "Not supported on host";
+    return HTTP_UPDATE_FAILED;
+  }
+  String getLastErrorString() { return _lastError; }
+
+private:
+  String _lastError;
+};
+
+extern HTTPUpdate httpUpdate;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Stream.h"
+#include <cstdint>
+#include <functional>
+
+#define SERIAL_8N1 0x800001c
+
+typedef enum {
+  UART_NO_ERROR,
+  UART_BREAK_ERROR,
+  UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR,
+  UART_FRAME_ERROR,
+  UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+typedef std::function<void(void)> OnReceiveCb;
+typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
+// Serial (UART0) maps to stdout. Serial2 is backed by a pseudo-terminal so a
+// real program (screen, socat, a device simulator) can sit on the other end;
+// its path is printed on begin() and optionally symlinked to
+// $AVTOOL_SERIAL2_LINK.
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int uartNum) : _uartNum(uartNum) {}
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1,
+             int8_t rxPin = -1, int8_t txPin = -1, bool invert = false,
+             unsigned long timeoutMs = 20000UL);
+  void end();
+  size_t setRxBufferSize(size_t size);
+  size_t setTxBufferSize(size_t size);
+  uint32_t baudRate() const { return _baud; }
+  void updateBaudRate(unsigned long baud);
+
+  // As on the ESP32 core these run on a per-port event thread: onReceive
+  // when RX data arrives, onReceiveError with UART_BUFFER_FULL_ERROR when
+  // more than the RX buffer size is waiting unread.
+  void onReceive(OnReceiveCb function, bool onlyOnTimeout = false);
+  void onReceiveError(OnReceiveErrorCb function);
+
+  int available() override;
+  int availableForWrite();
+  int peek() override;
+  int read() override;
+  size_t read(uint8_t *buffer, size_t size);
+  size_t read(char *buffer, size_t size) {
+    return read((uint8_t *)buffer, size);
+  }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  void flush() override;
+  operator bool() const { return _fd >= 0; }
+
+  // Host only: file descriptor (pty master for Serial2, -1 for Serial RX).
+  int fd() const { return _fd; }
+  const char *ptyPath() const { return _ptyPath; }
+
+private:
+  void openPty();
+  void startEventThread();
+  int _uartNum;
+  int _fd = -1;
+  int _peek = -1;
+  uint32_t _baud = 0;
+  size_t _rxBufferSize = 256;
+  char _ptyPath[64] = {0};
+  OnReceiveCb _onReceive;
+  OnReceiveErrorCb _onReceiveError;
+  bool _eventThread = false;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
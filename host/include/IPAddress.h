@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Print.h"
+#include "WString.h"
+#include <cstdint>
+
+// IPv4 address stored in network byte order, matching the ESP32 core so that
+// lwIP structs (ip4_addr_t::addr) convert to and from it unchanged.
+class IPAddress {
+public:
+  IPAddress() = default;
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    _bytes[0] = a;
+    _bytes[1] = b;
+    _bytes[2] = c;
+    _bytes[3] = d;
+  }
+  IPAddress(uint32_t address) { *this = address; }
+  IPAddress(const uint8_t *address) {
+    for (int i = 0; i < 4; i++)
+      _bytes[i] = address[i];
+  }
+
+  bool fromString(const char *address);
+  bool fromString(const String &address) { return fromString(address.c_str()); }
+
+  operator uint32_t() const;
+  bool operator==(const IPAddress &addr) const {
+    return (uint32_t) * this == (uint32_t)addr;
+  }
+  bool operator!=(const IPAddress &addr) const { return !(*this == addr); }
+  bool operator==(const uint8_t *addr) const;
+
+  uint8_t operator[](int index) const { return _bytes[index & 3]; }
+  uint8_t &operator[](int index) { return _bytes[index & 3]; }
+
+  IPAddress &operator=(uint32_t address);
+  IPAddress &operator=(const uint8_t *address) {
+    *this = IPAddress(address);
+    return *this;
+  }
+
+  String toString() const;
+  size_t printTo(Print &p) const { return p.print(toString()); }
+
+private:
+  uint8_t _bytes[4] = {0, 0, 0, 0};
+};
+
+extern const IPAddress INADDR_NONE_IP;
@@ -0,0 +1,23 @@
+#pragma once
+
+// Host LittleFS: rooted at $AVTOOL_FS_ROOT (default "data", i.e. the same
+// directory `pio run -t uploadfs` would flash).
+
+#include <FS.h>
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+  LittleFSFS();
+  bool begin(bool formatOnFail = false, const char *basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char *partitionLabel = nullptr);
+  void end() {}
+  bool format();
+  size_t totalBytes();
+  size_t usedBytes();
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
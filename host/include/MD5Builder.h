@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+
+class MD5Builder {
+public:
+  void begin();
+  void add(const uint8_t *data, size_t len);
+  void add(const char *data) { add((const uint8_t *)data, strlen(data)); }
+  void add(const String &data) {
+    add((const uint8_t *)data.c_str(), data.length());
+  }
+  void addHexString(const char *data);
+  void addHexString(const String &data) { addHexString(data.c_str()); }
+  void calculate();
+  void getBytes(uint8_t *output) const { memcpy(output, _digest, 16); }
+  void getChars(char *output) const;
+  String toString() const;
+
+private:
+  void block(const uint8_t *p);
+
+  uint32_t _state[4];
+  uint64_t _bytes = 0;
+  uint8_t _buf[64];
+  size_t _bufLen = 0;
+  uint8_t _digest[16];
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+// Host NVS: one file per key under $AVTOOL_NVS_DIR/<namespace>/ (default
+// ".host_nvs"), so settings survive restarts like flash does.
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false,
+             const char *partitionLabel = nullptr);
+  void end();
+  bool clear();
+  bool remove(const char *key);
+  bool isKey(const char *key);
+
+  size_t putString(const char *key, const char *value);
+  size_t putString(const char *key, const String &value);
+  String getString(const char *key, const String &defaultValue = String());
+  size_t getString(const char *key, char *value, size_t maxLen);
+
+  size_t putUChar(const char *key, uint8_t value);
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+  size_t putUShort(const char *key, uint16_t value);
+  uint16_t getUShort(const char *key, uint16_t defaultValue = 0);
+  size_t putInt(const char *key, int32_t value);
+  int32_t getInt(const char *key, int32_t defaultValue = 0);
+  size_t putUInt(const char *key, uint32_t value);
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+  size_t putBool(const char *key, bool value);
+  bool getBool(const char *key, bool defaultValue = false);
+  size_t putBytes(const char *key, const void *value, size_t len);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+  size_t getBytesLength(const char *key);
+
+private:
+  String keyPath(const char *key) const;
+  bool readRaw(const char *key, std::string &out);
+  size_t writeRaw(const char *key, const void *data, size_t len);
+
+  String _dir;
+  bool _started = false;
+  bool _readOnly = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+// Firmware images uploaded on the host are accepted and discarded; there is
+// no second partition to boot.
+
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+class UpdateClass {
+public:
+  bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH) {
+    (void)size;
+    (void)command;
+    _written = 0;
+    _error = false;
+    _running = true;
+    return true;
+  }
+  size_t write(uint8_t *data, size_t len) {
+    (void)data;
+    if (!_running)
+      return 0;
+    _written += len;
+    return len;
+  }
+  bool end(bool evenIfRemaining = false) {
+    (void)evenIfRemaining;
+    _running = false;
+    return !_error;
+  }
+  bool hasError() const { return _error; }
+  void printError(Print &out) { out.println("Update: host build"); }
+  bool canRollBack() { return false; }
+  bool rollBack() { return false; }
+  size_t progress() const { return _written; }
+
+private:
+  size_t _written = 0;
+  bool _error = false;
+  bool _running = false;
+};
+
+extern UpdateClass Update;
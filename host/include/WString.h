@@ -0,0 +1,145 @@
+#pragma once
+
+// Host build: std::string backed replacement for the Arduino String class.
+// Only the subset of the API used by the firmware (and by ArduinoJson's
+// Arduino adapters) is provided.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class __FlashStringHelper;
+#define F(string_literal)                                                      \
+  (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String {
+public:
+  String() = default;
+  String(const char *cstr);
+  String(const char *cstr, size_t len);
+  String(const String &s) = default;
+  String(String &&s) noexcept = default;
+  String(const std::string &s) : _s(s) {}
+  String(const __FlashStringHelper *f)
+      : String(reinterpret_cast<const char *>(f)) {}
+  explicit String(char c);
+  explicit String(unsigned char v, unsigned char base = 10);
+  explicit String(int v, unsigned char base = 10);
+  explicit String(unsigned int v, unsigned char base = 10);
+  explicit String(long v, unsigned char base = 10);
+  explicit String(unsigned long v, unsigned char base = 10);
+  explicit String(long long v, unsigned char base = 10);
+  explicit String(unsigned long long v, unsigned char base = 10);
+  explicit String(float v, unsigned char decimals = 2);
+  explicit String(double v, unsigned char decimals = 2);
+
+  String &operator=(const String &rhs) = default;
+  String &operator=(String &&rhs) noexcept = default;
+  String &operator=(const char *cstr);
+
+  bool reserve(size_t size) {
+    _s.reserve(size);
+    return true;
+  }
+  size_t length() const { return _s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  const char *c_str() const { return _s.c_str(); }
+  char *begin() { return &_s[0]; }
+  char *end() { return &_s[0] + _s.size(); }
+  const char *begin() const { return _s.c_str(); }
+  const char *end() const { return _s.c_str() + _s.size(); }
+  const std::string &str() const { return _s; }
+
+  bool concat(const String &s);
+  bool concat(const char *cstr);
+  bool concat(const char *cstr, size_t len);
+  bool concat(char c);
+  bool concat(unsigned char v);
+  bool concat(int v);
+  bool concat(unsigned int v);
+  bool concat(long v);
+  bool concat(unsigned long v);
+  bool concat(long long v);
+  bool concat(unsigned long long v);
+  bool concat(float v);
+  bool concat(double v);
+
+  template <typename T> String &operator+=(const T &rhs) {
+    concat(rhs);
+    return *this;
+  }
+
+  int compareTo(const String &s) const { return _s.compare(s._s); }
+  bool equals(const String &s) const { return _s == s._s; }
+  bool equals(const char *cstr) const;
+  bool equalsIgnoreCase(const String &s) const;
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+  bool operator>(const String &rhs) const { return compareTo(rhs) > 0; }
+  bool operator<=(const String &rhs) const { return compareTo(rhs) <= 0; }
+  bool operator>=(const String &rhs) const { return compareTo(rhs) >= 0; }
+
+  bool startsWith(const String &prefix) const;
+  bool startsWith(const String &prefix, unsigned int offset) const;
+  bool endsWith(const String &suffix) const;
+
+  char charAt(unsigned int index) const;
+  void setCharAt(unsigned int index, char c);
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index);
+  void getBytes(unsigned char *buf, unsigned int bufsize,
+                unsigned int index = 0) const;
+  void toCharArray(char *buf, unsigned int bufsize,
+                   unsigned int index = 0) const {
+    getBytes((unsigned char *)buf, bufsize, index);
+  }
+
+  int indexOf(char ch) const { return indexOf(ch, 0); }
+  int indexOf(char ch, unsigned int fromIndex) const;
+  int indexOf(const String &s) const { return indexOf(s, 0); }
+  int indexOf(const String &s, unsigned int fromIndex) const;
+  int lastIndexOf(char ch) const;
+  int lastIndexOf(char ch, unsigned int fromIndex) const;
+  int lastIndexOf(const String &s) const;
+  int lastIndexOf(const String &s, unsigned int fromIndex) const;
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String &find, const String &replace);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const;
+  float toFloat() const;
+  double toDouble() const;
+
+private:
+  std::string _s;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+String operator+(const String &lhs, unsigned char rhs);
+String operator+(const String &lhs, int rhs);
+String operator+(const String &lhs, unsigned int rhs);
+String operator+(const String &lhs, long rhs);
+String operator+(const String &lhs, unsigned long rhs);
+String operator+(const String &lhs, long long rhs);
+String operator+(const String &lhs, unsigned long long rhs);
+String operator+(const String &lhs, float rhs);
+String operator+(const String &lhs, double rhs);
+inline bool operator==(const char *lhs, const String &rhs) {
+  return rhs == lhs;
+}
+inline bool operator!=(const char *lhs, const String &rhs) {
+  return rhs != lhs;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// Host build: the "radio" is the machine's network stack. STA reports
+// connected with the first non-loopback IPv4 address; the soft-AP is a label.
+
+#include <Arduino.h>
+
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+#include "WiFiUdp.h"
+
+typedef enum {
+  WIFI_MODE_NULL = 0,
+  WIFI_MODE_STA,
+  WIFI_MODE_AP,
+  WIFI_MODE_APSTA,
+  WIFI_MODE_MAX
+} wifi_mode_t;
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK,
+  WIFI_AUTH_WPA2_ENTERPRISE,
+  WIFI_AUTH_WPA3_PSK,
+  WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t m);
+  wifi_mode_t getMode() const { return _mode; }
+
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr,
+                    int32_t channel = 0, const uint8_t *bssid = nullptr,
+                    bool connect = true);
+  bool disconnect(bool wifiOff = false, bool eraseAp = false);
+  wl_status_t status();
+  bool setSleep(bool enabled) { return true; }
+  bool setAutoConnect(bool autoConnect) { return true; }
+  bool setAutoReconnect(bool autoReconnect) { return true; }
+  bool setHostname(const char *hostname);
+  const char *getHostname() const { return _hostname.c_str(); }
+
+  bool softAP(const char *ssid, const char *passphrase = nullptr,
+              int channel = 1, int hidden = 0, int maxConnection = 4);
+  bool softAPdisconnect(bool wifiOff = false);
+  IPAddress softAPIP();
+
+  IPAddress localIP();
+  IPAddress subnetMask();
+  IPAddress gatewayIP();
+  String macAddress();
+  String SSID() const { return _ssid; }
+  int8_t RSSI() const { return -42; }
+
+  int16_t scanNetworks(bool async = false, bool showHidden = false);
+  int16_t scanComplete();
+  void scanDelete();
+  String SSID(uint8_t i);
+  int32_t RSSI(uint8_t i);
+  int32_t channel(uint8_t i);
+  wifi_auth_mode_t encryptionType(uint8_t i);
+
+  int hostByName(const char *host, IPAddress &result);
+
+private:
+  wifi_mode_t _mode = WIFI_MODE_NULL;
+  bool _staStarted = false;
+  bool _scanDone = false;
+  String _ssid;
+  String _apSsid;
+  String _hostname = "esp32-host";
+};
+
+extern WiFiClass WiFi;
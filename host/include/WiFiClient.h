@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+class Client : public Stream {
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char *host, uint16_t port) = 0;
+  virtual int read(uint8_t *buf, size_t size) = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+  using Print::write;
+  using Stream::read;
+};
+
+struct HostSocketHandle;
+
+// Blocking BSD socket client. Copies share the underlying socket, like the
+// ESP32 core's shared WiFiClientSocketHandle.
+class WiFiClient : public Client {
+public:
+  WiFiClient();
+  explicit WiFiClient(int fd);
+  ~WiFiClient() override;
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+  int connect(const char *host, uint16_t port) override;
+  int connect(const char *host, uint16_t port, int32_t timeoutMs);
+
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int read(char *buf, size_t size) { return read((uint8_t *)buf, size); }
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+  // Seconds, as in the ESP32 core (applies to socket I/O and Stream reads).
+  int setTimeout(uint32_t seconds);
+  int setNoDelay(bool nodelay);
+  int fd() const;
+
+  IPAddress remoteIP() const;
+  uint16_t remotePort() const;
+  IPAddress localIP() const;
+  uint16_t localPort() const;
+
+private:
+  std::shared_ptr<HostSocketHandle> _sock;
+  int _peek = -1;
+  bool _connected = false;
+};
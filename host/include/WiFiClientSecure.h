@@ -0,0 +1,13 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+// TLS is not emulated on the host; connects fail so OTA checks take their
+// error path instead of touching the network.
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure() {}
+  void setCACert(const char *) {}
+  int connect(IPAddress, uint16_t) override { return 0; }
+  int connect(const char *, uint16_t) override { return 0; }
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+class WiFiServer {
+public:
+  explicit WiFiServer(uint16_t port = 80, uint8_t maxClients = 4)
+      : _port(port), _maxClients(maxClients) {}
+  ~WiFiServer() { end(); }
+
+  void begin(uint16_t port = 0);
+  void end();
+  void stop() { end(); }
+  void close() { end(); }
+  bool hasClient();
+  WiFiClient available();
+  WiFiClient accept() { return available(); }
+  void setNoDelay(bool nodelay) { _noDelay = nodelay; }
+  bool getNoDelay() const { return _noDelay; }
+  operator bool() const { return _listening; }
+
+private:
+  int _fd = -1;
+  int _pending = -1;
+  uint16_t _port;
+  uint8_t _maxClients;
+  bool _noDelay = false;
+  bool _listening = false;
+};
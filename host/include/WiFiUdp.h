@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+class WiFiUDP : public Stream {
+public:
+  WiFiUDP() = default;
+  ~WiFiUDP() override { stop(); }
+
+  uint8_t begin(IPAddress address, uint16_t port);
+  uint8_t begin(uint16_t port);
+  uint8_t beginMulticast(IPAddress address, uint16_t port);
+  void stop();
+
+  int beginPacket();
+  int beginPacket(IPAddress ip, uint16_t port);
+  int beginPacket(const char *host, uint16_t port);
+  int endPacket();
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  int parsePacket();
+  int available() override;
+  int read() override;
+  int read(unsigned char *buffer, size_t len);
+  int read(char *buffer, size_t len) {
+    return read((unsigned char *)buffer, len);
+  }
+  int peek() override;
+  void flush() override;
+
+  IPAddress remoteIP() const { return _remoteIp; }
+  uint16_t remotePort() const { return _remotePort; }
+
+private:
+  bool ensureSocket();
+  int _fd = -1;
+  IPAddress _remoteIp;
+  uint16_t _remotePort = 0;
+  IPAddress _txIp;
+  uint16_t _txPort = 0;
+  std::vector<uint8_t> _tx;
+  std::vector<uint8_t> _rx;
+  size_t _rxPos = 0;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+// Host build: the small slice of FreeRTOS the firmware uses, mapped onto
+// pthreads. One tick is one millisecond (CONFIG_FREERTOS_HZ=1000 on ESP32).
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(xTimeInMs))
+#define configTICK_RATE_HZ 1000
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+struct HostMux;
+typedef struct {
+  HostMux *impl;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {nullptr}
+
+void hostMuxEnter(portMUX_TYPE *mux);
+void hostMuxExit(portMUX_TYPE *mux);
+#define portENTER_CRITICAL(mux) hostMuxEnter(mux)
+#define portEXIT_CRITICAL(mux) hostMuxExit(mux)
+#define portENTER_CRITICAL_ISR(mux) hostMuxEnter(mux)
+#define portEXIT_CRITICAL_ISR(mux) hostMuxExit(mux)
+#define taskENTER_CRITICAL(mux) hostMuxEnter(mux)
+#define taskEXIT_CRITICAL(mux) hostMuxExit(mux)
+
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <lwip/netif.h>
+
+// Looks the address up in /proc/net/arp. Returns -1 when not cached.
+int8_t etharp_find_addr(struct netif *netif, const ip4_addr_t *ipaddr,
+                        struct eth_addr **eth_ret,
+                        const ip4_addr_t **ip_ret);
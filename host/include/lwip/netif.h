@@ -0,0 +1,21 @@
+#pragma once
+
+// Just enough lwIP to walk the interface list and query the ARP table.
+
+#include <cstdint>
+
+typedef struct ip4_addr {
+  uint32_t addr;
+} ip4_addr_t;
+
+struct eth_addr {
+  uint8_t addr[6];
+};
+
+struct netif {
+  struct netif *next;
+  char name[2];
+  uint8_t num;
+};
+
+extern struct netif *netif_list;
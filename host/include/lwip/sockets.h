@@ -0,0 +1,12 @@
+#pragma once
+
+// lwIP's BSD socket layer maps straight onto the host's.
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
@@ -0,0 +1,89 @@
+#pragma once
+
+// ESP-IDF mDNS query API. The host has no responder integration, so queries
+// complete immediately with no results.
+
+#include <cstdint>
+#include <cstdlib>
+
+#define MDNS_TYPE_A 0x0001
+#define MDNS_TYPE_PTR 0x000C
+#define MDNS_TYPE_TXT 0x0010
+#define MDNS_TYPE_AAAA 0x001C
+#define MDNS_TYPE_SRV 0x0021
+#define MDNS_TYPE_ANY 0x00FF
+
+#define ESP_IPADDR_TYPE_V4 0
+#define ESP_IPADDR_TYPE_V6 6
+
+typedef struct {
+  uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+  uint32_t addr[4];
+  uint8_t zone;
+} esp_ip6_addr_t;
+
+typedef struct {
+  union {
+    esp_ip6_addr_t ip6;
+    esp_ip4_addr_t ip4;
+  } u_addr;
+  uint8_t type;
+} esp_ip_addr_t;
+
+typedef struct mdns_ip_addr_s {
+  esp_ip_addr_t addr;
+  struct mdns_ip_addr_s *next;
+} mdns_ip_addr_t;
+
+typedef struct {
+  const char *key;
+  const char *value;
+} mdns_txt_item_t;
+
+typedef struct mdns_result_s {
+  struct mdns_result_s *next;
+  void *esp_netif;
+  uint32_t ttl;
+  int ip_protocol;
+  char *instance_name;
+  char *service_type;
+  char *proto;
+  char *hostname;
+  uint16_t port;
+  mdns_txt_item_t *txt;
+  uint8_t *txt_value_len;
+  size_t txt_count;
+  mdns_ip_addr_t *addr;
+} mdns_result_t;
+
+typedef struct mdns_search_once_s {
+  int done;
+} mdns_search_once_t;
+
+inline mdns_search_once_t *mdns_query_async_new(const char *, const char *,
+                                                const char *, uint16_t,
+                                                uint32_t, size_t, void *) {
+  mdns_search_once_t *s = (mdns_search_once_t *)calloc(1, sizeof(*s));
+  if (s)
+    s->done = 1;
+  return s;
+}
+
+inline bool mdns_query_async_get_results(mdns_search_once_t *search, uint32_t,
+                                         mdns_result_t **results,
+                                         uint8_t *numResults = nullptr) {
+  if (results)
+    *results = nullptr;
+  if (numResults)
+    *numResults = 0;
+  return search && search->done;
+}
+
+inline void mdns_query_async_delete(mdns_search_once_t *search) {
+  free(search);
+}
+
+inline void mdns_query_results_free(mdns_result_t *) {}
@@ -0,0 +1,532 @@
+// Host build of AsyncTCP: non-blocking sockets multiplexed by one poll()
+// thread. See AsyncTCP.h for the threading contract.
+
+#include <AsyncTCP.h>
+#include <WiFi.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "HostRuntime.h"
+
+// Matches CONFIG_LWIP_TCP_SND_BUF_DEFAULT / TCP_MSS on the ESP32 Arduino core.
+static const size_t kSndBuf = 5744;
+static const size_t kMss = 1436;
+static const uint32_t kPollIntervalMs = 125;
+
+namespace {
+
+struct Registry {
+  std::map<uint64_t, AsyncClient *> clients;
+  std::map<uint64_t, AsyncServer *> servers;
+  std::atomic<uint64_t> nextId{1};
+  int wakeFds[2] = {-1, -1};
+  bool started = false;
+};
+
+Registry &reg() {
+  static Registry r;
+  return r;
+}
+
+void wake() {
+  Registry &r = reg();
+  if (r.wakeFds[1] >= 0) {
+    char c = 1;
+    ssize_t n = ::write(r.wakeFds[1], &c, 1);
+    (void)n;
+  }
+}
+
+void eventLoop();
+
+void ensureLoop() {
+  Registry &r = reg();
+  if (r.started)
+    return;
+  r.started = true;
+  if (pipe(r.wakeFds) == 0) {
+    fcntl(r.wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(r.wakeFds[1], F_SETFL, O_NONBLOCK);
+  }
+  std::thread([] {
+    pthread_setname_np(pthread_self(), "async_tcp");
+    eventLoop();
+  }).detach();
+}
+
+void setNonBlocking(int fd) { fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); }
+
+void eventLoop() {
+  Registry &r = reg();
+  std::vector<pollfd> fds;
+  std::vector<std::pair<bool, uint64_t>> owners; // (isServer, id)
+  for (;;) {
+    fds.clear();
+    owners.clear();
+    fds.push_back({r.wakeFds[0], POLLIN, 0});
+    owners.push_back({false, 0});
+    {
+      std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+      for (auto &kv : r.servers) {
+        if (kv.second->hostFd() < 0)
+          continue;
+        fds.push_back({kv.second->hostFd(), POLLIN, 0});
+        owners.push_back({true, kv.first});
+      }
+      for (auto &kv : r.clients) {
+        AsyncClient *c = kv.second;
+        if (c->hostFd() < 0)
+          continue;
+        short ev = 0;
+        if (c->hostWantsRead())
+          ev |= POLLIN;
+        if (c->hostWantsWrite())
+          ev |= POLLOUT;
+        fds.push_back({c->hostFd(), ev, 0});
+        owners.push_back({false, kv.first});
+      }
+    }
+
+    int n = poll(fds.data(), fds.size(), (int)kPollIntervalMs);
+    if (n < 0 && errno != EINTR) {
+      perror("[host] async_tcp poll");
+      delay(10);
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      char drain[64];
+      while (::read(r.wakeFds[0], drain, sizeof(drain)) > 0) {
+      }
+    }
+
+    std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+    for (size_t i = 1; i < fds.size(); i++) {
+      short re = fds[i].revents;
+      if (!re)
+        continue;
+      uint64_t id = owners[i].second;
+      if (owners[i].first) {
+        auto it = r.servers.find(id);
+        if (it != r.servers.end() && it->second->hostFd() == fds[i].fd)
+          it->second->hostOnAcceptable();
+        continue;
+      }
+      auto it = r.clients.find(id);
+      if (it == r.clients.end() || it->second->hostFd() != fds[i].fd)
+        continue;
+      if (re & (POLLOUT | POLLERR | POLLHUP))
+        it->second->hostOnWritable();
+      // The write path may have closed or deleted the client.
+      it = r.clients.find(id);
+      if (it == r.clients.end() || it->second->hostFd() != fds[i].fd)
+        continue;
+      if (re & (POLLIN | POLLERR | POLLHUP))
+        it->second->hostOnReadable();
+    }
+
+    uint32_t now = millis();
+    std::vector<uint64_t> ids;
+    ids.reserve(r.clients.size());
+    for (auto &kv : r.clients)
+      ids.push_back(kv.first);
+    for (uint64_t id : ids) {
+      auto it = r.clients.find(id);
+      if (it != r.clients.end())
+        it->second->hostOnPollTick(now);
+    }
+  }
+}
+
+} // namespace
+
+std::recursive_mutex &hostAsyncLock() {
+  static std::recursive_mutex m;
+  return m;
+}
+
+// ── AsyncClient ──
+
+AsyncClient::AsyncClient() : _id(reg().nextId++) {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  ensureLoop();
+  reg().clients[_id] = this;
+}
+
+AsyncClient::AsyncClient(int fd) : AsyncClient() {
+  _fd = fd;
+  _state = Connected;
+  _lastRx = millis();
+  cacheAddresses();
+}
+
+AsyncClient::~AsyncClient() {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  teardown(false);
+  reg().clients.erase(_id);
+}
+
+void AsyncClient::cacheAddresses() {
+  sockaddr_in sa{};
+  socklen_t len = sizeof(sa);
+  if (getpeername(_fd, (sockaddr *)&sa, &len) == 0) {
+    _remoteIp = IPAddress((uint32_t)sa.sin_addr.s_addr);
+    _remotePort = ntohs(sa.sin_port);
+  }
+  len = sizeof(sa);
+  if (getsockname(_fd, (sockaddr *)&sa, &len) == 0) {
+    _localIp = IPAddress((uint32_t)sa.sin_addr.s_addr);
+    _localPort = ntohs(sa.sin_port);
+  }
+}
+
+bool AsyncClient::connect(IPAddress ip, uint16_t port) {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_state != Idle)
+    return false;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+  setNonBlocking(fd);
+  sockaddr_in sa{};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = (uint32_t)ip;
+  int rc = ::connect(fd, (sockaddr *)&sa, sizeof(sa));
+  if (rc != 0 && errno != EINPROGRESS) {
+    ::close(fd);
+    return false;
+  }
+  _fd = fd;
+  _remoteIp = ip;
+  _remotePort = port;
+  _state = Connecting;
+  _writeStart = millis();
+  wake();
+  return true;
+}
+
+bool AsyncClient::connect(const char *host, uint16_t port) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip))
+    return false;
+  return connect(ip, port);
+}
+
+void AsyncClient::finishConnect() {
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+    fail(err == ECONNREFUSED ? ERR_RST
+                             : (err == ETIMEDOUT ? ERR_TIMEOUT : ERR_CONN));
+    return;
+  }
+  _state = Connected;
+  _lastRx = millis();
+  cacheAddresses();
+  if (_connectCb)
+    _connectCb(_connectArg, this);
+}
+
+// Error path: onError then onDisconnect, as AsyncClient::_error() does.
+void AsyncClient::fail(int8_t err) {
+  uint64_t id = _id;
+  teardown(false);
+  if (_errorCb)
+    _errorCb(_errorArg, this, err);
+  if (reg().clients.count(id) && _discardCb)
+    _discardCb(_discardArg, this);
+}
+
+void AsyncClient::teardown(bool notify) {
+  if (_fd >= 0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+  bool wasActive = _state != Idle;
+  _state = Idle;
+  _out.clear();
+  if (notify && wasActive && _discardCb)
+    _discardCb(_discardArg, this);
+}
+
+void AsyncClient::close(bool now) {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_state == Idle)
+    return;
+  if (!now && _state == Connected && !_out.empty()) {
+    _state = Closing;
+    wake();
+    return;
+  }
+  teardown(true);
+}
+
+int8_t AsyncClient::abort() {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_fd >= 0) {
+    linger lg{1, 0};
+    setsockopt(_fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+  }
+  teardown(true);
+  return ERR_ABRT;
+}
+
+bool AsyncClient::free() { return _state == Idle; }
+
+bool AsyncClient::canSend() { return space() > 0; }
+
+size_t AsyncClient::space() {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_state != Connected)
+    return 0;
+  return _out.size() >= kSndBuf ? 0 : kSndBuf - _out.size();
+}
+
+// The ESP32 library caps add() at space(). The host buffer is unbounded so
+// that callers which ignore the return value (as most of the firmware does)
+// behave as on a healthy link; space() still reports the lwIP window so
+// backpressure logic sees realistic numbers.
+size_t AsyncClient::add(const char *data, size_t size, uint8_t) {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_state != Connected || !data || !size)
+    return 0;
+  if (_out.empty())
+    _writeStart = millis();
+  _out.append(data, size);
+  return size;
+}
+
+bool AsyncClient::send() {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_state != Connected)
+    return false;
+  wake();
+  return true;
+}
+
+size_t AsyncClient::write(const char *data) {
+  return data ? write(data, strlen(data)) : 0;
+}
+
+size_t AsyncClient::write(const char *data, size_t size, uint8_t apiflags) {
+  size_t n = add(data, size, apiflags);
+  if (n && !(apiflags & ASYNC_WRITE_FLAG_MORE))
+    send();
+  return n;
+}
+
+void AsyncClient::setNoDelay(bool nodelay) {
+  int v = nodelay ? 1 : 0;
+  if (_fd >= 0)
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+}
+
+bool AsyncClient::getNoDelay() {
+  int v = 0;
+  socklen_t len = sizeof(v);
+  if (_fd >= 0)
+    getsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &v, &len);
+  return v != 0;
+}
+
+void AsyncClient::onConnect(AcConnectHandler cb, void *arg) {
+  _connectCb = cb;
+  _connectArg = arg;
+}
+void AsyncClient::onDisconnect(AcConnectHandler cb, void *arg) {
+  _discardCb = cb;
+  _discardArg = arg;
+}
+void AsyncClient::onAck(AcAckHandler cb, void *arg) {
+  _ackCb = cb;
+  _ackArg = arg;
+}
+void AsyncClient::onError(AcErrorHandler cb, void *arg) {
+  _errorCb = cb;
+  _errorArg = arg;
+}
+void AsyncClient::onData(AcDataHandler cb, void *arg) {
+  _recvCb = cb;
+  _recvArg = arg;
+}
+void AsyncClient::onTimeout(AcTimeoutHandler cb, void *arg) {
+  _timeoutCb = cb;
+  _timeoutArg = arg;
+}
+void AsyncClient::onPoll(AcConnectHandler cb, void *arg) {
+  _pollCb = cb;
+  _pollArg = arg;
+}
+
+const char *AsyncClient::errorToString(int8_t error) {
+  switch (error) {
+  case ERR_OK:
+    return "OK";
+  case ERR_MEM:
+    return "Out of memory error";
+  case ERR_TIMEOUT:
+    return "Timeout";
+  case ERR_CONN:
+    return "Not connected";
+  case ERR_ABRT:
+    return "Connection aborted";
+  case ERR_RST:
+    return "Connection reset";
+  case ERR_CLSD:
+    return "Connection closed";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+void AsyncClient::hostOnWritable() {
+  if (_state == Connecting) {
+    finishConnect();
+    return;
+  }
+  if (_out.empty() || _fd < 0)
+    return;
+  ssize_t n = ::send(_fd, _out.data(), _out.size(), MSG_NOSIGNAL);
+  if (n < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      fail(ERR_RST);
+    return;
+  }
+  _out.erase(0, (size_t)n);
+  uint32_t rtt = millis() - _writeStart;
+  _writeStart = millis();
+  uint64_t id = _id;
+  if (n > 0 && _ackCb)
+    _ackCb(_ackArg, this, (size_t)n, rtt);
+  if (!reg().clients.count(id))
+    return;
+  if (_out.empty() && _state == Closing)
+    teardown(true);
+}
+
+void AsyncClient::hostOnReadable() {
+  if (_fd < 0)
+    return;
+  uint64_t id = _id;
+  // Deliver in MSS sized pieces, as lwIP hands pbufs to the callback.
+  for (int burst = 0; burst < 16; burst++) {
+    char buf[kMss];
+    ssize_t n = ::recv(_fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n > 0) {
+      _lastRx = millis();
+      if (_recvCb)
+        _recvCb(_recvArg, this, buf, (size_t)n);
+      if (!reg().clients.count(id) || _fd < 0)
+        return;
+      continue;
+    }
+    if (n == 0) {
+      teardown(true);
+      return;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      fail(ERR_RST);
+    return;
+  }
+}
+
+void AsyncClient::hostOnPollTick(uint32_t now) {
+  if (_state != Connected)
+    return;
+  uint64_t id = _id;
+  if (_rxTimeoutSec && now - _lastRx > _rxTimeoutSec * 1000) {
+    if (_timeoutCb)
+      _timeoutCb(_timeoutArg, this, now - _lastRx);
+    else
+      close(true);
+    if (!reg().clients.count(id))
+      return;
+  }
+  if (_pollCb && now - _lastPoll >= 500) {
+    _lastPoll = now;
+    _pollCb(_pollArg, this);
+  }
+}
+
+// ── AsyncServer ──
+
+AsyncServer::AsyncServer(uint16_t port)
+    : AsyncServer(IPAddress(0, 0, 0, 0), port) {}
+
+AsyncServer::AsyncServer(IPAddress addr, uint16_t port)
+    : _id(reg().nextId++), _addr(addr), _port(port) {}
+
+AsyncServer::~AsyncServer() { end(); }
+
+void AsyncServer::onClient(AcConnectHandler cb, void *arg) {
+  _connectCb = cb;
+  _connectArg = arg;
+}
+
+void AsyncServer::begin() {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  if (_fd >= 0)
+    return;
+  ensureLoop();
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  uint16_t bindPort = hostMapListenPort(_port);
+  sockaddr_in sa{};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(bindPort);
+  sa.sin_addr.s_addr = (uint32_t)_addr;
+  if (bind(fd, (sockaddr *)&sa, sizeof(sa)) != 0 || listen(fd, 8) != 0) {
+    fprintf(stderr, "[host] AsyncServer: cannot listen on %u: %s\n", bindPort,
+            strerror(errno));
+    ::close(fd);
+    return;
+  }
+  setNonBlocking(fd);
+  _fd = fd;
+  reg().servers[_id] = this;
+  wake();
+}
+
+void AsyncServer::end() {
+  std::lock_guard<std::recursive_mutex> lk(hostAsyncLock());
+  reg().servers.erase(_id);
+  if (_fd >= 0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+}
+
+void AsyncServer::hostOnAcceptable() {
+  for (;;) {
+    int cfd = ::accept(_fd, nullptr, nullptr);
+    if (cfd < 0)
+      return;
+    setNonBlocking(cfd);
+    if (_noDelay) {
+      int one = 1;
+      setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    AsyncClient *c = new AsyncClient(cfd);
+    if (_connectCb)
+      _connectCb(_connectArg, c);
+    else
+      delete c;
+    if (_fd < 0)
+      return;
+  }
+}
@@ -0,0 +1,1319 @@
+// Host build of ESPAsyncWebServer. Requests are parsed on the async_tcp
+// thread (hostAsyncLock() held), handlers are matched in registration order
+// with the same canHandle() rules as the ESP32 library, and every response
+// closes the connection afterwards.
+
+#include <ESPAsyncWebServer.h>
+
+#include "HostCrypto.h"
+#include "HostRuntime.h"
+
+#define RESPONSE_TRY_AGAIN 0xFFFF
+
+namespace {
+
+typedef std::lock_guard<std::recursive_mutex> AsyncLock;
+
+const size_t kMaxHeadBytes = 16 * 1024;
+const uint64_t kMaxWsFrame = 1024 * 1024;
+
+const char *statusText(int code) {
+  switch (code) {
+  case 100:
+    return "Continue";
+  case 101:
+    return "Switching Protocols";
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 202:
+    return "Accepted";
+  case 204:
+    return "No Content";
+  case 206:
+    return "Partial Content";
+  case 301:
+    return "Moved Permanently";
+  case 302:
+    return "Found";
+  case 304:
+    return "Not Modified";
+  case 307:
+    return "Temporary Redirect";
+  case 400:
+    return "Bad Request";
+  case 401:
+    return "Unauthorized";
+  case 403:
+    return "Forbidden";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 408:
+    return "Request Time-out";
+  case 409:
+    return "Conflict";
+  case 411:
+    return "Length Required";
+  case 413:
+    return "Request Entity Too Large";
+  case 429:
+    return "Too Many Requests";
+  case 500:
+    return "Internal Server Error";
+  case 501:
+    return "Not Implemented";
+  case 502:
+    return "Bad Gateway";
+  case 503:
+    return "Service Unavailable";
+  case 504:
+    return "Gateway Time-out";
+  default:
+    return "";
+  }
+}
+
+String contentTypeFor(const String &path) {
+  if (path.endsWith(".html") || path.endsWith(".htm"))
+    return "text/html";
+  if (path.endsWith(".css"))
+    return "text/css";
+  if (path.endsWith(".json"))
+    return "application/json";
+  if (path.endsWith(".js"))
+    return "application/javascript";
+  if (path.endsWith(".png"))
+    return "image/png";
+  if (path.endsWith(".gif"))
+    return "image/gif";
+  if (path.endsWith(".jpg"))
+    return "image/jpeg";
+  if (path.endsWith(".ico"))
+    return "image/x-icon";
+  if (path.endsWith(".svg"))
+    return "image/svg+xml";
+  if (path.endsWith(".woff2"))
+    return "font/woff2";
+  if (path.endsWith(".woff"))
+    return "font/woff";
+  if (path.endsWith(".ttf"))
+    return "application/x-font-ttf";
+  if (path.endsWith(".xml"))
+    return "text/xml";
+  if (path.endsWith(".pdf"))
+    return "application/pdf";
+  if (path.endsWith(".zip"))
+    return "application/zip";
+  if (path.endsWith(".gz"))
+    return "application/x-gzip";
+  return "text/plain";
+}
+
+int hexVal(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+String urlDecode(const String &text) {
+  std::string out;
+  const std::string &in = text.str();
+  out.reserve(in.size());
+  for (size_t i = 0; i < in.size(); i++) {
+    char c = in[i];
+    if (c == '%' && i + 2 < in.size() && hexVal(in[i + 1]) >= 0 &&
+        hexVal(in[i + 2]) >= 0) {
+      out.push_back((char)(hexVal(in[i + 1]) * 16 + hexVal(in[i + 2])));
+      i += 2;
+    } else if (c == '+') {
+      out.push_back(' ');
+    } else {
+      out.push_back(c);
+    }
+  }
+  return String(out.c_str(), out.size());
+}
+
+// Value of `key="value"` (or key=value) inside a header such as
+// Content-Disposition or Content-Type.
+String headerAttr(const String &header, const char *key) {
+  String lower = header;
+  lower.toLowerCase();
+  String needle = String(key) + "=";
+  int at = lower.indexOf(needle);
+  if (at < 0)
+    return String();
+  int start = at + needle.length();
+  if (start < (int)header.length() && header[start] == '"') {
+    int end = header.indexOf('"', start + 1);
+    return header.substring(start + 1, end < 0 ? header.length() : end);
+  }
+  int end = header.indexOf(';', start);
+  String v = header.substring(start, end < 0 ? header.length() : end);
+  v.trim();
+  return v;
+}
+
+} // namespace
+
+// ── Responses ──
+
+std::string AsyncWebServerResponse::hostAssemble(bool headOnly) {
+  std::string body;
+  hostBody(body);
+  bool chunked = hostChunked();
+
+  std::string out = "HTTP/1.1 " + std::to_string(_code) + " " +
+                    statusText(_code) + "\r\n";
+  bool hasConnection = false;
+  for (auto &h : _headers)
+    if (h.name().equalsIgnoreCase("Connection"))
+      hasConnection = true;
+  if (!hasConnection)
+    out += "Connection: close\r\n";
+  if (chunked)
+    out += "Transfer-Encoding: chunked\r\n";
+  else
+    out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  if (_contentType.length())
+    out += "Content-Type: " + _contentType.str() + "\r\n";
+  for (auto &h : _headers)
+    out += h.toString().str();
+  out += "\r\n";
+  if (headOnly)
+    return out;
+
+  if (!chunked) {
+    out += body;
+    return out;
+  }
+  if (!body.empty()) {
+    char len[20];
+    snprintf(len, sizeof(len), "%zx\r\n", body.size());
+    out += len;
+    out += body;
+    out += "\r\n";
+  }
+  out += "0\r\n\r\n";
+  return out;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String &contentType,
+                                       const String &content)
+    : _content(content) {
+  _code = code;
+  _contentType = contentType;
+  if (_content.length() && !_contentType.length())
+    _contentType = "text/plain";
+}
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const String &contentType,
+                                           const uint8_t *content, size_t len)
+    : _content(content), _len(len) {
+  _code = code;
+  _contentType = contentType;
+}
+
+AsyncFileResponse::AsyncFileResponse(fs::FS &fs, const String &path,
+                                     const String &contentType,
+                                     bool download) {
+  String realPath = path;
+  if (!download && !fs.exists(path) && fs.exists(path + ".gz")) {
+    realPath = path + ".gz";
+    addHeader("Content-Encoding", "gzip");
+  }
+  const String &logical = path;
+
+  File f = fs.open(realPath, "r");
+  if (f && !f.isDirectory()) {
+    _found = true;
+    size_t n = f.size();
+    _data.resize(n);
+    if (n)
+      _data.resize(f.read((uint8_t *)&_data[0], n));
+    f.close();
+  } else {
+    _code = 404;
+  }
+  _contentType = contentType.length() ? contentType : contentTypeFor(logical);
+
+  int slash = logical.lastIndexOf('/');
+  String filename = logical.substring(slash + 1);
+  if (download)
+    addHeader("Content-Disposition", "attachment; filename=\"" + filename +
+                                         "\"");
+  else
+    addHeader("Content-Disposition", "inline; filename=\"" + filename + "\"");
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String &contentType,
+                                           AwsResponseFiller callback)
+    : _filler(callback) {
+  _contentType = contentType;
+}
+
+void AsyncChunkedResponse::hostBody(std::string &out) {
+  uint8_t buf[1460];
+  for (int retries = 0; _filler && retries < 1000;) {
+    size_t n = _filler(buf, sizeof(buf), out.size());
+    if (n == RESPONSE_TRY_AGAIN) {
+      retries++;
+      delay(1);
+      continue;
+    }
+    if (n == 0)
+      break;
+    out.append((const char *)buf, std::min(n, sizeof(buf)));
+  }
+}
+
+AsyncCallbackResponse::AsyncCallbackResponse(const String &contentType,
+                                             size_t len,
+                                             AwsResponseFiller callback)
+    : _filler(callback) {
+  _contentType = contentType;
+  _contentLength = len;
+}
+
+void AsyncCallbackResponse::hostBody(std::string &out) {
+  uint8_t buf[1460];
+  for (int retries = 0; _filler && out.size() < _contentLength &&
+                        retries < 1000;) {
+    size_t want = std::min(sizeof(buf), _contentLength - out.size());
+    size_t n = _filler(buf, want, out.size());
+    if (n == RESPONSE_TRY_AGAIN) {
+      retries++;
+      delay(1);
+      continue;
+    }
+    if (n == 0)
+      break;
+    out.append((const char *)buf, std::min(n, want));
+  }
+}
+
+AsyncResponseStream::AsyncResponseStream(const String &contentType,
+                                         size_t bufferSize) {
+  _contentType = contentType;
+  _content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(uint8_t data) { return write(&data, 1); }
+
+size_t AsyncResponseStream::write(const uint8_t *data, size_t len) {
+  _content.append((const char *)data, len);
+  return len;
+}
+
+// ── Requests ──
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer *server,
+                                             AsyncClient *client)
+    : _server(server), _client(client) {
+  client->setRxTimeout(3);
+  client->onData(
+      [](void *arg, AsyncClient *, void *data, size_t len) {
+        ((AsyncWebServerRequest *)arg)
+            ->hostOnData((const uint8_t *)data, len);
+      },
+      this);
+  client->onTimeout(
+      [](void *, AsyncClient *c, uint32_t) { c->close(true); }, this);
+  client->onDisconnect(
+      [](void *arg, AsyncClient *) { delete (AsyncWebServerRequest *)arg; },
+      this);
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  for (auto *h : _headerList)
+    delete h;
+  for (auto *p : _params)
+    delete p;
+  if (_tempObject)
+    ::free(_tempObject);
+  if (_client) {
+    AsyncClient *c = _client;
+    _client = nullptr;
+    c->onDisconnect(nullptr, nullptr);
+    delete c;
+  }
+}
+
+const char *AsyncWebServerRequest::methodToString() const {
+  switch (_method) {
+  case HTTP_GET:
+    return "GET";
+  case HTTP_POST:
+    return "POST";
+  case HTTP_DELETE:
+    return "DELETE";
+  case HTTP_PUT:
+    return "PUT";
+  case HTTP_PATCH:
+    return "PATCH";
+  case HTTP_HEAD:
+    return "HEAD";
+  case HTTP_OPTIONS:
+    return "OPTIONS";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+void AsyncWebServerRequest::hostOnData(const uint8_t *data, size_t len) {
+  if (_dispatched)
+    return;
+  if (!_headDone) {
+    _rx.append((const char *)data, len);
+    size_t end = _rx.find("\r\n\r\n");
+    if (end == std::string::npos) {
+      if (_rx.size() > kMaxHeadBytes)
+        send(431);
+      return;
+    }
+    std::string rest = _rx.substr(end + 4);
+    _rx.resize(end + 2);
+    _headDone = true;
+    if (!parseHead()) {
+      send(400);
+      return;
+    }
+    _handler = _server->hostFindHandler(this);
+    _body.swap(rest);
+  } else {
+    _body.append((const char *)data, len);
+  }
+
+  if (_body.size() < _contentLength)
+    return;
+  if (_body.size() > _contentLength)
+    _body.resize(_contentLength);
+  dispatch();
+  // A WebSocket upgrade hands the connection over and leaves us detached.
+  if (!_client)
+    delete this;
+}
+
+bool AsyncWebServerRequest::parseHead() {
+  size_t lineEnd = _rx.find("\r\n");
+  std::string line = _rx.substr(0, lineEnd);
+  size_t sp1 = line.find(' ');
+  size_t sp2 = line.rfind(' ');
+  if (sp1 == std::string::npos || sp2 == sp1)
+    return false;
+  std::string m = line.substr(0, sp1);
+  String target = String(line.substr(sp1 + 1, sp2 - sp1 - 1).c_str());
+  _version = line.compare(sp2 + 1, std::string::npos, "HTTP/1.0") == 0 ? 0 : 1;
+
+  if (m == "GET")
+    _method = HTTP_GET;
+  else if (m == "POST")
+    _method = HTTP_POST;
+  else if (m == "DELETE")
+    _method = HTTP_DELETE;
+  else if (m == "PUT")
+    _method = HTTP_PUT;
+  else if (m == "PATCH")
+    _method = HTTP_PATCH;
+  else if (m == "HEAD")
+    _method = HTTP_HEAD;
+  else if (m == "OPTIONS")
+    _method = HTTP_OPTIONS;
+  else
+    return false;
+
+  int q = target.indexOf('?');
+  if (q >= 0) {
+    parseQuery(target.substring(q + 1), false);
+    target = target.substring(0, q);
+  }
+  _url = urlDecode(target);
+
+  size_t pos = lineEnd + 2;
+  while (pos < _rx.size()) {
+    size_t e = _rx.find("\r\n", pos);
+    if (e == std::string::npos)
+      break;
+    std::string h = _rx.substr(pos, e - pos);
+    pos = e + 2;
+    size_t colon = h.find(':');
+    if (colon == std::string::npos)
+      continue;
+    String name = String(h.substr(0, colon).c_str());
+    String value = String(h.substr(colon + 1).c_str());
+    name.trim();
+    value.trim();
+    _headerList.push_back(new AsyncWebHeader(name, value));
+    if (name.equalsIgnoreCase("Host")) {
+      _host = value;
+    } else if (name.equalsIgnoreCase("Content-Type")) {
+      int semi = value.indexOf(';');
+      _contentType = semi >= 0 ? value.substring(0, semi) : value;
+      _contentType.trim();
+      if (_contentType.equalsIgnoreCase("multipart/form-data"))
+        _boundary = headerAttr(value, "boundary");
+    } else if (name.equalsIgnoreCase("Content-Length")) {
+      _contentLength = (size_t)strtoul(value.c_str(), nullptr, 10);
+    }
+  }
+  _rx.clear();
+  return true;
+}
+
+void AsyncWebServerRequest::parseQuery(const String &query, bool post) {
+  int start = 0;
+  while (start <= (int)query.length()) {
+    int amp = query.indexOf('&', start);
+    String pair = query.substring(start, amp < 0 ? query.length() : amp);
+    if (pair.length()) {
+      int eq = pair.indexOf('=');
+      String name = eq < 0 ? pair : pair.substring(0, eq);
+      String value = eq < 0 ? String() : pair.substring(eq + 1);
+      _params.push_back(
+          new AsyncWebParameter(urlDecode(name), urlDecode(value), post));
+    }
+    if (amp < 0)
+      break;
+    start = amp + 1;
+  }
+}
+
+void AsyncWebServerRequest::parseMultipart() {
+  if (!_boundary.length())
+    return;
+  const std::string delim = "--" + _boundary.str();
+  size_t pos = _body.find(delim);
+  while (pos != std::string::npos) {
+    pos += delim.size();
+    if (_body.compare(pos, 2, "--") == 0)
+      break;
+    pos += 2; // CRLF after the boundary
+    size_t headEnd = _body.find("\r\n\r\n", pos);
+    if (headEnd == std::string::npos)
+      break;
+    String name, filename;
+    size_t hp = pos;
+    while (hp < headEnd) {
+      size_t e = _body.find("\r\n", hp);
+      if (e == std::string::npos || e > headEnd)
+        e = headEnd;
+      String h = String(_body.substr(hp, e - hp).c_str());
+      if (h.startsWith("Content-Disposition") ||
+          h.startsWith("content-disposition")) {
+        name = headerAttr(h, "name");
+        filename = headerAttr(h, "filename");
+      }
+      hp = e + 2;
+    }
+    size_t dataStart = headEnd + 4;
+    size_t next = _body.find("\r\n" + delim, dataStart);
+    if (next == std::string::npos)
+      break;
+    size_t dataLen = next - dataStart;
+    if (filename.length()) {
+      _params.push_back(
+          new AsyncWebParameter(name, filename, true, true, dataLen));
+      if (_handler)
+        _handler->handleUpload(this, filename, 0,
+                               (uint8_t *)&_body[dataStart], dataLen, true);
+    } else {
+      _params.push_back(new AsyncWebParameter(
+          name, String(_body.substr(dataStart, dataLen).c_str()), true));
+    }
+    pos = next + 2;
+  }
+}
+
+void AsyncWebServerRequest::dispatch() {
+  _dispatched = true;
+  if (!_handler) {
+    _server->hostNotFound(this);
+    return;
+  }
+  if (_contentType.equalsIgnoreCase("application/x-www-form-urlencoded")) {
+    parseQuery(String(_body.c_str()), true);
+  } else if (_boundary.length()) {
+    parseMultipart();
+  } else if (!_body.empty()) {
+    _handler->handleBody(this, (uint8_t *)&_body[0], _body.size(), 0,
+                         _body.size());
+  }
+  if (_client)
+    _handler->handleRequest(this);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response) {
+  if (_sent || !_client) {
+    delete response;
+    return;
+  }
+  _sent = true;
+  std::string out = response->hostAssemble(_method == HTTP_HEAD);
+  delete response;
+  _client->setRxTimeout(0);
+  _client->write(out.data(), out.size());
+  _client->close(false);
+}
+
+void AsyncWebServerRequest::send(int code, const String &contentType,
+                                 const String &content) {
+  send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(fs::FS &fs, const String &path,
+                                 const String &contentType, bool download) {
+  if (fs.exists(path) || (!download && fs.exists(path + ".gz")))
+    send(beginResponse(fs, path, contentType, download));
+  else
+    send(404);
+}
+
+void AsyncWebServerRequest::send(const String &contentType, size_t len,
+                                 AwsResponseFiller callback) {
+  send(beginResponse(contentType, len, callback));
+}
+
+void AsyncWebServerRequest::sendChunked(const String &contentType,
+                                        AwsResponseFiller callback) {
+  send(beginChunkedResponse(contentType, callback));
+}
+
+void AsyncWebServerRequest::redirect(const String &url) {
+  AsyncWebServerResponse *response = beginResponse(302);
+  response->addHeader("Location", url);
+  send(response);
+}
+
+AsyncWebServerResponse *
+AsyncWebServerRequest::beginResponse(int code, const String &contentType,
+                                     const String &content) {
+  return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse *
+AsyncWebServerRequest::beginResponse(fs::FS &fs, const String &path,
+                                     const String &contentType,
+                                     bool download) {
+  return new AsyncFileResponse(fs, path, contentType, download);
+}
+
+AsyncWebServerResponse *
+AsyncWebServerRequest::beginResponse(const String &contentType, size_t len,
+                                     AwsResponseFiller callback) {
+  return new AsyncCallbackResponse(contentType, len, callback);
+}
+
+AsyncWebServerResponse *
+AsyncWebServerRequest::beginResponse_P(int code, const String &contentType,
+                                       const uint8_t *content, size_t len) {
+  return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse *
+AsyncWebServerRequest::beginChunkedResponse(const String &contentType,
+                                            AwsResponseFiller callback) {
+  return new AsyncChunkedResponse(contentType, callback);
+}
+
+AsyncResponseStream *
+AsyncWebServerRequest::beginResponseStream(const String &contentType,
+                                           size_t bufferSize) {
+  return new AsyncResponseStream(contentType, bufferSize);
+}
+
+bool AsyncWebServerRequest::hasHeader(const String &name) const {
+  return getHeader(name) != nullptr;
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(const String &name) const {
+  for (auto *h : _headerList)
+    if (h->name().equalsIgnoreCase(name))
+      return h;
+  return nullptr;
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(size_t num) const {
+  return num < _headerList.size() ? _headerList[num] : nullptr;
+}
+
+String AsyncWebServerRequest::header(const char *name) const {
+  AsyncWebHeader *h = getHeader(String(name));
+  return h ? h->value() : String();
+}
+
+bool AsyncWebServerRequest::hasParam(const String &name, bool post,
+                                     bool file) const {
+  return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(const String &name,
+                                                   bool post, bool file) const {
+  for (auto *p : _params)
+    if (p->name() == name && p->isPost() == post && p->isFile() == file)
+      return p;
+  return nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(size_t num) const {
+  return num < _params.size() ? _params[num] : nullptr;
+}
+
+String AsyncWebServerRequest::arg(const String &name) const {
+  for (auto *p : _params)
+    if (p->name() == name)
+      return p->value();
+  return String();
+}
+
+bool AsyncWebServerRequest::hasArg(const char *name) const {
+  for (auto *p : _params)
+    if (p->name() == name)
+      return true;
+  return false;
+}
+
+// ── Handlers ──
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) {
+  if (!_onRequest)
+    return false;
+  if (!(_method & request->method()))
+    return false;
+  const String &url = request->url();
+  if (_uri.length() && _uri.startsWith("/*.")) {
+    if (!url.endsWith(_uri.substring(_uri.lastIndexOf('.'))))
+      return false;
+  } else if (_uri.length() && _uri.endsWith("*")) {
+    if (!url.startsWith(_uri.substring(0, _uri.length() - 1)))
+      return false;
+  } else if (_uri.length() && _uri != url && !url.startsWith(_uri + "/")) {
+    return false;
+  }
+  return true;
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest *request) {
+  if (_onRequest)
+    _onRequest(request);
+  else
+    request->send(500);
+}
+
+void AsyncCallbackWebHandler::handleUpload(AsyncWebServerRequest *request,
+                                           const String &filename,
+                                           size_t index, uint8_t *data,
+                                           size_t len, bool final) {
+  if (_onUpload)
+    _onUpload(request, filename, index, data, len, final);
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest *request,
+                                         uint8_t *data, size_t len,
+                                         size_t index, size_t total) {
+  if (_onBody)
+    _onBody(request, data, len, index, total);
+}
+
+AsyncStaticWebHandler::AsyncStaticWebHandler(const char *uri, fs::FS &fs,
+                                             const char *path,
+                                             const char *cacheControl)
+    : _uri(uri), _path(path), _cacheControl(cacheControl ? cacheControl : ""),
+      _fs(fs) {
+  if (!_uri.length() || _uri[0] != '/')
+    _uri = "/" + _uri;
+  if (!_path.length() || _path[0] != '/')
+    _path = "/" + _path;
+  _isDir = _path[_path.length() - 1] == '/';
+  // Root becomes "" so the default file can be appended.
+  if (_uri[_uri.length() - 1] == '/')
+    _uri = _uri.substring(0, _uri.length() - 1);
+  if (_path[_path.length() - 1] == '/')
+    _path = _path.substring(0, _path.length() - 1);
+}
+
+bool AsyncStaticWebHandler::fileExists(const String &path, String &outPath) {
+  for (const String &candidate : {path, path + ".gz"}) {
+    File f = _fs.open(candidate, "r");
+    if (f && !f.isDirectory()) {
+      outPath = path;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AsyncStaticWebHandler::getFile(AsyncWebServerRequest *request,
+                                    String &outPath) {
+  String path = request->url().substring(_uri.length());
+  bool canSkipFileCheck = (_isDir && path.length() == 0) ||
+                          (path.length() && path[path.length() - 1] == '/');
+  path = _path + path;
+  if (!canSkipFileCheck && fileExists(path, outPath))
+    return true;
+  if (!_defaultFile.length())
+    return false;
+  if (!path.length() || path[path.length() - 1] != '/')
+    path += "/";
+  path += _defaultFile;
+  return fileExists(path, outPath);
+}
+
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest *request) {
+  if (!(request->method() & (HTTP_GET | HTTP_HEAD)) ||
+      !request->url().startsWith(_uri))
+    return false;
+  String found;
+  if (!getFile(request, found))
+    return false;
+  if (request->_tempObject)
+    ::free(request->_tempObject);
+  request->_tempObject = strdup(found.c_str());
+  return true;
+}
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest *request) {
+  if (!request->_tempObject) {
+    request->send(404);
+    return;
+  }
+  String path = String((const char *)request->_tempObject);
+  ::free(request->_tempObject);
+  request->_tempObject = nullptr;
+
+  bool gz = !_fs.exists(path);
+  File f = _fs.open(gz ? path + ".gz" : path, "r");
+  String etag = String((unsigned long)f.size());
+  f.close();
+
+  if (_lastModified.length() &&
+      _lastModified == request->header("If-Modified-Since")) {
+    request->send(304);
+  } else if (_cacheControl.length() && request->hasHeader("If-None-Match") &&
+             request->header("If-None-Match").equals(etag)) {
+    AsyncWebServerResponse *response = new AsyncBasicResponse(304);
+    response->addHeader("Cache-Control", _cacheControl);
+    response->addHeader("ETag", etag);
+    request->send(response);
+  } else {
+    AsyncWebServerResponse *response = new AsyncFileResponse(_fs, path);
+    if (_lastModified.length())
+      response->addHeader("Last-Modified", _lastModified);
+    if (_cacheControl.length()) {
+      response->addHeader("Cache-Control", _cacheControl);
+      response->addHeader("ETag", etag);
+    }
+    request->send(response);
+  }
+}
+
+// ── WebSocket client ──
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncClient *client,
+                                           AsyncWebSocket *server, uint32_t id)
+    : _client(client), _server(server), _id(id),
+      _remoteIp(client->remoteIP()), _remotePort(client->remotePort()) {
+  client->setRxTimeout(0);
+  client->onData(
+      [](void *arg, AsyncClient *, void *data, size_t len) {
+        ((AsyncWebSocketClient *)arg)->hostOnData((const uint8_t *)data, len);
+      },
+      this);
+  client->onAck(
+      [](void *arg, AsyncClient *, size_t len, uint32_t) {
+        ((AsyncWebSocketClient *)arg)->hostOnAck(len);
+      },
+      this);
+  client->onTimeout(nullptr, nullptr);
+  client->onDisconnect(
+      [](void *arg, AsyncClient *) {
+        ((AsyncWebSocketClient *)arg)->hostOnDisconnect();
+      },
+      this);
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() {
+  if (_client) {
+    AsyncClient *c = _client;
+    _client = nullptr;
+    c->onDisconnect(nullptr, nullptr);
+    delete c;
+  }
+}
+
+bool AsyncWebSocketClient::queueIsFull() const {
+  AsyncLock lk(hostAsyncLock());
+  return _status != WS_CONNECTED || _inflight.size() >= WS_MAX_QUEUED_MESSAGES;
+}
+
+size_t AsyncWebSocketClient::queueLen() const {
+  AsyncLock lk(hostAsyncLock());
+  return _inflight.size();
+}
+
+bool AsyncWebSocketClient::queueFrame(uint8_t opcode, const uint8_t *data,
+                                      size_t len, bool control) {
+  AsyncLock lk(hostAsyncLock());
+  if (!_client || _status == WS_DISCONNECTED)
+    return false;
+  if (!control && _status != WS_CONNECTED)
+    return false;
+  if (!control && _inflight.size() >= WS_MAX_QUEUED_MESSAGES) {
+    fprintf(stderr, "ERROR: Too many messages queued\n");
+    return false;
+  }
+  std::string frame;
+  frame.reserve(len + 10);
+  frame.push_back((char)(0x80 | opcode));
+  if (len < 126) {
+    frame.push_back((char)len);
+  } else if (len < 65536) {
+    frame.push_back((char)126);
+    frame.push_back((char)(len >> 8));
+    frame.push_back((char)len);
+  } else {
+    frame.push_back((char)127);
+    for (int i = 7; i >= 0; i--)
+      frame.push_back((char)((uint64_t)len >> (8 * i)));
+  }
+  if (len)
+    frame.append((const char *)data, len);
+  if (_client->write(frame.data(), frame.size()) != frame.size())
+    return false;
+  _inflight.push_back(frame.size());
+  return true;
+}
+
+void AsyncWebSocketClient::hostOnAck(size_t len) {
+  while (len && !_inflight.empty()) {
+    size_t n = std::min(len, _inflight.front());
+    _inflight.front() -= n;
+    len -= n;
+    if (!_inflight.front())
+      _inflight.pop_front();
+  }
+}
+
+void AsyncWebSocketClient::text(const char *message, size_t len) {
+  queueFrame(WS_TEXT, (const uint8_t *)message, len, false);
+}
+
+void AsyncWebSocketClient::text(const char *message) {
+  if (message)
+    text(message, strlen(message));
+}
+
+void AsyncWebSocketClient::text(const String &message) {
+  text(message.c_str(), message.length());
+}
+
+void AsyncWebSocketClient::binary(const uint8_t *message, size_t len) {
+  queueFrame(WS_BINARY, message, len, false);
+}
+
+void AsyncWebSocketClient::ping(const uint8_t *data, size_t len) {
+  if (_status == WS_CONNECTED)
+    queueFrame(WS_PING, data, std::min(len, (size_t)125), true);
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char *message) {
+  AsyncLock lk(hostAsyncLock());
+  if (_status != WS_CONNECTED || !_client)
+    return;
+  std::string payload;
+  if (code) {
+    payload.push_back((char)(code >> 8));
+    payload.push_back((char)code);
+    if (message)
+      payload.append(message, std::min(strlen(message), (size_t)123));
+  }
+  queueFrame(WS_DISCONNECT, (const uint8_t *)payload.data(), payload.size(),
+             true);
+  _status = WS_DISCONNECTING;
+  if (_client)
+    _client->close(false);
+}
+
+void AsyncWebSocketClient::hostOnData(const uint8_t *data, size_t len) {
+  _rx.append((const char *)data, len);
+  while (_client && _rx.size() >= 2) {
+    const uint8_t *p = (const uint8_t *)_rx.data();
+    bool fin = p[0] & 0x80;
+    uint8_t opcode = p[0] & 0x0F;
+    bool masked = p[1] & 0x80;
+    uint64_t plen = p[1] & 0x7F;
+    size_t hdr = 2;
+    if (plen == 126) {
+      if (_rx.size() < 4)
+        return;
+      plen = (p[2] << 8) | p[3];
+      hdr = 4;
+    } else if (plen == 127) {
+      if (_rx.size() < 10)
+        return;
+      plen = 0;
+      for (int i = 0; i < 8; i++)
+        plen = (plen << 8) | p[2 + i];
+      hdr = 10;
+    }
+    if (plen > kMaxWsFrame) {
+      _client->close(true);
+      return;
+    }
+    uint8_t mask[4] = {0, 0, 0, 0};
+    if (masked) {
+      if (_rx.size() < hdr + 4)
+        return;
+      memcpy(mask, p + hdr, 4);
+      hdr += 4;
+    }
+    if (_rx.size() < hdr + plen)
+      return;
+
+    // One spare byte so text payloads can be NUL terminated in place.
+    std::string payload = _rx.substr(hdr, plen);
+    _rx.erase(0, hdr + plen);
+    for (size_t i = 0; masked && i < payload.size(); i++)
+      payload[i] ^= mask[i & 3];
+    payload.push_back('\0');
+    uint8_t *buf = (uint8_t *)&payload[0];
+
+    if (opcode == WS_DISCONNECT) {
+      if (_status == WS_DISCONNECTING) {
+        _client->close(true);
+      } else {
+        _status = WS_DISCONNECTING;
+        queueFrame(WS_DISCONNECT, buf, std::min((size_t)plen, (size_t)2),
+                   true);
+        if (_client)
+          _client->close(false);
+      }
+      return;
+    }
+    if (opcode == WS_PING) {
+      queueFrame(WS_PONG, buf, plen, true);
+      continue;
+    }
+    if (opcode == WS_PONG) {
+      _server->hostHandleEvent(this, WS_EVT_PONG, nullptr, buf, plen);
+      continue;
+    }
+
+    AwsFrameInfo info;
+    memset(&info, 0, sizeof(info));
+    info.opcode = opcode;
+    info.final = fin ? 1 : 0;
+    info.masked = masked ? 1 : 0;
+    memcpy(info.mask, mask, 4);
+    info.len = plen;
+    info.index = 0;
+    if (opcode == WS_CONTINUATION) {
+      info.message_opcode = _lastMessageOpcode;
+      info.num = ++_fragment;
+    } else {
+      _lastMessageOpcode = opcode;
+      _fragment = 0;
+      info.message_opcode = opcode;
+      info.num = 0;
+    }
+    _server->hostHandleEvent(this, WS_EVT_DATA, &info, buf, plen);
+  }
+}
+
+void AsyncWebSocketClient::hostOnDisconnect() {
+  AsyncClient *c = _client;
+  _client = nullptr;
+  _status = WS_DISCONNECTED;
+  _inflight.clear();
+  _server->hostHandleEvent(this, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  delete c;
+}
+
+// ── WebSocket server ──
+
+AsyncWebSocket::AsyncWebSocket(const String &url) : _url(url) {}
+
+AsyncWebSocket::~AsyncWebSocket() {
+  AsyncLock lk(hostAsyncLock());
+  _clients.clear();
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest *request) {
+  if (!_enabled || request->method() != HTTP_GET || request->url() != _url)
+    return false;
+  String upgrade = request->header("Upgrade");
+  return upgrade.equalsIgnoreCase("websocket");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest *request) {
+  if (!request->hasHeader("Sec-WebSocket-Version") ||
+      !request->hasHeader("Sec-WebSocket-Key")) {
+    request->send(400);
+    return;
+  }
+  std::string key = request->header("Sec-WebSocket-Key").str() +
+                    "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  uint8_t digest[20];
+  hostSha1((const uint8_t *)key.data(), key.size(), digest);
+
+  std::string head = "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " +
+                     hostBase64(digest, sizeof(digest)) + "\r\n";
+  if (request->hasHeader("Sec-WebSocket-Protocol")) {
+    String proto = request->header("Sec-WebSocket-Protocol");
+    int comma = proto.indexOf(',');
+    if (comma >= 0)
+      proto = proto.substring(0, comma);
+    proto.trim();
+    head += "Sec-WebSocket-Protocol: " + proto.str() + "\r\n";
+  }
+  head += "\r\n";
+
+  AsyncClient *c = request->client();
+  c->write(head.data(), head.size());
+  request->hostDetachClient();
+
+  _clients.emplace_back(c, this, _nextId++);
+  AsyncWebSocketClient *client = &_clients.back();
+  hostHandleEvent(client, WS_EVT_CONNECT, request, nullptr, 0);
+}
+
+void AsyncWebSocket::hostHandleEvent(AsyncWebSocketClient *client,
+                                     AwsEventType type, void *arg,
+                                     uint8_t *data, size_t len) {
+  if (_eventHandler)
+    _eventHandler(this, client, type, arg, data, len);
+}
+
+size_t AsyncWebSocket::count() const {
+  AsyncLock lk(hostAsyncLock());
+  size_t n = 0;
+  for (auto &c : _clients)
+    if (c.status() == WS_CONNECTED)
+      n++;
+  return n;
+}
+
+AsyncWebSocketClient *AsyncWebSocket::client(uint32_t id) {
+  AsyncLock lk(hostAsyncLock());
+  for (auto &c : _clients)
+    if (c.id() == id && c.status() == WS_CONNECTED)
+      return &c;
+  return nullptr;
+}
+
+bool AsyncWebSocket::availableForWriteAll() {
+  AsyncLock lk(hostAsyncLock());
+  for (auto &c : _clients)
+    if (c.queueIsFull())
+      return false;
+  return true;
+}
+
+bool AsyncWebSocket::availableForWrite(uint32_t id) {
+  AsyncWebSocketClient *c = client(id);
+  return c && !c->queueIsFull();
+}
+
+void AsyncWebSocket::close(uint32_t id, uint16_t code, const char *message) {
+  AsyncLock lk(hostAsyncLock());
+  if (AsyncWebSocketClient *c = client(id))
+    c->close(code, message);
+}
+
+void AsyncWebSocket::closeAll(uint16_t code, const char *message) {
+  AsyncLock lk(hostAsyncLock());
+  for (auto &c : _clients)
+    if (c.status() == WS_CONNECTED)
+      c.close(code, message);
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+  AsyncLock lk(hostAsyncLock());
+  if (count() > maxClients) {
+    for (auto &c : _clients) {
+      if (c.status() == WS_CONNECTED) {
+        c.close();
+        break;
+      }
+    }
+  }
+  for (auto it = _clients.begin(); it != _clients.end();) {
+    if (it->status() == WS_DISCONNECTED)
+      it = _clients.erase(it);
+    else
+      ++it;
+  }
+}
+
+void AsyncWebSocket::ping(uint32_t id, const uint8_t *data, size_t len) {
+  AsyncLock lk(hostAsyncLock());
+  if (AsyncWebSocketClient *c = client(id))
+    c->ping(data, len);
+}
+
+void AsyncWebSocket::pingAll(const uint8_t *data, size_t len) {
+  AsyncLock lk(hostAsyncLock());
+  for (auto &c : _clients)
+    if (c.status() == WS_CONNECTED)
+      c.ping(data, len);
+}
+
+void AsyncWebSocket::text(uint32_t id, const char *message, size_t len) {
+  AsyncLock lk(hostAsyncLock());
+  if (AsyncWebSocketClient *c = client(id))
+    c->text(message, len);
+}
+
+void AsyncWebSocket::text(uint32_t id, const char *message) {
+  if (message)
+    text(id, message, strlen(message));
+}
+
+void AsyncWebSocket::text(uint32_t id, const String &message) {
+  text(id, message.c_str(), message.length());
+}
+
+void AsyncWebSocket::textAll(const char *message, size_t len) {
+  AsyncLock lk(hostAsyncLock());
+  for (auto &c : _clients)
+    if (c.status() == WS_CONNECTED)
+      c.text(message, len);
+}
+
+void AsyncWebSocket::textAll(const char *message) {
+  if (message)
+    textAll(message, strlen(message));
+}
+
+void AsyncWebSocket::textAll(const String &message) {
+  textAll(message.c_str(), message.length());
+}
+
+void AsyncWebSocket::binary(uint32_t id, const uint8_t *message, size_t len) {
+  AsyncLock lk(hostAsyncLock());
+  if (AsyncWebSocketClient *c = client(id))
+    c->binary(message, len);
+}
+
+void AsyncWebSocket::binaryAll(const uint8_t *message, size_t len) {
+  AsyncLock lk(hostAsyncLock());
+  for (auto &c : _clients)
+    if (c.status() == WS_CONNECTED)
+      c.binary(message, len);
+}
+
+// ── Server ──
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _server(port) {
+  _server.onClient(
+      [](void *arg, AsyncClient *c) {
+        if (!c)
+          return;
+        new AsyncWebServerRequest((AsyncWebServer *)arg, c);
+      },
+      this);
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  end();
+  for (auto *h : _owned)
+    delete h;
+}
+
+void AsyncWebServer::begin() {
+  _server.setNoDelay(true);
+  _server.begin();
+}
+
+void AsyncWebServer::end() { _server.end(); }
+
+AsyncWebHandler &AsyncWebServer::addHandler(AsyncWebHandler *handler) {
+  AsyncLock lk(hostAsyncLock());
+  _handlers.push_back(handler);
+  return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler *handler) {
+  AsyncLock lk(hostAsyncLock());
+  for (auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+    if (*it == handler) {
+      _handlers.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+AsyncCallbackWebHandler &
+AsyncWebServer::on(const char *uri, ArRequestHandlerFunction onRequest) {
+  return on(uri, HTTP_ANY, onRequest);
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri,
+                                            WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest) {
+  return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri,
+                                            WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload) {
+  return on(uri, method, onRequest, onUpload, nullptr);
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri,
+                                            WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload,
+                                            ArBodyHandlerFunction onBody) {
+  AsyncCallbackWebHandler *handler = new AsyncCallbackWebHandler();
+  handler->setUri(uri);
+  handler->setMethod(method);
+  handler->onRequest(onRequest);
+  handler->onUpload(onUpload);
+  handler->onBody(onBody);
+  _owned.push_back(handler);
+  addHandler(handler);
+  return *handler;
+}
+
+AsyncStaticWebHandler &AsyncWebServer::serveStatic(const char *uri,
+                                                   fs::FS &fs,
+                                                   const char *path,
+                                                   const char *cacheControl) {
+  AsyncStaticWebHandler *handler =
+      new AsyncStaticWebHandler(uri, fs, path, cacheControl);
+  _owned.push_back(handler);
+  addHandler(handler);
+  return *handler;
+}
+
+void AsyncWebServer::reset() {
+  AsyncLock lk(hostAsyncLock());
+  _handlers.clear();
+  _notFound = nullptr;
+}
+
+AsyncWebHandler *AsyncWebServer::hostFindHandler(AsyncWebServerRequest *request) {
+  for (auto *h : _handlers)
+    if (h->filter(request) && h->canHandle(request))
+      return h;
+  return nullptr;
+}
+
+void AsyncWebServer::hostNotFound(AsyncWebServerRequest *request) {
+  if (_notFound)
+    _notFound(request);
+  else
+    request->send(404);
+}
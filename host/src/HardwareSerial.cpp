@@ -0,0 +1,186 @@
+#include <Arduino.h>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+#include "HostRuntime.h"
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+void HardwareSerial::openPty() {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    perror("[host] posix_openpt");
+    if (fd >= 0)
+      close(fd);
+    return;
+  }
+  const char *slave = ptsname(fd);
+  snprintf(_ptyPath, sizeof(_ptyPath), "%s", slave ? slave : "");
+
+  // Raw mode on the slave side so bytes pass through untouched, as on a UART.
+  int sfd = open(_ptyPath, O_RDWR | O_NOCTTY);
+  if (sfd >= 0) {
+    struct termios tio;
+    if (tcgetattr(sfd, &tio) == 0) {
+      cfmakeraw(&tio);
+      tcsetattr(sfd, TCSANOW, &tio);
+    }
+    close(sfd);
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  _fd = fd;
+
+  const char *link = hostEnv("AVTOOL_SERIAL2_LINK", "");
+  if (*link) {
+    unlink(link);
+    if (symlink(_ptyPath, link) != 0)
+      perror("[host] symlink AVTOOL_SERIAL2_LINK");
+  }
+  fprintf(stderr, "[host] Serial%d on %s%s%s\n", _uartNum, _ptyPath,
+          *link ? " -> " : "", link);
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t, int8_t, int8_t, bool,
+                           unsigned long) {
+  _baud = baud;
+  if (_uartNum == 0 || _fd >= 0)
+    return;
+  openPty();
+}
+
+// The pty stays open across end()/begin() so an attached terminal survives
+// baud changes and auto-baud scans.
+void HardwareSerial::end() { _peek = -1; }
+
+size_t HardwareSerial::setRxBufferSize(size_t size) {
+  _rxBufferSize = size;
+  return size;
+}
+
+size_t HardwareSerial::setTxBufferSize(size_t size) { return size; }
+
+void HardwareSerial::updateBaudRate(unsigned long baud) { _baud = baud; }
+
+void HardwareSerial::onReceive(OnReceiveCb function, bool) {
+  _onReceive = function;
+  startEventThread();
+}
+
+void HardwareSerial::onReceiveError(OnReceiveErrorCb function) {
+  _onReceiveError = function;
+  startEventThread();
+}
+
+// Stands in for the core's uart event task. Fires once per arrival, then
+// waits for the reader to drain before firing again.
+void HardwareSerial::startEventThread() {
+  if (_eventThread || _uartNum == 0)
+    return;
+  _eventThread = true;
+  std::thread([this] {
+    bool full = false;
+    for (;;) {
+      if (_fd < 0) {
+        usleep(20000);
+        continue;
+      }
+      struct pollfd p = {_fd, POLLIN, 0};
+      if (poll(&p, 1, 20) <= 0)
+        continue;
+      if (!(p.revents & POLLIN)) {
+        usleep(20000); // POLLHUP while no terminal is attached
+        continue;
+      }
+      int n = available();
+      if ((size_t)n > _rxBufferSize) {
+        if (!full && _onReceiveError)
+          _onReceiveError(UART_BUFFER_FULL_ERROR);
+        full = true;
+      } else {
+        full = false;
+      }
+      if (_onReceive)
+        _onReceive();
+      // Data stays readable until consumed; don't spin on it.
+      usleep(1000);
+    }
+  }).detach();
+}
+
+int HardwareSerial::available() {
+  if (_fd < 0)
+    return 0;
+  int n = 0;
+  if (ioctl(_fd, FIONREAD, &n) != 0)
+    n = 0;
+  return n + (_peek >= 0 ? 1 : 0);
+}
+
+int HardwareSerial::availableForWrite() { return _fd >= 0 || _uartNum == 0 ? 128 : 0; }
+
+int HardwareSerial::peek() {
+  if (_peek < 0)
+    _peek = read();
+  return _peek;
+}
+
+int HardwareSerial::read() {
+  if (_peek >= 0) {
+    int c = _peek;
+    _peek = -1;
+    return c;
+  }
+  uint8_t b;
+  if (_fd < 0 || ::read(_fd, &b, 1) != 1)
+    return -1;
+  return b;
+}
+
+size_t HardwareSerial::read(uint8_t *buffer, size_t size) {
+  size_t got = 0;
+  if (size && _peek >= 0) {
+    buffer[got++] = (uint8_t)_peek;
+    _peek = -1;
+  }
+  if (_fd < 0 || got >= size)
+    return got;
+  ssize_t n = ::read(_fd, buffer + got, size - got);
+  if (n > 0)
+    got += (size_t)n;
+  return got;
+}
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  int fd = _uartNum == 0 ? STDOUT_FILENO : _fd;
+  if (fd < 0)
+    return 0;
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::write(fd, buffer + done, size - done);
+    if (n > 0) {
+      done += (size_t)n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      // Nobody is draining the pty: drop like a UART with no reader would.
+      if (_uartNum != 0)
+        break;
+    } else {
+      break;
+    }
+  }
+  return done;
+}
+
+void HardwareSerial::flush() {
+  if (_uartNum == 0)
+    fflush(stdout);
+}
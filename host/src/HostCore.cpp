@@ -0,0 +1,459 @@
+// Host build runtime: time base, FreeRTOS primitives on pthreads, ESP class
+// and the process entry point that drives setup()/loop().
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <malloc.h>
+#include <mutex>
+#include <pthread.h>
+#include <random>
+#include <sys/random.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "HostRuntime.h"
+
+// ── Time ──
+
+static const auto hostEpoch = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long)(uint32_t)std::chrono::duration_cast<
+             std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                        hostEpoch)
+      .count();
+}
+
+unsigned long micros() {
+  return (unsigned long)(uint32_t)std::chrono::duration_cast<
+             std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                        hostEpoch)
+      .count();
+}
+
+int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - hostEpoch)
+      .count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() { std::this_thread::yield(); }
+
+// ── Misc Arduino ──
+
+static std::mt19937 &rng() {
+  static std::mt19937 gen(std::random_device{}());
+  return gen;
+}
+
+long random(long max) { return max <= 0 ? 0 : (long)(rng()() % max); }
+long random(long min, long max) {
+  return max <= min ? min : min + random(max - min);
+}
+void randomSeed(unsigned long seed) { rng().seed(seed); }
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+
+uint32_t esp_random() {
+  uint32_t v;
+  if (getrandom(&v, sizeof(v), 0) != sizeof(v))
+    v = rng()();
+  return v;
+}
+
+void esp_fill_random(void *buf, size_t len) {
+  uint8_t *p = (uint8_t *)buf;
+  while (len) {
+    uint32_t v = esp_random();
+    size_t n = std::min(len, sizeof(v));
+    memcpy(p, &v, n);
+    p += n;
+    len -= n;
+  }
+}
+
+// ── ESP ──
+
+EspClass ESP;
+
+// The firmware reasons about heap in ESP32 terms (~300 KB). Report the
+// allocator's view of in-use memory against a nominal ESP32 heap so that
+// low-heap guards keep working and leaks are visible in /api/health.
+static const uint32_t hostNominalHeap = 320 * 1024;
+static uint32_t hostMinFreeHeap = hostNominalHeap;
+
+uint32_t EspClass::getHeapSize() { return hostNominalHeap; }
+
+uint32_t EspClass::getFreeHeap() {
+  struct mallinfo2 mi = mallinfo2();
+  size_t used = mi.uordblks + mi.hblkhd;
+  size_t base = hostRuntimeBaselineHeap();
+  size_t delta = used > base ? used - base : 0;
+  uint32_t freeHeap =
+      delta >= hostNominalHeap ? 0 : hostNominalHeap - (uint32_t)delta;
+  if (freeHeap < hostMinFreeHeap)
+    hostMinFreeHeap = freeHeap;
+  return freeHeap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  getFreeHeap();
+  return hostMinFreeHeap;
+}
+
+uint32_t EspClass::getMaxAllocHeap() { return getFreeHeap(); }
+
+uint64_t EspClass::getEfuseMac() { return 0x0000AABBCCDDEEFFULL; }
+
+void EspClass::restart() { hostRuntimeRestart(); }
+
+// ── FreeRTOS: tasks ──
+
+struct HostTask {
+  pthread_t thread;
+  TaskFunction_t fn;
+  void *param;
+  char name[16];
+  std::mutex notifyMutex;
+  std::condition_variable notifyCv;
+  uint32_t notifyCount = 0;
+};
+
+static thread_local HostTask *currentTask = nullptr;
+
+static void *taskTrampoline(void *arg) {
+  HostTask *t = static_cast<HostTask *>(arg);
+  currentTask = t;
+  pthread_setname_np(pthread_self(), t->name);
+  t->fn(t->param);
+  // Returning from a FreeRTOS task is a bug on target; mirror that loudly.
+  fprintf(stderr, "[host] task '%s' returned without vTaskDelete\n", t->name);
+  abort();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t, void *param, UBaseType_t,
+                                   TaskHandle_t *handle, BaseType_t) {
+  HostTask *t = new HostTask();
+  t->fn = fn;
+  t->param = param;
+  snprintf(t->name, sizeof(t->name), "%s", name ? name : "task");
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  int rc = pthread_create(&t->thread, &attr, taskTrampoline, t);
+  pthread_attr_destroy(&attr);
+  if (rc != 0) {
+    delete t;
+    return pdFAIL;
+  }
+  if (handle)
+    *handle = t;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                       void *param, UBaseType_t priority,
+                       TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle,
+                                 tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr || task == currentTask) {
+    // Task objects are intentionally leaked: other tasks may still hold the
+    // handle for notifications, exactly as on target until the idle task
+    // reclaims it.
+    pthread_exit(nullptr);
+  }
+  pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment) {
+  TickType_t target = *previousWakeTime + increment;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(target - now) > 0)
+    delay(target - now);
+  *previousWakeTime = target;
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return currentTask; }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 4096; }
+void taskYIELD() { std::this_thread::yield(); }
+
+template <typename Pred>
+static bool waitTicks(std::condition_variable &cv,
+                      std::unique_lock<std::mutex> &lk, TickType_t ticks,
+                      Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lk, pred);
+    return true;
+  }
+  return cv.wait_for(lk, std::chrono::milliseconds(ticks), pred);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit,
+                          TickType_t ticksToWait) {
+  HostTask *t = currentTask;
+  if (!t) {
+    delay(ticksToWait == portMAX_DELAY ? 1 : ticksToWait);
+    return 0;
+  }
+  std::unique_lock<std::mutex> lk(t->notifyMutex);
+  waitTicks(t->notifyCv, lk, ticksToWait, [t] { return t->notifyCount > 0; });
+  uint32_t v = t->notifyCount;
+  if (v)
+    t->notifyCount = clearCountOnExit ? 0 : v - 1;
+  return v;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+  if (!task)
+    return;
+  {
+    std::lock_guard<std::mutex> lk(task->notifyMutex);
+    task->notifyCount++;
+  }
+  task->notifyCv.notify_one();
+}
+
+// ── FreeRTOS: critical sections, semaphores, queues ──
+
+struct HostMux {
+  std::recursive_mutex m;
+};
+
+static std::mutex muxInitLock;
+
+static HostMux *muxImpl(portMUX_TYPE *mux) {
+  std::lock_guard<std::mutex> lk(muxInitLock);
+  if (!mux->impl)
+    mux->impl = new HostMux();
+  return mux->impl;
+}
+
+void hostMuxEnter(portMUX_TYPE *mux) { muxImpl(mux)->m.lock(); }
+void hostMuxExit(portMUX_TYPE *mux) { muxImpl(mux)->m.unlock(); }
+
+struct HostSemaphore {
+  enum Kind { Mutex, Recursive, Counting } kind;
+  std::mutex m;
+  std::condition_variable cv;
+  UBaseType_t count = 0;
+  UBaseType_t maxCount = 1;
+  pthread_t owner{};
+  UBaseType_t depth = 0;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  HostSemaphore *s = new HostSemaphore();
+  s->kind = HostSemaphore::Mutex;
+  s->count = 1;
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  HostSemaphore *s = xSemaphoreCreateMutex();
+  s->kind = HostSemaphore::Recursive;
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount,
+                                           UBaseType_t initialCount) {
+  HostSemaphore *s = new HostSemaphore();
+  s->kind = HostSemaphore::Counting;
+  s->maxCount = maxCount;
+  s->count = initialCount;
+  return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lk(s->m);
+  if (!waitTicks(s->cv, lk, ticksToWait, [s] { return s->count > 0; }))
+    return pdFALSE;
+  s->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  {
+    std::lock_guard<std::mutex> lk(s->m);
+    if (s->count >= s->maxCount)
+      return pdFALSE;
+    s->count++;
+  }
+  s->cv.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s,
+                                   TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lk(s->m);
+  pthread_t self = pthread_self();
+  if (s->depth && pthread_equal(s->owner, self)) {
+    s->depth++;
+    return pdTRUE;
+  }
+  if (!waitTicks(s->cv, lk, ticksToWait, [s] { return s->count > 0; }))
+    return pdFALSE;
+  s->count--;
+  s->owner = self;
+  s->depth = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s) {
+  {
+    std::lock_guard<std::mutex> lk(s->m);
+    if (!s->depth || !pthread_equal(s->owner, pthread_self()))
+      return pdFALSE;
+    if (--s->depth)
+      return pdTRUE;
+    s->count++;
+  }
+  s->cv.notify_one();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+struct HostQueue {
+  std::mutex m;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  HostQueue *q = new HostQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item,
+                      TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lk(q->m);
+  if (!waitTicks(q->notFull, lk, ticksToWait,
+                 [q] { return q->items.size() < q->length; }))
+    return pdFALSE;
+  const uint8_t *p = static_cast<const uint8_t *>(item);
+  q->items.emplace_back(p, p + q->itemSize);
+  lk.unlock();
+  q->notEmpty.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lk(q->m);
+  if (!waitTicks(q->notEmpty, lk, ticksToWait,
+                 [q] { return !q->items.empty(); }))
+    return pdFALSE;
+  memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  lk.unlock();
+  q->notFull.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  {
+    std::lock_guard<std::mutex> lk(q->m);
+    q->items.clear();
+  }
+  q->notFull.notify_all();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lk(q->m);
+  return (UBaseType_t)q->items.size();
+}
+
+void vQueueDelete(QueueHandle_t q) { delete q; }
+
+// ── Entry point ──
+
+static int hostArgc = 0;
+static char **hostArgv = nullptr;
+static size_t hostBaselineHeap = 0;
+
+size_t hostRuntimeBaselineHeap() { return hostBaselineHeap; }
+
+void hostRuntimeRestart() {
+  fflush(stdout);
+  fprintf(stderr, "[host] ESP.restart(): re-executing %s\n", hostArgv[0]);
+  execv("/proc/self/exe", hostArgv);
+  perror("[host] execv");
+  _exit(1);
+}
+
+const char *hostEnv(const char *name, const char *fallback) {
+  const char *v = getenv(name);
+  return (v && *v) ? v : fallback;
+}
+
+uint16_t hostMapListenPort(uint16_t port) {
+  static const long offset =
+      geteuid() == 0 ? 0 : strtol(hostEnv("AVTOOL_PORT_OFFSET", "8000"), nullptr, 10);
+  if (port == 0 || port >= 1024 || offset <= 0)
+    return port;
+  uint16_t mapped = (uint16_t)(port + offset);
+  fprintf(stderr, "[host] privileged port %u mapped to %u\n", port, mapped);
+  return mapped;
+}
+
+void hostRuntimeShutdown() { fflush(stdout); }
+
+int main(int argc, char **argv) {
+  hostArgc = argc;
+  hostArgv = argv;
+  signal(SIGPIPE, SIG_IGN);
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+
+  struct mallinfo2 mi = mallinfo2();
+  hostBaselineHeap = mi.uordblks + mi.hblkhd;
+
+  // The Arduino loopTask spins loop() back to back. On the host a 1 ms nap
+  // keeps an idle instance off 100% CPU; set AVTOOL_LOOP_US=0 to spin.
+  long loopUs = strtol(hostEnv("AVTOOL_LOOP_US", "1000"), nullptr, 10);
+  long maxLoops = strtol(hostEnv("AVTOOL_MAX_LOOPS", "0"), nullptr, 10);
+
+  setup();
+  for (long n = 0; maxLoops <= 0 || n < maxLoops; n++) {
+    loop();
+    if (loopUs > 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(loopUs));
+  }
+  hostRuntimeShutdown();
+  return 0;
+}
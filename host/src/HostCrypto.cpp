@@ -0,0 +1,202 @@
+// MD5 (RFC 1321), SHA-1 (RFC 3174) and base64, enough for MD5Builder and the
+// WebSocket accept key.
+
+#include <MD5Builder.h>
+
+#include "HostCrypto.h"
+
+namespace {
+
+inline uint32_t rol(uint32_t v, int s) { return (v << s) | (v >> (32 - s)); }
+
+const uint32_t kMd5K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+const int kMd5S[64] = {7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7,
+                       12, 17, 22, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,
+                       14, 20, 5,  9, 14, 20, 4,  11, 16, 23, 4,  11, 16,
+                       23, 4,  11, 16, 23, 4,  11, 16, 23, 6,  10, 15, 21,
+                       6,  10, 15, 21, 6,  10, 15, 21, 6,  10, 15, 21};
+
+} // namespace
+
+// ── MD5Builder ──
+
+void MD5Builder::begin() {
+  _state[0] = 0x67452301;
+  _state[1] = 0xefcdab89;
+  _state[2] = 0x98badcfe;
+  _state[3] = 0x10325476;
+  _bytes = 0;
+  _bufLen = 0;
+  memset(_digest, 0, sizeof(_digest));
+}
+
+void MD5Builder::block(const uint8_t *p) {
+  uint32_t m[16];
+  for (int i = 0; i < 16; i++)
+    m[i] = p[i * 4] | (p[i * 4 + 1] << 8) | (p[i * 4 + 2] << 16) |
+           ((uint32_t)p[i * 4 + 3] << 24);
+  uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+  for (int i = 0; i < 64; i++) {
+    uint32_t f;
+    int g;
+    if (i < 16) {
+      f = (b & c) | (~b & d);
+      g = i;
+    } else if (i < 32) {
+      f = (d & b) | (~d & c);
+      g = (5 * i + 1) % 16;
+    } else if (i < 48) {
+      f = b ^ c ^ d;
+      g = (3 * i + 5) % 16;
+    } else {
+      f = c ^ (b | ~d);
+      g = (7 * i) % 16;
+    }
+    uint32_t t = d;
+    d = c;
+    c = b;
+    b = b + rol(a + f + kMd5K[i] + m[g], kMd5S[i]);
+    a = t;
+  }
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+}
+
+void MD5Builder::add(const uint8_t *data, size_t len) {
+  _bytes += len;
+  while (len) {
+    size_t n = std::min(len, sizeof(_buf) - _bufLen);
+    memcpy(_buf + _bufLen, data, n);
+    _bufLen += n;
+    data += n;
+    len -= n;
+    if (_bufLen == sizeof(_buf)) {
+      block(_buf);
+      _bufLen = 0;
+    }
+  }
+}
+
+void MD5Builder::addHexString(const char *data) {
+  size_t len = strlen(data) / 2;
+  for (size_t i = 0; i < len; i++) {
+    char pair[3] = {data[i * 2], data[i * 2 + 1], 0};
+    uint8_t b = (uint8_t)strtoul(pair, nullptr, 16);
+    add(&b, 1);
+  }
+}
+
+void MD5Builder::calculate() {
+  uint64_t bits = _bytes * 8;
+  uint8_t pad = 0x80;
+  add(&pad, 1);
+  pad = 0;
+  while (_bufLen != 56)
+    add(&pad, 1);
+  uint8_t lenBytes[8];
+  for (int i = 0; i < 8; i++)
+    lenBytes[i] = (uint8_t)(bits >> (8 * i));
+  add(lenBytes, 8);
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 4; j++)
+      _digest[i * 4 + j] = (uint8_t)(_state[i] >> (8 * j));
+}
+
+void MD5Builder::getChars(char *output) const {
+  for (int i = 0; i < 16; i++)
+    sprintf(output + i * 2, "%02x", _digest[i]);
+}
+
+String MD5Builder::toString() const {
+  char out[33];
+  getChars(out);
+  return String(out);
+}
+
+// ── SHA-1 / base64 ──
+
+void hostSha1(const uint8_t *data, size_t len, uint8_t out[20]) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                   0xC3D2E1F0};
+  std::string msg((const char *)data, len);
+  uint64_t bits = (uint64_t)len * 8;
+  msg.push_back((char)0x80);
+  while (msg.size() % 64 != 56)
+    msg.push_back(0);
+  for (int i = 7; i >= 0; i--)
+    msg.push_back((char)(bits >> (8 * i)));
+
+  for (size_t off = 0; off < msg.size(); off += 64) {
+    const uint8_t *p = (const uint8_t *)msg.data() + off;
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+      w[i] = ((uint32_t)p[i * 4] << 24) | (p[i * 4 + 1] << 16) |
+             (p[i * 4 + 2] << 8) | p[i * 4 + 3];
+    for (int i = 16; i < 80; i++)
+      w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rol(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+  for (int i = 0; i < 5; i++)
+    for (int j = 0; j < 4; j++)
+      out[i * 4 + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+}
+
+std::string hostBase64(const uint8_t *data, size_t len) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve((len + 2) / 3 * 4);
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t v = data[i] << 16;
+    if (i + 1 < len)
+      v |= data[i + 1] << 8;
+    if (i + 2 < len)
+      v |= data[i + 2];
+    out.push_back(kAlphabet[(v >> 18) & 63]);
+    out.push_back(kAlphabet[(v >> 12) & 63]);
+    out.push_back(i + 1 < len ? kAlphabet[(v >> 6) & 63] : '=');
+    out.push_back(i + 2 < len ? kAlphabet[v & 63] : '=');
+  }
+  return out;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Digest helpers for the host WebSocket handshake.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+void hostSha1(const uint8_t *data, size_t len, uint8_t out[20]);
+std::string hostBase64(const uint8_t *data, size_t len);
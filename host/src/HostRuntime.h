@@ -0,0 +1,25 @@
+#pragma once
+
+// Internal glue shared by the host shim translation units.
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// getenv() with a fallback for unset or empty variables.
+const char *hostEnv(const char *name, const char *fallback);
+
+// Heap in use when main() started; ESP.getFreeHeap() reports growth from it.
+size_t hostRuntimeBaselineHeap();
+
+[[noreturn]] void hostRuntimeRestart();
+void hostRuntimeShutdown();
+
+// Ports below 1024 need root on Linux. Unless running as root (or
+// AVTOOL_PORT_OFFSET=0), privileged listen ports are shifted by
+// AVTOOL_PORT_OFFSET (default 8000): HTTP 80 -> 8080, telnet 23 -> 8023.
+uint16_t hostMapListenPort(uint16_t port);
+
+// Serialises AsyncTCP callbacks with every thread that touches async sockets,
+// the same guarantee the single async_tcp task gives on target.
+std::recursive_mutex &hostAsyncLock();
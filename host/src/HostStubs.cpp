@@ -0,0 +1,175 @@
+// Globals and small implementations behind the stub headers (OTA, mDNS,
+// HTTP, ping, ARP).
+
+#include <ArduinoOTA.h>
+#include <ESP32Ping.h>
+#include <ESPmDNS.h>
+#include <HTTPClient.h>
+#include <HTTPUpdate.h>
+#include <Update.h>
+#include <WiFi.h>
+#include <lwip/etharp.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ArduinoOTAClass ArduinoOTA;
+MDNSResponder MDNS;
+UpdateClass Update;
+HTTPUpdate httpUpdate;
+PingClass Ping;
+
+// ── HTTPClient ──
+
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+  _client = &client;
+  String rest = url;
+  _port = 80;
+  if (rest.startsWith("https://")) {
+    rest = rest.substring(8);
+    _port = 443;
+  } else if (rest.startsWith("http://")) {
+    rest = rest.substring(7);
+  }
+  int slash = rest.indexOf('/');
+  _host = slash < 0 ? rest : rest.substring(0, slash);
+  _path = slash < 0 ? String("/") : rest.substring(slash);
+  int colon = _host.indexOf(':');
+  if (colon >= 0) {
+    _port = (uint16_t)_host.substring(colon + 1).toInt();
+    _host = _host.substring(0, colon);
+  }
+  return _host.length() > 0;
+}
+
+void HTTPClient::end() {
+  if (_client)
+    _client->stop();
+  _client = nullptr;
+}
+
+int HTTPClient::GET() {
+  _payload = "";
+  if (!_client || !_client->connect(_host.c_str(), _port))
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  _client->print("GET " + _path + " HTTP/1.0\r\nHost: " + _host +
+                 "\r\nConnection: close\r\n\r\n");
+  String all;
+  uint32_t start = millis();
+  while (_client->connected() || _client->available()) {
+    if (_client->available()) {
+      all += (char)_client->read();
+      start = millis();
+    } else if (millis() - start > _timeoutMs) {
+      return HTTPC_ERROR_READ_TIMEOUT;
+    } else {
+      delay(1);
+    }
+  }
+  int sp = all.indexOf(' ');
+  int head = all.indexOf("\r\n\r\n");
+  if (sp < 0 || head < 0)
+    return HTTPC_ERROR_READ_TIMEOUT;
+  _payload = all.substring(head + 4);
+  return all.substring(sp + 1, sp + 4).toInt();
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+  case HTTPC_ERROR_CONNECTION_REFUSED:
+    return "connection refused";
+  case HTTPC_ERROR_READ_TIMEOUT:
+    return "read Timeout";
+  default:
+    return String();
+  }
+}
+
+// ── Ping ──
+
+bool PingClass::ping(const char *host, byte count) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip))
+    return false;
+  return ping(ip, count);
+}
+
+bool PingClass::ping(IPAddress dest, byte count) {
+  _avgMs = 0;
+  int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+  if (fd < 0)
+    return false;
+  sockaddr_in sa{};
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = (uint32_t)dest;
+
+  int ok = 0;
+  float total = 0;
+  for (int seq = 0; seq < count; seq++) {
+    icmphdr req{};
+    req.type = ICMP_ECHO;
+    req.un.echo.sequence = htons(seq + 1);
+    uint32_t t0 = micros();
+    if (sendto(fd, &req, sizeof(req), 0, (sockaddr *)&sa, sizeof(sa)) < 0)
+      break;
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, 1000) > 0) {
+      uint8_t buf[256];
+      if (recv(fd, buf, sizeof(buf), 0) >= (ssize_t)sizeof(icmphdr)) {
+        ok++;
+        total += (micros() - t0) / 1000.0f;
+      }
+    }
+  }
+  ::close(fd);
+  if (ok)
+    _avgMs = total / ok;
+  return ok > 0;
+}
+
+// ── lwIP ARP ──
+
+static struct netif hostNetif = {nullptr, {'h', 'n'}, 0};
+struct netif *netif_list = &hostNetif;
+
+int8_t etharp_find_addr(struct netif *, const ip4_addr_t *ipaddr,
+                        struct eth_addr **eth_ret,
+                        const ip4_addr_t **ip_ret) {
+  static eth_addr mac;
+  static ip4_addr_t found;
+  FILE *f = fopen("/proc/net/arp", "r");
+  if (!f)
+    return -1;
+  char line[256];
+  int8_t rc = -1;
+  if (!fgets(line, sizeof(line), f)) { // header
+    fclose(f);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    char ip[64], hw[64];
+    unsigned flags = 0;
+    if (sscanf(line, "%63s %*s 0x%x %63s", ip, &flags, hw) != 3)
+      continue;
+    in_addr a;
+    if (!inet_aton(ip, &a) || a.s_addr != ipaddr->addr || !(flags & 0x2))
+      continue;
+    unsigned m[6];
+    if (sscanf(hw, "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4],
+               &m[5]) != 6)
+      continue;
+    for (int i = 0; i < 6; i++)
+      mac.addr[i] = (uint8_t)m[i];
+    found.addr = a.s_addr;
+    *eth_ret = &mac;
+    *ip_ret = &found;
+    rc = 0;
+    break;
+  }
+  fclose(f);
+  return rc;
+}
@@ -0,0 +1,59 @@
+#include "IPAddress.h"
+
+#include <cstdio>
+#include <cstring>
+
+const IPAddress INADDR_NONE_IP(0, 0, 0, 0);
+
+IPAddress::operator uint32_t() const {
+  uint32_t v;
+  memcpy(&v, _bytes, sizeof(v));
+  return v;
+}
+
+IPAddress &IPAddress::operator=(uint32_t address) {
+  memcpy(_bytes, &address, sizeof(address));
+  return *this;
+}
+
+bool IPAddress::operator==(const uint8_t *addr) const {
+  return memcmp(addr, _bytes, sizeof(_bytes)) == 0;
+}
+
+bool IPAddress::fromString(const char *address) {
+  if (!address)
+    return false;
+  uint16_t acc = 0;
+  uint8_t dots = 0;
+  bool haveDigit = false;
+  uint8_t out[4];
+  while (*address) {
+    char c = *address++;
+    if (c >= '0' && c <= '9') {
+      acc = acc * 10 + (c - '0');
+      if (acc > 255)
+        return false;
+      haveDigit = true;
+    } else if (c == '.') {
+      if (dots == 3 || !haveDigit)
+        return false;
+      out[dots++] = (uint8_t)acc;
+      acc = 0;
+      haveDigit = false;
+    } else {
+      return false;
+    }
+  }
+  if (dots != 3 || !haveDigit)
+    return false;
+  out[3] = (uint8_t)acc;
+  memcpy(_bytes, out, sizeof(out));
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2],
+           _bytes[3]);
+  return String(buf);
+}
@@ -0,0 +1,176 @@
+// Host LittleFS: plain stdio files below a root directory.
+
+#include <LittleFS.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HostRuntime.h"
+
+namespace fs {
+
+File::Handle::~Handle() {
+  if (fp)
+    fclose(fp);
+}
+
+File::File(FILE *fp, const String &path, const String &name, bool dir)
+    : _h(std::make_shared<Handle>()) {
+  _h->fp = fp;
+  _h->path = path;
+  _h->name = name;
+  _h->dir = dir;
+}
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  if (!_h || !_h->fp)
+    return 0;
+  return fwrite(buf, 1, size, _h->fp);
+}
+
+int File::available() {
+  if (!_h || !_h->fp)
+    return 0;
+  return (int)(size() - position());
+}
+
+int File::read() {
+  if (!_h || !_h->fp)
+    return -1;
+  return fgetc(_h->fp);
+}
+
+int File::peek() {
+  if (!_h || !_h->fp)
+    return -1;
+  int c = fgetc(_h->fp);
+  if (c != EOF)
+    ungetc(c, _h->fp);
+  return c;
+}
+
+void File::flush() {
+  if (_h && _h->fp)
+    fflush(_h->fp);
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  if (!_h || !_h->fp)
+    return 0;
+  return fread(buf, 1, size, _h->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_h || !_h->fp)
+    return false;
+  int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+  return fseek(_h->fp, pos, whence) == 0;
+}
+
+size_t File::position() const {
+  if (!_h || !_h->fp)
+    return 0;
+  long p = ftell(_h->fp);
+  return p < 0 ? 0 : (size_t)p;
+}
+
+size_t File::size() const {
+  if (!_h || !_h->fp)
+    return 0;
+  struct stat st;
+  fflush(_h->fp);
+  if (fstat(fileno(_h->fp), &st) != 0)
+    return 0;
+  return (size_t)st.st_size;
+}
+
+void File::close() { _h.reset(); }
+
+String FS::hostPath(const String &path) const {
+  if (path.startsWith("/"))
+    return _root + path;
+  return _root + "/" + path;
+}
+
+File FS::open(const String &path, const char *mode, bool create) {
+  String full = hostPath(path);
+  int slash = path.lastIndexOf('/');
+  String name = slash >= 0 ? path.substring(slash + 1) : path;
+  struct stat st;
+  if (stat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+    return File(nullptr, path, name, true);
+  if (create && mode[0] != 'r') {
+    for (int i = 1; i < (int)full.length(); i++) {
+      if (full[i] == '/')
+        ::mkdir(full.substring(0, i).c_str(), 0755);
+    }
+  }
+  String m = String(mode);
+  if (m.indexOf('b') < 0)
+    m += "b";
+  FILE *fp = fopen(full.c_str(), m.c_str());
+  if (!fp)
+    return File();
+  return File(fp, path, name, false);
+}
+
+bool FS::exists(const String &path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const String &path) {
+  return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const String &from, const String &to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const String &path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const String &path) {
+  return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+LittleFSFS::LittleFSFS() : FS("data") {}
+
+bool LittleFSFS::begin(bool formatOnFail, const char *, uint8_t,
+                       const char *) {
+  hostSetRoot(hostEnv("AVTOOL_FS_ROOT", "data"));
+  struct stat st;
+  if (stat(_root.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+    return true;
+  if (!formatOnFail)
+    return false;
+  return ::mkdir(_root.c_str(), 0755) == 0;
+}
+
+bool LittleFSFS::format() { return true; }
+
+// Sizes mirror the default 1.5 MB "spiffs" partition of the esp32dev table.
+size_t LittleFSFS::totalBytes() { return 1507328; }
+
+size_t LittleFSFS::usedBytes() {
+  size_t used = 0;
+  DIR *d = opendir(_root.c_str());
+  if (!d)
+    return 0;
+  while (dirent *e = readdir(d)) {
+    struct stat st;
+    String p = _root + "/" + e->d_name;
+    if (stat(p.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+      used += (size_t)st.st_size;
+  }
+  closedir(d);
+  return used;
+}
+
+} // namespace fs
+
+fs::LittleFSFS LittleFS;
@@ -0,0 +1,169 @@
+#include <Preferences.h>
+
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HostRuntime.h"
+
+bool Preferences::begin(const char *name, bool readOnly, const char *) {
+  if (_started || !name || !*name)
+    return false;
+  String root = hostEnv("AVTOOL_NVS_DIR", ".host_nvs");
+  ::mkdir(root.c_str(), 0755);
+  _dir = root + "/" + name;
+  if (::mkdir(_dir.c_str(), 0755) != 0 && errno != EEXIST)
+    return false;
+  _readOnly = readOnly;
+  _started = true;
+  return true;
+}
+
+void Preferences::end() { _started = false; }
+
+String Preferences::keyPath(const char *key) const { return _dir + "/" + key; }
+
+bool Preferences::readRaw(const char *key, std::string &out) {
+  if (!_started || !key)
+    return false;
+  FILE *f = fopen(keyPath(key).c_str(), "rb");
+  if (!f)
+    return false;
+  char buf[512];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+// Write-then-rename so a crash never leaves a half written key behind.
+size_t Preferences::writeRaw(const char *key, const void *data, size_t len) {
+  if (!_started || _readOnly || !key)
+    return 0;
+  String tmp = keyPath(key) + ".tmp";
+  FILE *f = fopen(tmp.c_str(), "wb");
+  if (!f)
+    return 0;
+  size_t n = len ? fwrite(data, 1, len, f) : 0;
+  fclose(f);
+  if (n != len || ::rename(tmp.c_str(), keyPath(key).c_str()) != 0) {
+    ::unlink(tmp.c_str());
+    return 0;
+  }
+  return len ? len : 1;
+}
+
+bool Preferences::clear() {
+  if (!_started || _readOnly)
+    return false;
+  DIR *d = opendir(_dir.c_str());
+  if (!d)
+    return false;
+  while (dirent *e = readdir(d)) {
+    if (e->d_name[0] == '.')
+      continue;
+    ::unlink((_dir + "/" + e->d_name).c_str());
+  }
+  closedir(d);
+  return true;
+}
+
+bool Preferences::remove(const char *key) {
+  if (!_started || _readOnly || !key)
+    return false;
+  return ::unlink(keyPath(key).c_str()) == 0;
+}
+
+bool Preferences::isKey(const char *key) {
+  struct stat st;
+  return _started && key && stat(keyPath(key).c_str(), &st) == 0;
+}
+
+size_t Preferences::putString(const char *key, const char *value) {
+  if (!value)
+    return 0;
+  size_t len = strlen(value);
+  return writeRaw(key, value, len) ? len : 0;
+}
+
+size_t Preferences::putString(const char *key, const String &value) {
+  return putString(key, value.c_str());
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+  std::string raw;
+  if (!readRaw(key, raw))
+    return defaultValue;
+  return String(raw.c_str(), raw.size());
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen) {
+  std::string raw;
+  if (!readRaw(key, raw) || !value || raw.size() + 1 > maxLen)
+    return 0;
+  memcpy(value, raw.c_str(), raw.size() + 1);
+  return raw.size() + 1;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+  return writeRaw(key, value, len) ? len : 0;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  std::string raw;
+  if (!readRaw(key, raw) || raw.size() > maxLen)
+    return 0;
+  memcpy(buf, raw.data(), raw.size());
+  return raw.size();
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  std::string raw;
+  return readRaw(key, raw) ? raw.size() : 0;
+}
+
+namespace {
+template <typename T>
+size_t putScalar(Preferences &p, const char *key, T v) {
+  return p.putBytes(key, &v, sizeof(v));
+}
+template <typename T>
+T getScalar(Preferences &p, const char *key, T def) {
+  T v;
+  return p.getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+}
+} // namespace
+
+size_t Preferences::putUChar(const char *key, uint8_t value) {
+  return putScalar(*this, key, value);
+}
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue) {
+  return getScalar(*this, key, defaultValue);
+}
+size_t Preferences::putUShort(const char *key, uint16_t value) {
+  return putScalar(*this, key, value);
+}
+uint16_t Preferences::getUShort(const char *key, uint16_t defaultValue) {
+  return getScalar(*this, key, defaultValue);
+}
+size_t Preferences::putInt(const char *key, int32_t value) {
+  return putScalar(*this, key, value);
+}
+int32_t Preferences::getInt(const char *key, int32_t defaultValue) {
+  return getScalar(*this, key, defaultValue);
+}
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+  return putScalar(*this, key, value);
+}
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+  return getScalar(*this, key, defaultValue);
+}
+size_t Preferences::putBool(const char *key, bool value) {
+  return putScalar(*this, key, (uint8_t)(value ? 1 : 0));
+}
+bool Preferences::getBool(const char *key, bool defaultValue) {
+  return getScalar(*this, key, (uint8_t)(defaultValue ? 1 : 0)) != 0;
+}
@@ -0,0 +1,114 @@
+#include "Print.h"
+#include "Stream.h"
+
+#include <Arduino.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (!write(*buffer++))
+      break;
+    n++;
+  }
+  return n;
+}
+
+size_t Print::write(const char *str) {
+  if (!str)
+    return 0;
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::printf(const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  size_t n = vprintf(format, ap);
+  va_end(ap);
+  return n;
+}
+
+size_t Print::vprintf(const char *format, va_list ap) {
+  char small[128];
+  va_list copy;
+  va_copy(copy, ap);
+  int len = vsnprintf(small, sizeof(small), format, copy);
+  va_end(copy);
+  if (len < 0)
+    return 0;
+  if ((size_t)len < sizeof(small))
+    return write((const uint8_t *)small, len);
+  std::vector<char> big(len + 1);
+  vsnprintf(big.data(), big.size(), format, ap);
+  return write((const uint8_t *)big.data(), len);
+}
+
+size_t Print::print(unsigned char v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(int v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(unsigned int v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(long v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(unsigned long v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(long long v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(unsigned long long v, int base) {
+  return print(String(v, (unsigned char)base));
+}
+size_t Print::print(double v, int digits) {
+  return print(String(v, (unsigned char)digits));
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0)
+      return c;
+    delay(1);
+  } while (millis() - start < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0)
+      break;
+    *buffer++ = (char)c;
+    count++;
+  }
+  return count;
+}
+
+String Stream::readString() {
+  String ret;
+  int c = timedRead();
+  while (c >= 0) {
+    ret += (char)c;
+    c = timedRead();
+  }
+  return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String ret;
+  int c = timedRead();
+  while (c >= 0 && c != terminator) {
+    ret += (char)c;
+    c = timedRead();
+  }
+  return ret;
+}
@@ -0,0 +1,302 @@
+#include "WString.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static std::string numToString(unsigned long long v, unsigned char base,
+                               bool negative) {
+  if (base < 2 || base > 36)
+    base = 10;
+  char buf[72];
+  char *p = buf + sizeof(buf) - 1;
+  *p = '\0';
+  do {
+    unsigned d = (unsigned)(v % base);
+    *--p = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+    v /= base;
+  } while (v);
+  if (negative)
+    *--p = '-';
+  return std::string(p);
+}
+
+static std::string signedToString(long long v, unsigned char base) {
+  if (base == 10 && v < 0)
+    return numToString(0ULL - (unsigned long long)v, 10, true);
+  return numToString((unsigned long long)v, base, false);
+}
+
+static std::string floatToString(double v, unsigned char decimals) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+  return std::string(buf);
+}
+
+String::String(const char *cstr) {
+  if (cstr)
+    _s = cstr;
+}
+
+String::String(const char *cstr, size_t len) {
+  if (cstr)
+    _s.assign(cstr, len);
+}
+
+String::String(char c) : _s(1, c) {}
+String::String(unsigned char v, unsigned char base)
+    : _s(numToString(v, base, false)) {}
+String::String(int v, unsigned char base) : _s(signedToString(v, base)) {}
+String::String(unsigned int v, unsigned char base)
+    : _s(numToString(v, base, false)) {}
+String::String(long v, unsigned char base) : _s(signedToString(v, base)) {}
+String::String(unsigned long v, unsigned char base)
+    : _s(numToString(v, base, false)) {}
+String::String(long long v, unsigned char base)
+    : _s(signedToString(v, base)) {}
+String::String(unsigned long long v, unsigned char base)
+    : _s(numToString(v, base, false)) {}
+String::String(float v, unsigned char decimals)
+    : _s(floatToString(v, decimals)) {}
+String::String(double v, unsigned char decimals)
+    : _s(floatToString(v, decimals)) {}
+
+String &String::operator=(const char *cstr) {
+  if (cstr)
+    _s = cstr;
+  else
+    _s.clear();
+  return *this;
+}
+
+bool String::concat(const String &s) {
+  _s += s._s;
+  return true;
+}
+bool String::concat(const char *cstr) {
+  if (!cstr)
+    return false;
+  _s += cstr;
+  return true;
+}
+bool String::concat(const char *cstr, size_t len) {
+  if (!cstr)
+    return false;
+  _s.append(cstr, len);
+  return true;
+}
+bool String::concat(char c) {
+  _s += c;
+  return true;
+}
+bool String::concat(unsigned char v) { return concat(String(v)); }
+bool String::concat(int v) { return concat(String(v)); }
+bool String::concat(unsigned int v) { return concat(String(v)); }
+bool String::concat(long v) { return concat(String(v)); }
+bool String::concat(unsigned long v) { return concat(String(v)); }
+bool String::concat(long long v) { return concat(String(v)); }
+bool String::concat(unsigned long long v) { return concat(String(v)); }
+bool String::concat(float v) { return concat(String(v)); }
+bool String::concat(double v) { return concat(String(v)); }
+
+bool String::equals(const char *cstr) const {
+  if (!cstr)
+    return _s.empty();
+  return _s == cstr;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  if (_s.size() != s._s.size())
+    return false;
+  for (size_t i = 0; i < _s.size(); i++)
+    if (tolower((unsigned char)_s[i]) != tolower((unsigned char)s._s[i]))
+      return false;
+  return true;
+}
+
+bool String::startsWith(const String &prefix) const {
+  return _s.compare(0, prefix._s.size(), prefix._s) == 0 &&
+         _s.size() >= prefix._s.size();
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const {
+  if (offset > _s.size() || _s.size() - offset < prefix._s.size())
+    return false;
+  return _s.compare(offset, prefix._s.size(), prefix._s) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  if (suffix._s.size() > _s.size())
+    return false;
+  return _s.compare(_s.size() - suffix._s.size(), suffix._s.size(),
+                    suffix._s) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return index < _s.size() ? _s[index] : '\0';
+}
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < _s.size())
+    _s[index] = c;
+}
+
+char &String::operator[](unsigned int index) {
+  static char dummy;
+  if (index >= _s.size()) {
+    dummy = '\0';
+    return dummy;
+  }
+  return _s[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize,
+                      unsigned int index) const {
+  if (!bufsize || !buf)
+    return;
+  if (index >= _s.size()) {
+    buf[0] = 0;
+    return;
+  }
+  size_t n = std::min((size_t)bufsize - 1, _s.size() - index);
+  memcpy(buf, _s.data() + index, n);
+  buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+  size_t p = _s.find(ch, fromIndex);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::indexOf(const String &s, unsigned int fromIndex) const {
+  if (fromIndex >= _s.size())
+    return -1;
+  size_t p = _s.find(s._s, fromIndex);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::lastIndexOf(char ch) const {
+  return _s.empty() ? -1 : lastIndexOf(ch, _s.size() - 1);
+}
+
+int String::lastIndexOf(char ch, unsigned int fromIndex) const {
+  size_t p = _s.rfind(ch, fromIndex);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::lastIndexOf(const String &s) const {
+  return _s.empty() ? -1 : lastIndexOf(s, _s.size() - 1);
+}
+
+int String::lastIndexOf(const String &s, unsigned int fromIndex) const {
+  size_t p = _s.rfind(s._s, fromIndex);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+String String::substring(unsigned int beginIndex) const {
+  return substring(beginIndex, _s.size());
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+  if (left > right)
+    std::swap(left, right);
+  if (left >= _s.size())
+    return String();
+  if (right > _s.size())
+    right = _s.size();
+  return String(_s.substr(left, right - left));
+}
+
+void String::replace(char find, char replace) {
+  std::replace(_s.begin(), _s.end(), find, replace);
+}
+
+void String::replace(const String &find, const String &replace) {
+  if (find._s.empty())
+    return;
+  std::string out;
+  size_t pos = 0;
+  for (;;) {
+    size_t hit = _s.find(find._s, pos);
+    if (hit == std::string::npos)
+      break;
+    out.append(_s, pos, hit - pos);
+    out += replace._s;
+    pos = hit + find._s.size();
+  }
+  out.append(_s, pos, std::string::npos);
+  _s.swap(out);
+}
+
+void String::remove(unsigned int index) {
+  if (index < _s.size())
+    _s.erase(index);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < _s.size())
+    _s.erase(index, count);
+}
+
+void String::toLowerCase() {
+  for (auto &c : _s)
+    c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+  for (auto &c : _s)
+    c = (char)toupper((unsigned char)c);
+}
+
+void String::trim() {
+  size_t b = 0, e = _s.size();
+  while (b < e && isspace((unsigned char)_s[b]))
+    b++;
+  while (e > b && isspace((unsigned char)_s[e - 1]))
+    e--;
+  _s = _s.substr(b, e - b);
+}
+
+long String::toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+float String::toFloat() const { return strtof(_s.c_str(), nullptr); }
+double String::toDouble() const { return strtod(_s.c_str(), nullptr); }
+
+String operator+(const String &lhs, const String &rhs) {
+  String r(lhs);
+  r.concat(rhs);
+  return r;
+}
+String operator+(const String &lhs, const char *rhs) {
+  String r(lhs);
+  r.concat(rhs);
+  return r;
+}
+String operator+(const char *lhs, const String &rhs) {
+  String r(lhs);
+  r.concat(rhs);
+  return r;
+}
+String operator+(const String &lhs, char rhs) {
+  String r(lhs);
+  r.concat(rhs);
+  return r;
+}
+
+#define HOST_STRING_PLUS_NUM(T)                                                \
+  String operator+(const String &lhs, T rhs) {                                 \
+    String r(lhs);                                                             \
+    r.concat(rhs);                                                             \
+    return r;                                                                  \
+  }
+HOST_STRING_PLUS_NUM(unsigned char)
+HOST_STRING_PLUS_NUM(int)
+HOST_STRING_PLUS_NUM(unsigned int)
+HOST_STRING_PLUS_NUM(long)
+HOST_STRING_PLUS_NUM(unsigned long)
+HOST_STRING_PLUS_NUM(long long)
+HOST_STRING_PLUS_NUM(unsigned long long)
+HOST_STRING_PLUS_NUM(float)
+HOST_STRING_PLUS_NUM(double)
+#undef HOST_STRING_PLUS_NUM
@@ -0,0 +1,522 @@
+// Host build: WiFiClass, WiFiClient, WiFiServer and WiFiUDP on BSD sockets.
+
+#include <WiFi.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "HostRuntime.h"
+
+WiFiClass WiFi;
+
+static IPAddress fromSockaddr(const sockaddr_in &sa) {
+  return IPAddress((uint32_t)sa.sin_addr.s_addr);
+}
+
+static sockaddr_in toSockaddr(const IPAddress &ip, uint16_t port) {
+  sockaddr_in sa{};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = (uint32_t)ip;
+  return sa;
+}
+
+static void setNonBlocking(int fd, bool on) {
+  int fl = fcntl(fd, F_GETFL);
+  fcntl(fd, F_SETFL, on ? (fl | O_NONBLOCK) : (fl & ~O_NONBLOCK));
+}
+
+// ── WiFiClass ──
+
+static IPAddress firstInterfaceAddr(bool wantMask) {
+  struct ifaddrs *ifs = nullptr;
+  IPAddress out(127, 0, 0, 1);
+  if (wantMask)
+    out = IPAddress(255, 0, 0, 0);
+  if (getifaddrs(&ifs) != 0)
+    return out;
+  const char *want = hostEnv("AVTOOL_IFACE", "");
+  for (struct ifaddrs *i = ifs; i; i = i->ifa_next) {
+    if (!i->ifa_addr || i->ifa_addr->sa_family != AF_INET)
+      continue;
+    if (i->ifa_flags & IFF_LOOPBACK)
+      continue;
+    if (*want && strcmp(want, i->ifa_name) != 0)
+      continue;
+    const sockaddr *sa = wantMask ? i->ifa_netmask : i->ifa_addr;
+    if (!sa)
+      continue;
+    out = fromSockaddr(*(const sockaddr_in *)sa);
+    break;
+  }
+  freeifaddrs(ifs);
+  return out;
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+  _mode = m;
+  return true;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *, int32_t,
+                             const uint8_t *, bool) {
+  _ssid = ssid ? ssid : "";
+  _staStarted = true;
+  return WL_CONNECTED;
+}
+
+bool WiFiClass::disconnect(bool, bool) {
+  _staStarted = false;
+  _ssid = "";
+  return true;
+}
+
+// The host is always "associated": network features are the point of the
+// native build, so STA reports connected regardless of the stored config.
+wl_status_t WiFiClass::status() { return WL_CONNECTED; }
+
+bool WiFiClass::setHostname(const char *hostname) {
+  _hostname = hostname ? hostname : "";
+  return true;
+}
+
+bool WiFiClass::softAP(const char *ssid, const char *, int, int, int) {
+  _apSsid = ssid ? ssid : "";
+  return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool) {
+  _apSsid = "";
+  return true;
+}
+
+IPAddress WiFiClass::softAPIP() { return IPAddress(127, 0, 0, 1); }
+IPAddress WiFiClass::localIP() { return firstInterfaceAddr(false); }
+IPAddress WiFiClass::subnetMask() { return firstInterfaceAddr(true); }
+
+IPAddress WiFiClass::gatewayIP() {
+  IPAddress ip = localIP();
+  ip[3] = 1;
+  return ip;
+}
+
+String WiFiClass::macAddress() { return "AA:BB:CC:DD:EE:FF"; }
+
+// Scans complete immediately with a single synthetic network.
+int16_t WiFiClass::scanNetworks(bool, bool) {
+  _scanDone = true;
+  return 1;
+}
+
+int16_t WiFiClass::scanComplete() { return _scanDone ? 1 : WIFI_SCAN_FAILED; }
+void WiFiClass::scanDelete() { _scanDone = false; }
+String WiFiClass::SSID(uint8_t) { return "host-network"; }
+int32_t WiFiClass::RSSI(uint8_t) { return -42; }
+int32_t WiFiClass::channel(uint8_t) { return 6; }
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t) {
+  return WIFI_AUTH_WPA2_PSK;
+}
+
+int WiFiClass::hostByName(const char *host, IPAddress &result) {
+  if (result.fromString(host))
+    return 1;
+  struct addrinfo hints{};
+  hints.ai_family = AF_INET;
+  struct addrinfo *res = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res)
+    return 0;
+  result = fromSockaddr(*(const sockaddr_in *)res->ai_addr);
+  freeaddrinfo(res);
+  return 1;
+}
+
+// ── WiFiClient ──
+
+struct HostSocketHandle {
+  int fd;
+  explicit HostSocketHandle(int f) : fd(f) {}
+  ~HostSocketHandle() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+};
+
+WiFiClient::WiFiClient() = default;
+
+WiFiClient::WiFiClient(int fd)
+    : _sock(std::make_shared<HostSocketHandle>(fd)), _connected(true) {}
+
+WiFiClient::~WiFiClient() = default;
+
+int WiFiClient::fd() const { return _sock ? _sock->fd : -1; }
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip, port, 3000);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+  stop();
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return 0;
+  setNonBlocking(fd, true);
+  sockaddr_in sa = toSockaddr(ip, port);
+  int rc = ::connect(fd, (sockaddr *)&sa, sizeof(sa));
+  if (rc != 0 && errno != EINPROGRESS) {
+    ::close(fd);
+    return 0;
+  }
+  if (rc != 0) {
+    pollfd p{fd, POLLOUT, 0};
+    int ready = poll(&p, 1, timeoutMs < 0 ? -1 : timeoutMs);
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (ready <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 ||
+        err != 0) {
+      ::close(fd);
+      return 0;
+    }
+  }
+  setNonBlocking(fd, false);
+  _sock = std::make_shared<HostSocketHandle>(fd);
+  _connected = true;
+  setTimeout(_timeout / 1000 ? _timeout / 1000 : 1);
+  return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  return connect(host, port, 3000);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip))
+    return 0;
+  return connect(ip, port, timeoutMs);
+}
+
+int WiFiClient::setTimeout(uint32_t seconds) {
+  Stream::setTimeout(seconds * 1000);
+  if (fd() < 0)
+    return 0;
+  timeval tv{(time_t)seconds, 0};
+  setsockopt(fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd(), SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  return 0;
+}
+
+int WiFiClient::setNoDelay(bool nodelay) {
+  int v = nodelay ? 1 : 0;
+  return fd() < 0 ? -1
+                  : setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+}
+
+size_t WiFiClient::write(uint8_t data) { return write(&data, 1); }
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size) {
+  if (!_connected || fd() < 0)
+    return 0;
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = send(fd(), buf + done, size - done, MSG_NOSIGNAL);
+    if (n > 0) {
+      done += (size_t)n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      _connected = false;
+      break;
+    }
+  }
+  return done;
+}
+
+int WiFiClient::available() {
+  if (fd() < 0)
+    return 0;
+  int n = 0;
+  if (ioctl(fd(), FIONREAD, &n) != 0)
+    return 0;
+  return n + (_peek >= 0 ? 1 : 0);
+}
+
+int WiFiClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+  if (!size)
+    return 0;
+  size_t got = 0;
+  if (_peek >= 0) {
+    buf[got++] = (uint8_t)_peek;
+    _peek = -1;
+  }
+  if (fd() < 0 || got == size)
+    return got ? (int)got : -1;
+  ssize_t n = recv(fd(), buf + got, size - got, MSG_DONTWAIT);
+  if (n > 0)
+    got += (size_t)n;
+  else if (n == 0)
+    _connected = false;
+  return got ? (int)got : -1;
+}
+
+int WiFiClient::peek() {
+  if (_peek < 0) {
+    uint8_t b;
+    if (fd() >= 0 && recv(fd(), &b, 1, MSG_DONTWAIT) == 1)
+      _peek = b;
+  }
+  return _peek;
+}
+
+void WiFiClient::stop() {
+  _sock.reset();
+  _peek = -1;
+  _connected = false;
+}
+
+uint8_t WiFiClient::connected() {
+  if (!_connected || fd() < 0)
+    return 0;
+  if (_peek >= 0)
+    return 1;
+  uint8_t b;
+  ssize_t n = recv(fd(), &b, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                 errno != EINTR))
+    _connected = false;
+  return _connected;
+}
+
+IPAddress WiFiClient::remoteIP() const {
+  sockaddr_in sa{};
+  socklen_t len = sizeof(sa);
+  if (fd() < 0 || getpeername(fd(), (sockaddr *)&sa, &len) != 0)
+    return IPAddress();
+  return fromSockaddr(sa);
+}
+
+uint16_t WiFiClient::remotePort() const {
+  sockaddr_in sa{};
+  socklen_t len = sizeof(sa);
+  if (fd() < 0 || getpeername(fd(), (sockaddr *)&sa, &len) != 0)
+    return 0;
+  return ntohs(sa.sin_port);
+}
+
+IPAddress WiFiClient::localIP() const {
+  sockaddr_in sa{};
+  socklen_t len = sizeof(sa);
+  if (fd() < 0 || getsockname(fd(), (sockaddr *)&sa, &len) != 0)
+    return IPAddress();
+  return fromSockaddr(sa);
+}
+
+uint16_t WiFiClient::localPort() const {
+  sockaddr_in sa{};
+  socklen_t len = sizeof(sa);
+  if (fd() < 0 || getsockname(fd(), (sockaddr *)&sa, &len) != 0)
+    return 0;
+  return ntohs(sa.sin_port);
+}
+
+// ── WiFiServer ──
+
+void WiFiServer::begin(uint16_t port) {
+  end();
+  if (port)
+    _port = port;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  uint16_t bindPort = hostMapListenPort(_port);
+  sockaddr_in sa = toSockaddr(IPAddress(0, 0, 0, 0), bindPort);
+  if (bind(fd, (sockaddr *)&sa, sizeof(sa)) != 0 ||
+      listen(fd, _maxClients) != 0) {
+    fprintf(stderr, "[host] WiFiServer: cannot listen on %u: %s\n", bindPort,
+            strerror(errno));
+    ::close(fd);
+    return;
+  }
+  setNonBlocking(fd, true);
+  _fd = fd;
+  _listening = true;
+}
+
+void WiFiServer::end() {
+  if (_pending >= 0)
+    ::close(_pending);
+  _pending = -1;
+  if (_fd >= 0)
+    ::close(_fd);
+  _fd = -1;
+  _listening = false;
+}
+
+bool WiFiServer::hasClient() {
+  if (_pending >= 0)
+    return true;
+  if (_fd < 0)
+    return false;
+  int cfd = ::accept(_fd, nullptr, nullptr);
+  if (cfd < 0)
+    return false;
+  _pending = cfd;
+  return true;
+}
+
+WiFiClient WiFiServer::available() {
+  if (!hasClient())
+    return WiFiClient();
+  int cfd = _pending;
+  _pending = -1;
+  setNonBlocking(cfd, false);
+  if (_noDelay) {
+    int one = 1;
+    setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  return WiFiClient(cfd);
+}
+
+// ── WiFiUDP ──
+
+bool WiFiUDP::ensureSocket() {
+  if (_fd >= 0)
+    return true;
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_fd < 0)
+    return false;
+  int one = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+  setNonBlocking(_fd, true);
+  return true;
+}
+
+uint8_t WiFiUDP::begin(IPAddress address, uint16_t port) {
+  stop();
+  if (!ensureSocket())
+    return 0;
+  int one = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in sa = toSockaddr(address, hostMapListenPort(port));
+  if (bind(_fd, (sockaddr *)&sa, sizeof(sa)) != 0) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  return begin(IPAddress(0, 0, 0, 0), port);
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress address, uint16_t port) {
+  if (!begin(port))
+    return 0;
+  ip_mreq mreq{};
+  mreq.imr_multiaddr.s_addr = (uint32_t)address;
+  mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+    return 0;
+  return 1;
+}
+
+void WiFiUDP::stop() {
+  if (_fd >= 0)
+    ::close(_fd);
+  _fd = -1;
+  _rx.clear();
+  _rxPos = 0;
+  _tx.clear();
+}
+
+int WiFiUDP::beginPacket() {
+  if (!_txPort)
+    return 0;
+  _tx.clear();
+  return ensureSocket() ? 1 : 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+  _txIp = ip;
+  _txPort = port;
+  return beginPacket();
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip))
+    return 0;
+  return beginPacket(ip, port);
+}
+
+int WiFiUDP::endPacket() {
+  if (_fd < 0)
+    return 0;
+  sockaddr_in sa = toSockaddr(_txIp, _txPort);
+  ssize_t n = sendto(_fd, _tx.data(), _tx.size(), 0, (sockaddr *)&sa,
+                     sizeof(sa));
+  _tx.clear();
+  return n >= 0 ? 1 : 0;
+}
+
+size_t WiFiUDP::write(uint8_t c) { return write(&c, 1); }
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  // Same 1460 byte datagram buffer as the ESP32 core.
+  size_t room = _tx.size() < 1460 ? 1460 - _tx.size() : 0;
+  size_t n = std::min(room, size);
+  _tx.insert(_tx.end(), buffer, buffer + n);
+  return n;
+}
+
+int WiFiUDP::parsePacket() {
+  _rx.clear();
+  _rxPos = 0;
+  if (_fd < 0)
+    return 0;
+  uint8_t buf[1460];
+  sockaddr_in sa{};
+  socklen_t len = sizeof(sa);
+  ssize_t n = recvfrom(_fd, buf, sizeof(buf), MSG_DONTWAIT, (sockaddr *)&sa,
+                       &len);
+  if (n <= 0)
+    return 0;
+  _remoteIp = fromSockaddr(sa);
+  _remotePort = ntohs(sa.sin_port);
+  _rx.assign(buf, buf + n);
+  return (int)n;
+}
+
+int WiFiUDP::available() { return (int)(_rx.size() - _rxPos); }
+
+int WiFiUDP::read() { return _rxPos < _rx.size() ? _rx[_rxPos++] : -1; }
+
+int WiFiUDP::read(unsigned char *buffer, size_t len) {
+  size_t n = std::min(len, _rx.size() - _rxPos);
+  memcpy(buffer, _rx.data() + _rxPos, n);
+  _rxPos += n;
+  return (int)n;
+}
+
+int WiFiUDP::peek() { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+
+void WiFiUDP::flush() {
+  _rx.clear();
+  _rxPos = 0;
+}
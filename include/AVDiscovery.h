@@ -2,9 +2,12 @@
 #define AV_DISCOVERY_H
 
 #include "AppConfig.h"
+#include "RecursiveLock.h"
+#include <ArduinoJson.h>
 #include <WiFi.h>
 #include <vector>
 
+static const uint8_t devRttSamples = 20;
 
 struct DevStatus {
   String id;
@@ -12,20 +15,78 @@ struct DevStatus {
   uint32_t lastSeenMs = 0;
   String lastIp;
   uint16_t lastPort = 0;
+  uint32_t probes = 0;
+  uint32_t fails = 0;
+  uint32_t intervalMs = 0; // current probe interval chosen by the scheduler
+  uint32_t nextProbeMs = 0;
+  // Connect time over the last devRttSamples successful probes.
+  uint16_t rttMinMs = 0;
+  uint16_t rttAvgMs = 0;
+  uint16_t rttP95Ms = 0;
+  uint16_t rtt[devRttSamples] = {};
+  uint8_t rttCount = 0;
+  uint8_t rttPos = 0;
 };
 
+// Per-sweep counters for the subnet scan, reported by
+// /api/discovery/results.
+struct DiscStats {
+  uint32_t probes = 0; // connect attempts resolved (open, refused or timeout)
+  uint32_t open = 0;
+  uint32_t elapsedMs = 0;
+  uint16_t window = 0;    // connects kept in flight
+  uint16_t timeoutMs = 0; // current adaptive connect timeout
+  float probesPerSec = 0;
+};
+
+// One responsive host from the subnet sweep. Open ports are a bitmap over
+// the sweep's port list; the fingerprint is an index into a fixed profile
+// table. discHostToJson() expands both.
+static const uint8_t discMaxPorts = 32;
+
+struct DiscHost {
+  uint32_t ip = 0;
+  uint32_t seenMs = 0;
+  uint32_t openMask = 0; // bit i: i-th swept port answered
+  uint16_t bestPort = 0;
+  uint8_t profile = 0;
+  bool hasMac = false;
+  uint8_t mac[6] = {};
+};
+
+// Hold a DevLock while reading devStatuses; the monitor task updates it.
+struct DevLock : RecursiveLock {
+  DevLock();
+};
 extern std::vector<DevStatus> devStatuses;
 extern bool discRunning;
 extern uint32_t discProgress;
-extern std::vector<String> discFound;
+// Hold a DiscLock while reading discFound or discSweep or calling
+// discHostToJson(); the sweep task appends rows under it.
+struct DiscLock : RecursiveLock {
+  DiscLock();
+};
+extern std::vector<DiscHost> discFound;
+extern uint16_t discSweep; // bumped when a sweep clears discFound
+extern DiscStats discStats;
+extern uint16_t monBudgetPerSec; // health probes launched per second, max
+extern uint8_t monWindow;        // health probes kept in flight, max
 
 void updateDevStatus(const String &id, bool online, const String &ip,
-                     uint16_t port);
+                     uint16_t port, int32_t rttMs = -1);
 void deviceMonitorTask(void *pvParameters);
-void startDisc();
+void discBegin();
+// False if a sweep is running or ports has more than discMaxPorts entries.
+// window is clamped to 1..64; 0 keeps the current one.
+bool startDisc(const String &subnet = "", uint8_t from = 1, uint8_t to = 254,
+               const std::vector<uint16_t> &ports = {}, uint32_t window = 0);
 void sendWol(const String &macStr);
-String pjlinkCmd(const String &ip, const String &password, const String &cmd);
+void discHostToJson(const DiscHost &h, JsonObject row);
 
 bool tcpProbe(const IPAddress &ip, uint16_t port, uint16_t timeoutMs);
+// Non-blocking connect: the socket, -1 if none is free, -2 if the connect
+// failed outright. discClose() resets rather than FINs.
+int discConnect(const IPAddress &ip, uint16_t port);
+void discClose(int fd);
 
 #endif
@@ -27,6 +27,7 @@ extern AsyncWebSocket wsDisc;
 extern AsyncWebSocket wsRS232;
 extern AsyncWebSocket wsUdp;
 extern AsyncWebSocket wsTcpServer;
+extern AsyncWebSocket wsMacro;
 extern Preferences prefs;
 
 extern uint32_t bootMs;
@@ -4,24 +4,42 @@
 #include "AppConfig.h"
 #include <vector>
 
-struct Capture {
-  String id;
+#include <ArduinoJson.h>
+#include <functional>
+
+enum CapSource : uint8_t {
+  CAP_SRC_LEARN,    // learner TCP port; srcIp/srcPort are the sender
+  CAP_SRC_PROXY_RX, // proxy, target -> client
+  CAP_SRC_PROXY_TX, // proxy, client -> target
+};
+
+enum CapPayload : uint8_t { CAP_PAYLOAD_ASCII, CAP_PAYLOAD_HEX };
+
+// One learner capture as stored in the capture arena: this 36-byte header,
+// then len payload bytes. Hex/ASCII, suffix hint and the display source are
+// rendered from the raw bytes by captureToJson().
+struct CaptureRec {
+  uint32_t id;
   uint32_t ts;
-  String srcIp;
+  uint32_t lastTs;
+  uint32_t repeats;
+  uint32_t srcIp; // IPAddress as uint32_t; 0 for proxy captures
   uint16_t srcPort;
   uint16_t localPort;
-  String hex;
-  String ascii;
-  bool pinned = false;
-  uint32_t repeats = 1;
-  uint32_t lastTs;
-  String hash;
-  String suffixHint;
-  String payloadType; // "ascii" or "hex"
+  uint16_t len;
+  uint8_t source;      // CapSource
+  uint8_t payloadType; // CapPayload
+  bool pinned;
+  uint8_t reserved[3];
+  uint32_t hash; // capture index key, see addCapture()
+
+  const uint8_t *data() const { return (const uint8_t *)(this + 1); }
 };
+// Records start 4-byte aligned, so the header size must keep them so.
+static_assert(sizeof(CaptureRec) == 36, "CaptureRec layout changed");
 
-extern std::vector<Capture> caps;
 extern uint16_t learnPort;
+extern uint32_t capDedupMs; // repeats within this window fold into one entry
 extern bool learnEnabled;
 
 extern bool proxyRunning;
@@ -32,9 +50,20 @@ extern uint16_t proxyTargetPort;
 
 void startLearn();
 void stopLearn();
-void addCapture(const String &srcIp, uint16_t srcPort, uint16_t localPort,
-                const uint8_t *data, size_t len);
-bool getCaptureById(const String &id, Capture &out);
+void addCapture(CapSource source, uint32_t srcIp, uint16_t srcPort,
+                uint16_t localPort, const uint8_t *data, size_t len);
+
+// Capture arena. Captures live in a byte-budgeted ring; the oldest are
+// evicted to make room, so how many fit depends on their size.
+size_t captureCapacity();
+size_t captureUsed();
+size_t captureCount();
+void captureSetCapacity(size_t bytes); // drops all captures
+void captureForEach(bool newestFirst,
+                    const std::function<bool(CaptureRec &)> &fn);
+CaptureRec *findCapture(const String &id);
+String captureSrcIp(const CaptureRec &c);
+void captureToJson(const CaptureRec &c, JsonObject o);
 
 void proxyStart();
 void proxyStop();
@@ -2,13 +2,100 @@
 #define CONFIG_MANAGER_H
 
 #include "AppConfig.h"
+#include <ArduinoJson.h>
+#include <memory>
+#include <vector>
 
-extern String cfgJson;
+struct TemplateCommand {
+  String name;
+  String payloadType;
+  String payload;
+  String suffix;
+};
+
+struct DeviceTemplate {
+  String id;
+  String name;
+  String kind;
+  uint16_t defaultPort = 0;
+  String defaultSuffix;
+  std::vector<TemplateCommand> defaultCommands;
+  String extra; // unrecognised keys, kept as a JSON object
+};
+
+struct Device {
+  String id;
+  String name;
+  String ip;
+  uint16_t portHint = 0;
+  String defaultSuffix;
+  String notes;
+  String templateId;
+  String defaultPayloadType;
+  String mac;
+  uint32_t lastSeenMs = 0;
+  String extra; // unrecognised keys, kept as a JSON object
+
+  IPAddress addr; // parsed ip; 0.0.0.0 if it isn't a dotted quad
+};
+
+// The config (devices, templates and any other top-level keys) lives parsed
+// in RAM. Hold a CfgLock while reading or changing the registries; every
+// change bumps the registry's generation and marks the JSON form stale, and
+// cfgJson()/saveCfg() only re-serialise when it is.
+class CfgLock {
+public:
+  CfgLock();
+  ~CfgLock();
+};
+
+class DeviceRegistry {
+public:
+  const std::vector<Device> &all() const { return _devices; }
+  const Device *find(const String &id) const;
+  void add(const Device &d);
+  bool remove(const String &id);
+  uint32_t generation() const { return _generation; }
+
+  void fromJson(JsonArrayConst arr);
+  void toJson(JsonArray arr) const;
+  // Same as toJson() into a JSON array, one device at a time.
+  void writeJson(Print &out) const;
+
+private:
+  std::vector<Device> _devices;
+  uint32_t _generation = 0;
+};
+
+class TemplateRegistry {
+public:
+  const std::vector<DeviceTemplate> &all() const { return _templates; }
+  const DeviceTemplate *find(const String &id) const;
+  uint32_t generation() const { return _generation; }
+
+  void fromJson(JsonArrayConst arr);
+  void toJson(JsonArray arr) const;
+  void writeJson(Print &out) const;
+
+private:
+  std::vector<DeviceTemplate> _templates;
+  uint32_t _generation = 0;
+};
+
+extern DeviceRegistry deviceRegistry;
+extern TemplateRegistry templateRegistry;
 
 void loadCfg();
 void saveCfg();
 String defaultCfgJson();
 
+// Whole config as JSON, as served by /api/config. The snapshot is shared
+// and immutable, so a response can stream it while the config changes.
+std::shared_ptr<const String> cfgSnapshot();
+String cfgJson();
+// Replaces the whole config; false if json doesn't parse.
+bool setCfgJson(const char *json, size_t len);
+
 bool updateCfgWithDevice(const String &name, const String &ip,
                          uint16_t portHint, const String &suffixHint,
                          const String &notes, const String &templateId,
@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+
+// Log records are formatted into a fixed ring of slots that any task can
+// claim without taking a lock; a low-priority writer task prints them to
+// Serial and wsLog, so a caller never waits on the UART. If the writer
+// falls behind, the oldest records are overwritten and counted as dropped;
+// so is a record whose slot is still being filled a lap earlier.
+// The ring doubles as the history behind /api/logs.
+//
+// logAll() (AppConfig.h) logs at info level; a leading "MOD: " prefix of
+// up to seven characters names the module.
+
+enum LogLevel : uint8_t { LOGLV_ERROR, LOGLV_WARN, LOGLV_INFO, LOGLV_DEBUG };
+
+static const size_t logSlots = 64; // power of two
+static const size_t logModuleMax = 8;
+static const size_t logTextMax = 120; // longer text is truncated
+
+struct LogRec {
+  uint32_t seq; // from 1, never reused
+  uint32_t ms;
+  uint8_t level; // LogLevel
+  char module[logModuleMax];
+  char text[logTextMax];
+};
+
+void logBegin(); // starts the writer task; records logged earlier wait
+
+// module may be null for "app". Records above the module's level are
+// discarded before anything is formatted.
+void logAt(LogLevel level, const char *module, const String &s);
+void logFmt(LogLevel level, const char *module, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+bool logEnabled(LogLevel level, const char *module);
+
+// Per-module threshold, matched case-insensitively; "*" sets the default.
+// False when the module table is full.
+bool logSetLevel(const String &module, LogLevel level);
+bool logParseLevel(const String &name, LogLevel &out);
+const char *logLevelName(uint8_t level);
+void logLevelsJson(JsonObject out);
+
+// Records with seq > since still in the ring, oldest first. fn returns
+// false to stop.
+void logForEach(uint32_t since, const std::function<bool(const LogRec &)> &fn);
+uint32_t logOldestSeq(); // oldest seq still in the ring
+uint32_t logDropped();   // overwritten before the writer got to them
+void logRecToJson(const LogRec &r, JsonObject o);
@@ -1,23 +1,126 @@
 #pragma once
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <IPAddress.h>
+#include <memory>
 #include <vector>
 
 struct MacroStep {
-  String type;   // "tcp", "rs232", "udp", "pjlink", "delay"
+  String type;   // "tcp", "rs232", "udp", "delay"
   String target; // IP or "serial"
   uint16_t port;
   String payload;
   String mode;   // "ascii" or "hex"
   String suffix; // "\r", "\n", "\r\n", ""
   uint16_t delayMs;
+  // TCP only: the step completes once this arrives (escapes as in suffix,
+  // e.g. "\r\n" or ">"), or after timeoutMs. With no expect the step ends
+  // after the response goes quiet. timeoutMs 0 picks a default.
+  String expect;
+  uint16_t timeoutMs;
+};
+
+// A macro compiled for execution when it is loaded or saved. Payloads are
+// decoded (hex) or copied (ascii) into one byte buffer with the suffix
+// already appended, and targets are resolved to addresses, so the runner
+// only walks the step array.
+enum MacroOp : uint8_t {
+  MOP_TCP,
+  MOP_UDP,
+  MOP_RS232,
+  MOP_DELAY,
+};
+
+static const uint8_t macroExpectMax = 32;
+
+struct MacroPlanStep {
+  MacroOp op;
+  uint8_t expectLen;
+  uint16_t port;
+  uint16_t delayMs; // pause after the step; the whole step for MOP_DELAY
+  uint32_t atMs;    // planned start, relative to run start
+  uint16_t timeoutMs;
+  IPAddress addr;   // unset if hostIdx >= 0
+  int16_t hostIdx;  // index into MacroPlan::hosts for names resolved per run
+  uint16_t dataLen;
+  uint32_t dataOff; // into MacroPlan::bytes
+  uint32_t expectOff;
+};
+
+struct MacroPlan {
+  String name;
+  uint16_t spacingMs = 0;
+  uint32_t durationMs = 0; // planned start of the step after the last
+  std::vector<MacroPlanStep> steps;
+  std::vector<uint8_t> bytes;
+  std::vector<String> hosts;
+  std::vector<String> errors; // "step N: ..."; a plan with errors won't run
+
+  size_t sizeBytes() const;
 };
 
 struct Macro {
   String id;
   String name;
   String icon; // emoji or short label
+  // Steps start at fixed deadlines from the run start: each step's delay
+  // after the previous one, or every spacingMs if set (delay steps still
+  // add their own delay).
+  uint16_t spacingMs = 0;
   std::vector<MacroStep> steps;
+  std::shared_ptr<const MacroPlan> plan;
+};
+
+// Runs are queued and picked up by a pool of macroWorkers tasks, so several
+// macros can run at once. Step traces are pushed on /wsmacro as they
+// finish. A step holds its target (host:port, or the serial port) for its
+// duration, so commands from different runs never interleave on one device.
+static const uint8_t macroWorkers = 3;
+static const uint8_t macroQueueLen = 8;
+static const uint8_t macroRunHistory = 16; // finished runs kept for status
+
+enum MacroRunState : uint8_t {
+  RUN_QUEUED,
+  RUN_RUNNING,
+  RUN_DONE,
+};
+
+enum MacroOutcome : uint8_t {
+  MOUT_PENDING,
+  MOUT_OK,
+  MOUT_UNRESOLVED,     // host name lookup failed
+  MOUT_CONNECT_FAILED,
+  MOUT_SEND_FAILED,
+  MOUT_NO_REPLY,       // expect set and not seen before the timeout
+};
+
+// One step of a run. plannedMs/actualMs are offsets from run start, so
+// actual - planned is the step's start jitter.
+struct MacroStepTrace {
+  uint32_t plannedMs = 0;
+  uint32_t actualMs = 0;
+  uint16_t durationMs = 0;
+  uint16_t connectMs = 0;     // TCP handshake; 0 if a pooled one was reused
+  uint16_t bytesSent = 0;
+  uint16_t respBytes = 0;
+  uint16_t respLatencyMs = 0; // send to first reply byte; 0 if no reply
+  bool reused = false;
+  MacroOutcome outcome = MOUT_PENDING;
+};
+
+struct MacroRun {
+  uint32_t id = 0;
+  String macroId;
+  std::shared_ptr<const MacroPlan> plan;
+  MacroRunState state = RUN_QUEUED;
+  uint16_t step = 0;        // steps finished
+  uint16_t failedSteps = 0; // connect/resolve failures and missed replies
+  uint32_t queuedMs = 0;
+  uint32_t startMs = 0;
+  uint32_t endMs = 0;
+  std::vector<MacroStepTrace> trace; // sized when queued
+  uint32_t jitterMaxMs = 0;
+  uint32_t jitterSumMs = 0;
 };
 
 class MacroHandler {
@@ -31,25 +134,29 @@ public:
   bool remove(const String &id);
   String getById(const String &id);
 
-  // Execution
-  bool execute(const String &id);
-  bool isRunning() { return _running; }
-  void setRunning(bool r) { _running = r; }
+  // Execution. execute() queues a run and returns its id, or 0 if the
+  // macro is unknown or the queue is full.
+  bool has(const String &id);
+  uint32_t execute(const String &id);
+  // Compile errors for a macro (0 if it is unknown or compiled cleanly).
+  size_t planErrorCount(const String &id);
+  // Per-step trace of a run, by run id or by macro id (its latest run);
+  // empty if there is no such run in the history.
+  String traceJson(const String &id);
 
-  // Expose step executors for the background task
-  void executeTcpStep(const MacroStep &step);
-  void executeRS232Step(const MacroStep &step);
-  void executeUdpStep(const MacroStep &step);
+  // Expose step executors for the worker tasks; false if the step failed
+  bool executeTcpStep(const MacroPlan &plan, const MacroPlanStep &step,
+                      const IPAddress &addr, MacroStepTrace &trace);
+  bool executeRS232Step(const MacroPlan &plan, const MacroPlanStep &step,
+                        MacroStepTrace &trace);
+  bool executeUdpStep(const MacroPlan &plan, const MacroPlanStep &step,
+                      const IPAddress &addr, MacroStepTrace &trace);
 
 private:
   std::vector<Macro> _macros;
-  bool _running = false;
-  bool _pendingRun = false;
-  String _pendingId;
 
   void load();
   void persist();
-  void doExecute(const String &id);
 };
 
 extern MacroHandler macroHandler;
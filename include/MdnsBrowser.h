@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <IPAddress.h>
+#include <vector>
+
+// Browses several DNS-SD service types at once with async ESP-IDF queries,
+// plus a _services._dns-sd._udp meta-query that lists which types are
+// present. Answers are merged into a cache that keeps each instance until
+// its record TTL runs out, so results are available while a refresh runs.
+
+struct MdnsTxt {
+  String key;
+  String value;
+};
+
+struct MdnsService {
+  String instance;
+  String type; // "_airplay._tcp"
+  String hostname;
+  IPAddress ip;
+  uint16_t port = 0;
+  std::vector<MdnsTxt> txt;
+  uint32_t seenMs = 0;
+  uint32_t expiresMs = 0;
+};
+
+// Queues a refresh of the given types ("_http._tcp" or "_http" + proto),
+// or of the default AV set when empty. Returns false if one is running.
+bool mdnsBrowse(const std::vector<String> &types);
+bool mdnsBrowsing();
+// Live cache entries, optionally only those of one type.
+void mdnsResultsToJson(JsonDocument &doc, const String &type);
+void mdnsBegin();
+void mdnsScanLoop();
@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <vector>
+
+// Asynchronous PJLink client on AsyncClient. Requests are queued per
+// projector and sent one at a time over a single session, which stays open
+// and authenticated for follow-up commands (the digest is computed once per
+// connection) until it has been idle for pjlIdleMs. Sessions to different
+// projectors run concurrently. pjlinkLoop() resolves host names, enforces
+// deadlines and does every close, since closing from a client callback
+// would free the client under it.
+
+enum PjlState : uint8_t {
+  PJL_QUEUED,
+  PJL_RUNNING,
+  PJL_DONE,
+  PJL_FAILED,
+};
+
+struct PjlRequest {
+  uint32_t id = 0;
+  String host;
+  String cmd;
+  PjlState state = PJL_QUEUED;
+  String response; // reply line, or "ERROR: ..." if failed
+  uint32_t queuedMs = 0;
+  uint32_t sentMs = 0;
+  uint32_t doneMs = 0;
+  bool reusedSession = false; // sent on an already open session
+};
+
+// host is an IP or a name; names are resolved by pjlinkLoop(), never by
+// the caller. Returns the request id, or 0 if too many requests are pending.
+uint32_t pjlinkSubmit(const String &host, const String &password,
+                      const String &cmd);
+// Queues every command on one session, or none of them if they don't all
+// fit; ids gets one request id per command.
+bool pjlinkSubmitAll(const String &host, const String &password,
+                     const std::vector<String> &cmds,
+                     std::vector<uint32_t> &ids);
+// Copies a request's current state; id 0 gives the most recent one.
+bool pjlinkRequest(uint32_t id, PjlRequest &out);
+uint8_t pjlinkSessionCount();
+void pjlinkBegin();
+void pjlinkLoop();
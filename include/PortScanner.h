@@ -1,24 +1,73 @@
 #pragma once
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <IPAddress.h>
 #include <vector>
 
+struct PortRange {
+  uint16_t from;
+  uint16_t to;
+};
 
 class PortScanner {
 public:
   void begin();
   void loop();
-  void startScan(const String &ip, const std::vector<int> &ports);
-  bool isScanning() { return _scanning; }
+  // window: connects in flight, rate: connects started per second; 0 picks
+  // the default and larger values are clamped. Called from HTTP handlers:
+  // the scan is handed to loop(), which also resolves a host name, and false
+  // is returned while one is running or waiting to start.
+  bool startScan(const String &host, const std::vector<PortRange> &ports,
+                 uint32_t window = 0, uint32_t rate = 0,
+                 uint32_t timeoutMs = 0);
+  bool isScanning();
   String getResultsJson();
 
+  // "1-1024,4352,41794" -> sorted, merged ranges. Returns false and sets
+  // err on a malformed spec.
+  static bool parsePorts(const String &spec, std::vector<PortRange> &out,
+                         String &err);
+
 private:
+  struct Probe {
+    int fd;
+    uint16_t port;
+    uint32_t startMs;
+  };
+
+  struct Request {
+    String host;
+    std::vector<PortRange> ranges;
+    uint32_t window;
+    uint32_t rate;
+    uint32_t timeoutMs;
+  };
+
+  void beginScan(const IPAddress &ip);
+  void finish();
+  void advancePort();
+
+  bool _pending = false; // _request waiting for loop()
+  Request _request;
   bool _scanning = false;
-  String _targetIp;
-  std::vector<int> _portsToScan;
-  std::vector<int> _openPorts;
-  size_t _currentIndex = 0;
-  unsigned long _lastScanTime = 0;
+  IPAddress _target;
+  String _error; // why the last request did not start
+  std::vector<PortRange> _ranges;
+  size_t _rangeIdx = 0;
+  uint32_t _nextPort = 0; // next port in _ranges[_rangeIdx]
+  uint32_t _total = 0;
+  uint32_t _scanned = 0;
+  uint32_t _closed = 0;
+  uint32_t _filtered = 0; // timed out or unreachable
+  std::vector<uint16_t> _openPorts;
+  std::vector<Probe> _inflight;
+  uint16_t _window = 0;
+  uint16_t _rate = 0;
+  uint16_t _timeoutMs = 0;
+  float _tokens = 0;
+  uint32_t _lastRefillMs = 0;
+  uint32_t _startMs = 0;
+  uint32_t _endMs = 0;
 };
 
 extern PortScanner portScanner;
@@ -8,18 +8,25 @@ extern AsyncWebSocket wsRS232;
 extern WiFiServer rs232TelnetServer;
 extern bool rs232TelnetConnected;
 
-// Initialize Serial2 and WebSocket handlers
+// Initialize Serial2 and WebSocket handlers, and start the pump task that
+// handles RX, the telnet bridge, autobaud and loopback
 void rs232Setup();
 
-// Handle main loop tasks (reading Serial2, autobaud, loopback)
-void rs232Loop();
-
 // Helper to send data to Serial2
 void rs232Send(const String &data, bool hex, const String &suffix);
+// Raw variant: sends len bytes as they are (inverted if polarity is)
+void rs232Write(const uint8_t *data, size_t len);
 
 // Helper to change baud rate
 void rs232SetBaud(uint32_t baud);
 
+// RX coalescing: flush after gapChars idle character times, at maxBytes, or
+// when the oldest byte is maxAgeMs old.
+void rs232SetCoalesce(float gapChars, uint16_t maxBytes, uint16_t maxAgeMs);
+
+// UART driver RX ring size in bytes (256-16384), kept in prefs
+void rs232SetRxRing(uint16_t size);
+
 // Advanced Features
 void rs232SetInvert(bool invert);
 void rs232StartAutoBaud();
@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+
+// Holds a recursive mutex for the enclosing scope. Each module creates its
+// mutex once in its begin function, which setup() calls before any task or
+// handler that takes it can run, so the lock never creates one itself.
+class RecursiveLock {
+public:
+  explicit RecursiveLock(SemaphoreHandle_t m) : _m(m) {
+    xSemaphoreTakeRecursive(_m, portMAX_DELAY);
+  }
+  ~RecursiveLock() { xSemaphoreGiveRecursive(_m); }
+  RecursiveLock(const RecursiveLock &) = delete;
+  RecursiveLock &operator=(const RecursiveLock &) = delete;
+
+private:
+  SemaphoreHandle_t _m;
+};
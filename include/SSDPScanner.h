@@ -9,7 +9,9 @@ struct SSDPDevice {
   String url;
   String usn;
   String st;
-  String friendlyName;
+  String friendlyName; // from the LOCATION description, empty until fetched
+  String manufacturer;
+  String modelName;
 };
 
 class SSDPScanner {
@@ -22,7 +24,14 @@ public:
 
 private:
   void doStartScan();
+  void startFetches();
+  void pumpFetches();
   bool _scanning = false;
+  bool _fetching = false; // M-SEARCH window over, descriptions in flight
+  uint16_t _cacheHits = 0;
+  uint16_t _packets = 0;   // responses read this scan
+  uint16_t _truncated = 0; // cut off before the end of the headers
+  uint16_t _dropped = 0;   // unparseable or over the result limit
   bool _pendingScan = false;
   unsigned long _scanStartTime = 0;
   WiFiUDP _udp;
@@ -0,0 +1,8 @@
+#pragma once
+#include <ESPAsyncWebServer.h>
+
+// Serves the UI files listed in /assets.json (written at build time by
+// tools/compress_assets.py): pre-compressed variants picked by
+// Accept-Encoding, content-hash ETags and 304s on revalidation. Returns
+// false if the filesystem has no manifest.
+bool setupStaticAssets(AsyncWebServer &server);
@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+// Keep-alive TCP connections for macro steps, keyed by address and port. A step
+// acquires a connection for its exclusive use and releases it back when
+// done; connections idle for longer than tcpPoolIdleMs are closed by
+// tcpPoolExpire(), which runs from the main loop.
+
+struct TcpPoolStats {
+  uint32_t connects = 0; // new connections opened
+  uint32_t reuses = 0;   // acquisitions served from the pool
+  uint32_t expired = 0;  // idle connections closed
+  uint8_t open = 0;
+  uint8_t busy = 0;
+};
+
+extern uint32_t tcpPoolIdleMs;
+
+// Returns nullptr if the connect failed. reused tells whether an existing
+// connection was handed out; connectMs is the handshake time otherwise.
+WiFiClient *tcpPoolAcquire(const IPAddress &addr, uint16_t port,
+                           uint16_t connectTimeoutMs, bool *reused = nullptr,
+                           uint32_t *connectMs = nullptr);
+// keep=false closes the connection (after an error or when the peer hung up).
+void tcpPoolRelease(WiFiClient *client, bool keep = true);
+void tcpPoolExpire();
+TcpPoolStats tcpPoolStats();
@@ -6,10 +6,23 @@
 
 String bytesToHex(const uint8_t *data, size_t len);
 String bytesToAscii(const uint8_t *data, size_t len);
+
+// Buffer-writing variants, which the String versions above encode through.
+// They write at most outLen chars (no terminator) and return how many were
+// written; only whole bytes are encoded. hexLen()/asciiLen() give the size
+// needed for len bytes.
+inline size_t hexLen(size_t len) { return len ? len * 3 - 1 : 0; }
+inline size_t asciiLen(size_t len) { return len; }
+size_t bytesToHex(const uint8_t *data, size_t len, char *out, size_t outLen);
+size_t bytesToAscii(const uint8_t *data, size_t len, char *out,
+                    size_t outLen);
 String stripTelnetIAC(const uint8_t *data, size_t len);
 String detectSuffix(const uint8_t *data, size_t len);
-String simpleHash(const String &s);
+uint32_t fnv1a32(const void *data, size_t len, uint32_t h = 2166136261u);
 String genId();
 bool parseHexBytes(const String &hex, std::vector<uint8_t> &out);
+// Turns suffix-style escapes (backslash followed by r, n or t) into the
+// control bytes they name.
+String unescapeCtl(const String &s);
 
 #endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+// Fan-out for every WebSocket send. Each client gets a byte budget covering
+// frames handed to AsyncWebSocket and not yet sent plus frames held back
+// here; a client over budget is handled by its channel's policy instead of
+// growing the socket queue without bound:
+//   COALESCE     hold only the newest frame (state-like channels)
+//   DROP_OLDEST  drop held frames, oldest first, to make room
+//   DISCONNECT   close the client (byte streams, where a gap is worse)
+
+enum WsFanPolicy : uint8_t {
+  WS_FAN_COALESCE,
+  WS_FAN_DROP_OLDEST,
+  WS_FAN_DISCONNECT,
+};
+
+static const size_t wsFanDefaultBudget = 16384;
+
+void wsFanConfigure(AsyncWebSocket &ws, WsFanPolicy policy,
+                    size_t budget = wsFanDefaultBudget);
+// Looks a channel up by its URL ("/ws"); false if unknown. A zero budget
+// keeps the current one.
+bool wsFanConfigure(const String &url, WsFanPolicy policy, size_t budget);
+// "coalesce", "drop-oldest" or "disconnect".
+bool wsFanParsePolicy(const String &name, WsFanPolicy &out);
+
+void wsFanText(AsyncWebSocket &ws, uint32_t clientId, const String &s);
+void wsFanBinary(AsyncWebSocket &ws, uint32_t clientId, const uint8_t *data,
+                 size_t len);
+void wsFanTextAll(AsyncWebSocket &ws, const String &s);
+
+// Call before anything sends.
+void wsFanBegin();
+// Moves held frames on as the socket queues drain; call from loop().
+void wsFanLoop();
+void wsFanStatsJson(JsonArray out);
@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+// Opt-in binary framing for the data sockets (/wsrs232, /term, /wsproxy,
+// /wsudp, /wstcpserver). A client sends {"action":"binary","on":true} and
+// from then on gets every data event as one binary message instead of a JSON
+// object carrying hex and ascii copies of the payload:
+//
+//   off  size  field
+//   0    1     version (WS_STREAM_VERSION)
+//   1    1     channel (WsChannel)
+//   2    1     direction (WsDir)
+//   3    1     flags, reserved (0)
+//   4    4     millis() timestamp, little-endian
+//   8    4     source IPv4, network byte order (0 if none)
+//   12   2     source port, little-endian (0 if none)
+//   14   2     payload length, little-endian
+//   16   len   payload
+//
+// Status, log and error messages stay JSON text for every client.
+
+#define WS_STREAM_VERSION 1
+#define WS_STREAM_HEADER 16
+
+enum WsChannel : uint8_t {
+  WS_CH_RS232 = 1,
+  WS_CH_TERM = 2,
+  WS_CH_PROXY = 3,
+  WS_CH_UDP = 4,
+  WS_CH_TCPSERVER = 5,
+};
+
+enum WsDir : uint8_t {
+  WS_DIR_RX = 0,
+  WS_DIR_TX = 1,
+};
+
+// Call first from a socket's event handler. Tracks the binary opt-in and
+// returns true if the event was consumed.
+bool wsStreamNegotiate(AsyncWebSocket *ws, AsyncWebSocketClient *client,
+                       AwsEventType type, uint8_t *data, size_t len);
+
+// Sends a data event. Binary clients get the raw frame; if any JSON client is
+// connected, json (already holding the channel's metadata fields) is given
+// "hex" and "ascii" and sent to them.
+void wsStreamData(AsyncWebSocket &ws, WsChannel ch, WsDir dir,
+                  const uint8_t *data, size_t len, JsonDocument &json,
+                  const IPAddress &srcIp = IPAddress(), uint16_t srcPort = 0);
@@ -3,33 +3,73 @@
 #include "Utils.h"
 #include "WiFiHelper.h"
 #include <ArduinoJson.h>
-#include <MD5Builder.h>
 #include <WiFiUdp.h>
+#include <algorithm>
+#include <errno.h>
 #include <lwip/etharp.h>
 #include <lwip/netif.h>
+#include <lwip/sockets.h>
 
 std::vector<DevStatus> devStatuses;
 bool discRunning = false;
 uint32_t discProgress = 0;
 uint32_t discStartedMs = 0;
-std::vector<String> discFound;
+std::vector<DiscHost> discFound;
+uint16_t discSweep = 0;
+DiscStats discStats;
 
 static String discSubnetBase = "";
 static uint8_t discFrom = 1;
 static uint8_t discTo = 254;
-static std::vector<uint16_t> discPorts;
+static std::vector<uint16_t> discPorts;      // for the next sweep
+static std::vector<uint16_t> discSweepPorts; // what discFound's masks index
+static SemaphoreHandle_t discMutex = nullptr;
+static SemaphoreHandle_t devMutex = nullptr;
 
-static const uint16_t pjlinkPort = 4352;
+DiscLock::DiscLock() : RecursiveLock(discMutex) {}
+DevLock::DevLock() : RecursiveLock(devMutex) {}
+
+void discBegin() {
+  discMutex = xSemaphoreCreateRecursiveMutex();
+  devMutex = xSemaphoreCreateRecursiveMutex();
+}
+
+// What a fingerprint id stands for. DiscHost rows only keep the index.
+struct DiscProfile {
+  const char *fingerprint;
+  const char *templateId;
+  const char *suffix;
+  uint16_t port; // preferred control port when the banner decides it
+  const char *nameHint;
+};
+
+enum : uint8_t {
+  DISC_FP_NONE,
+  DISC_FP_SAMSUNG_MDC,
+  DISC_FP_KRAMER,
+  DISC_FP_EXTRON,
+  DISC_FP_LIGHTWARE,
+  DISC_FP_AMX,
+  DISC_FP_CRESTRON,
+};
+
+static const DiscProfile discProfiles[] = {
+    {"", "", "", 0, ""},
+    {"samsung-mdc", "TPL_SAMSUNG_MDC_EXAMPLE", "", 1515,
+     "Samsung Display (MDC)"},
+    {"kramer", "TPL_KRAMER_P3000", "\\r\\n", 5000, "Kramer (P3000)"},
+    {"extron", "TPL_EXTRON_TELNET", "\\r", 23, "Extron (Telnet)"},
+    {"lightware", "TPL_LIGHTWARE_LW3", "\\r\\n", 6100, "Lightware"},
+    {"amx", "", "\\r", 23, "AMX"},
+    {"crestron", "", "\\r", 41794, "Crestron"},
+};
 
 struct Suggest {
-  String fingerprint;
-  String templateId;
-  String suffix;
+  uint8_t profile = DISC_FP_NONE;
   uint16_t bestPort = 0;
-  String nameHint;
 };
 
-static String getMacFromArp(const IPAddress &ip) {
+static bool getMacFromArp(const IPAddress &ip, uint8_t mac[6]) {
   ip4_addr_t i;
   i.addr = ip;
   struct netif *netif = netif_list;
@@ -37,15 +77,12 @@ static String getMacFromArp(const IPAddress &ip) {
     eth_addr *eth_ret;
     const ip4_addr_t *ip_ret;
     if (etharp_find_addr(netif, &i, &eth_ret, &ip_ret) != -1) {
-      char buf[20];
-      snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
-               eth_ret->addr[0], eth_ret->addr[1], eth_ret->addr[2],
-               eth_ret->addr[3], eth_ret->addr[4], eth_ret->addr[5]);
-      return String(buf);
+      memcpy(mac, eth_ret->addr, 6);
+      return true;
     }
     netif = netif->next;
   }
-  return "";
+  return false;
 }
 
 bool tcpProbe(const IPAddress &ip, uint16_t port, uint16_t timeoutMs) {
@@ -157,42 +194,21 @@ static Suggest makeSuggestion(const String &banner,
   b.toLowerCase();
   if (std::find(openPorts.begin(), openPorts.end(), (uint16_t)1515) !=
       openPorts.end()) {
-    s.templateId = "TPL_SAMSUNG_MDC_EXAMPLE";
-    s.suffix = "";
+    s.profile = DISC_FP_SAMSUNG_MDC;
     s.bestPort = 1515;
-    s.nameHint = "Samsung Display (MDC)";
-  }
-  if (b.indexOf("protocol 3000") >= 0 || b.indexOf("kramer") >= 0) {
-    s.templateId = "TPL_KRAMER_P3000";
-    s.suffix = "\\r\\n";
-    if (!s.bestPort)
-      s.bestPort = 5000;
-    s.nameHint = "Kramer (P3000)";
-  } else if (b.indexOf("extron") >= 0) {
-    s.templateId = "TPL_EXTRON_TELNET";
-    s.suffix = "\\r";
-    if (!s.bestPort)
-      s.bestPort = 23;
-    s.nameHint = "Extron (Telnet)";
-  } else if (b.indexOf("lightware") >= 0) {
-    s.templateId = "TPL_LIGHTWARE_LW3";
-    s.suffix = "\\r\\n";
-    if (!s.bestPort)
-      s.bestPort = 6100;
-    s.nameHint = "Lightware";
-  } else if (b.indexOf("amx") >= 0) {
-    s.templateId = "";
-    s.suffix = "\\r";
-    if (!s.bestPort)
-      s.bestPort = 23;
-    s.nameHint = "AMX";
-  } else if (b.indexOf("crestron") >= 0) {
-    s.templateId = "";
-    s.suffix = "\\r";
-    if (!s.bestPort)
-      s.bestPort = 41794;
-    s.nameHint = "Crestron";
   }
+  if (b.indexOf("protocol 3000") >= 0 || b.indexOf("kramer") >= 0)
+    s.profile = DISC_FP_KRAMER;
+  else if (b.indexOf("extron") >= 0)
+    s.profile = DISC_FP_EXTRON;
+  else if (b.indexOf("lightware") >= 0)
+    s.profile = DISC_FP_LIGHTWARE;
+  else if (b.indexOf("amx") >= 0)
+    s.profile = DISC_FP_AMX;
+  else if (b.indexOf("crestron") >= 0)
+    s.profile = DISC_FP_CRESTRON;
+  if (!s.bestPort)
+    s.bestPort = discProfiles[s.profile].port;
   if (!s.bestPort) {
     for (auto p : openPorts) {
       if (p == 23 || p == 5000 || p == 6100 || p == 1515) {
@@ -203,139 +219,523 @@ static Suggest makeSuggestion(const String &banner,
     if (!s.bestPort && !openPorts.empty())
       s.bestPort = openPorts[0];
   }
-  s.fingerprint = banner;
   return s;
 }
 
+void discHostToJson(const DiscHost &h, JsonObject row) {
+  row["ip"] = IPAddress(h.ip).toString();
+  JsonArray open = row["openPorts"].to<JsonArray>();
+  for (size_t i = 0; i < discSweepPorts.size(); i++)
+    if (h.openMask & (1UL << i))
+      open.add(discSweepPorts[i]);
+  const DiscProfile &p = discProfiles[h.profile];
+  row["fingerprint"] = p.fingerprint;
+  row["suggestedTemplateId"] = p.templateId;
+  row["suggestedSuffix"] = p.suffix;
+  row["suggestedPort"] = h.bestPort;
+  row["nameHint"] = p.nameHint;
+  if (h.hasMac) {
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X", h.mac[0],
+             h.mac[1], h.mac[2], h.mac[3], h.mac[4], h.mac[5]);
+    row["mac"] = mac;
+  }
+  row["seenMs"] = h.seenMs;
+}
+
+// Fingerprint a responsive host and publish its row.
+static void discReportHost(const IPAddress &ip,
+                           const std::vector<uint16_t> &ports,
+                           const std::vector<uint16_t> &openPorts) {
+  String banner = "";
+  String tmp;
+  bool didTel = false;
+  for (auto p : openPorts) {
+    if (p == 23 || p == 5000 || p == 6100) {
+      bool kprobe = (p == 5000);
+      if (telnetBanner(ip, p, tmp, kprobe)) {
+        banner = tmp;
+        didTel = true;
+        break;
+      }
+    }
+  }
+  if (!didTel && std::find(openPorts.begin(), openPorts.end(), (uint16_t)80) !=
+                     openPorts.end()) {
+    if (httpBanner(ip, 80, tmp))
+      banner = tmp;
+  }
+  Suggest sug = makeSuggestion(banner, openPorts);
+  DiscHost h;
+  h.ip = ip;
+  h.seenMs = millis();
+  for (auto p : openPorts) {
+    auto it = std::find(ports.begin(), ports.end(), p);
+    if (it != ports.end())
+      h.openMask |= 1UL << (it - ports.begin());
+  }
+  h.bestPort = sug.bestPort;
+  h.profile = sug.profile;
+  h.hasMac = getMacFromArp(ip, h.mac);
+
+  JsonDocument row;
+  {
+    DiscLock lock;
+    discFound.push_back(h);
+    discHostToJson(h, row.to<JsonObject>());
+  }
+  String out;
+  serializeJson(row, out);
+  wsTextAll(wsDisc, out);
+}
+
+// ── Sweep engine ──
+// Keeps up to discWindow non-blocking connects in flight and multiplexes
+// them with select(). The connect timeout follows the measured SYN/ACK (or
+// RST) round trip the way TCP's RTO does (RFC 6298), so a quiet LAN is swept
+// at wire speed while slow links still get their time. If lwIP runs out of
+// sockets the window simply stays smaller until probes drain.
+
+static const uint16_t discInitTimeoutMs = 200;
+static const uint16_t discMinTimeoutMs = 80;
+static const uint16_t discMaxTimeoutMs = 600;
+
+struct DiscProbe {
+  int fd;
+  uint16_t hostIdx;
+  uint16_t port;
+  uint32_t startMs;
+};
+
+struct DiscRtt {
+  int32_t srtt = 0;
+  int32_t rttvar = 0;
+  bool primed = false;
+
+  void sample(int32_t r) {
+    if (!primed) {
+      srtt = r;
+      rttvar = r / 2;
+      primed = true;
+      return;
+    }
+    rttvar = (3 * rttvar + abs(srtt - r)) / 4;
+    srtt = (7 * srtt + r) / 8;
+  }
+  uint16_t timeoutMs() const {
+    if (!primed)
+      return discInitTimeoutMs;
+    return (uint16_t)constrain(srtt + 4 * rttvar, (int32_t)discMinTimeoutMs,
+                               (int32_t)discMaxTimeoutMs);
+  }
+};
+
+// Returns the socket, -1 if no socket is available, -2 if the connect
+// failed outright (no route).
+int discConnect(const IPAddress &ip, uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0)
+    return -1;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = (uint32_t)ip;
+  if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 &&
+      errno != EINPROGRESS) {
+    close(fd);
+    return -2;
+  }
+  return fd;
+}
+
+// Reset instead of FIN so no TIME_WAIT PCBs pile up during a sweep.
+void discClose(int fd) {
+  struct linger lg = {1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+  close(fd);
+}
+
+static uint16_t discWindow = 32;
+
 static void discTask(void *) {
-  discRunning = true;
   discStartedMs = millis();
   discProgress = 0;
-  discFound.clear();
-  const uint16_t timeoutMs = 120;
-  for (uint16_t host = discFrom; host <= discTo; host++) {
-    if (!discRunning)
-      break;
+  std::vector<uint16_t> ports;
+  {
+    DiscLock lock;
+    ports = discPorts;
+    discSweepPorts = ports;
+    discFound.clear();
+    discSweep++;
+  }
+  discStats = DiscStats();
+  discStats.window = discWindow;
+
+  const uint16_t hostCount = discTo >= discFrom ? discTo - discFrom + 1 : 0;
+  const uint16_t portCount = ports.size();
+  std::vector<uint16_t> pending(hostCount, portCount);
+  std::vector<std::vector<uint16_t>> openPorts(hostCount);
+  std::vector<DiscProbe> inflight;
+  inflight.reserve(discWindow);
+  DiscRtt rtt;
+  uint32_t next = 0; // next (host, port) pair to launch
+  const uint32_t total = (uint32_t)hostCount * portCount;
+  uint32_t stallEndMs = 0; // probes older than this saw a banner grab
+  uint16_t reported = 0;   // hosts finished, in order
+
+  auto hostIp = [&](uint16_t idx) {
     IPAddress ip;
-    ip.fromString(discSubnetBase + "." + String(host));
+    ip.fromString(discSubnetBase + "." + String(discFrom + idx));
+    return ip;
+  };
 
-    // Check all ports
-    std::vector<uint16_t> openPorts;
-    bool alive = false;
-    for (auto p : discPorts) {
-      if (!discRunning)
-        break;
-      if (tcpProbe(ip, p, timeoutMs)) {
-        alive = true;
-        openPorts.push_back(p);
-      }
-      vTaskDelay(2 / portTICK_PERIOD_MS);
+  auto resolve = [&](const DiscProbe &p, bool isOpen) {
+    discStats.probes++;
+    if (isOpen) {
+      discStats.open++;
+      openPorts[p.hostIdx].push_back(p.port);
     }
+    pending[p.hostIdx]--;
+  };
 
-    if (alive) {
-      String banner = "";
-      String tmp;
-      bool didTel = false;
-      for (auto p : openPorts) {
-        if (p == 23 || p == 5000 || p == 6100) {
-          bool kprobe = (p == 5000);
-          if (telnetBanner(ip, p, tmp, kprobe)) {
-            banner = tmp;
-            didTel = true;
-            break;
-          }
+  while (discRunning && (next < total || !inflight.empty())) {
+    // Top up the window.
+    while (next < total && inflight.size() < discWindow) {
+      uint16_t hostIdx = next / portCount;
+      uint16_t port = ports[next % portCount];
+      int fd = discConnect(hostIp(hostIdx), port);
+      if (fd == -1)
+        break; // out of sockets; retry once some drain
+      next++;
+      DiscProbe p = {fd, hostIdx, port, (uint32_t)millis()};
+      if (fd < 0)
+        resolve(p, false);
+      else
+        inflight.push_back(p);
+    }
+
+    if (!inflight.empty()) {
+      uint32_t now = millis();
+      uint16_t timeoutMs = rtt.timeoutMs();
+      uint32_t waitMs = 20;
+      fd_set wfds;
+      FD_ZERO(&wfds);
+      int maxFd = -1;
+      for (auto &p : inflight) {
+        FD_SET(p.fd, &wfds);
+        maxFd = max(maxFd, p.fd);
+        uint32_t age = now - p.startMs;
+        waitMs = min(waitMs, age >= timeoutMs ? 0 : timeoutMs - age);
+      }
+      struct timeval tv;
+      tv.tv_sec = 0;
+      tv.tv_usec = waitMs * 1000;
+      int n = select(maxFd + 1, nullptr, &wfds, nullptr, &tv);
+
+      now = millis();
+      timeoutMs = rtt.timeoutMs();
+      for (size_t i = 0; i < inflight.size();) {
+        DiscProbe &p = inflight[i];
+        bool done = false;
+        if (n > 0 && FD_ISSET(p.fd, &wfds)) {
+          int err = 0;
+          socklen_t len = sizeof(err);
+          getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+          // Both SYN/ACK and RST are a full round trip.
+          if ((err == 0 || err == ECONNREFUSED) && p.startMs >= stallEndMs)
+            rtt.sample((int32_t)(now - p.startMs));
+          resolve(p, err == 0);
+          done = true;
+        } else if (now - p.startMs >= timeoutMs) {
+          resolve(p, false);
+          done = true;
+        }
+        if (done) {
+          discClose(p.fd);
+          inflight[i] = inflight.back();
+          inflight.pop_back();
+        } else {
+          i++;
         }
       }
-      if (!didTel && std::find(openPorts.begin(), openPorts.end(),
-                               (uint16_t)80) != openPorts.end()) {
-        if (httpBanner(ip, 80, tmp))
-          banner = tmp;
+    } else if (next < total) {
+      vTaskDelay(5 / portTICK_PERIOD_MS); // waiting for a free socket
+    }
+
+    // Report finished hosts in address order as soon as they complete.
+    while (reported < hostCount && pending[reported] == 0 && discRunning) {
+      if (!openPorts[reported].empty()) {
+        discReportHost(hostIp(reported), ports, openPorts[reported]);
+        stallEndMs = millis();
       }
-      Suggest sug = makeSuggestion(banner, openPorts);
-      JsonDocument row;
-      row["ip"] = ip.toString();
-      JsonArray open = row["openPorts"].to<JsonArray>();
-      for (auto p : openPorts)
-        open.add(p);
-      row["fingerprint"] = sug.fingerprint;
-      row["suggestedTemplateId"] = sug.templateId;
-      row["suggestedSuffix"] = sug.suffix;
-      row["suggestedPort"] = sug.bestPort;
-      row["nameHint"] = sug.nameHint;
-      String mac = getMacFromArp(ip);
-      if (mac.length())
-        row["mac"] = mac;
-      row["seenMs"] = millis();
-      String out;
-      serializeJson(row, out);
-      discFound.push_back(out);
-      wsTextAll(wsDisc, out);
+      reported++;
+      discProgress++;
     }
-    discProgress++;
-    vTaskDelay(3 / portTICK_PERIOD_MS);
+    discStats.timeoutMs = rtt.timeoutMs();
+    discStats.elapsedMs = millis() - discStartedMs;
+    if (discStats.elapsedMs)
+      discStats.probesPerSec = discStats.probes * 1000.0f / discStats.elapsedMs;
   }
+
+  for (auto &p : inflight)
+    discClose(p.fd);
   discRunning = false;
-  wsTextAll(wsDisc, R"({"type":"done"})");
+
+  JsonDocument done;
+  done["type"] = "done";
+  done["hosts"] = discProgress;
+  done["probes"] = discStats.probes;
+  done["probesPerSec"] = discStats.probesPerSec;
+  done["elapsedMs"] = discStats.elapsedMs;
+  String out;
+  serializeJson(done, out);
+  wsTextAll(wsDisc, out);
   vTaskDelete(nullptr);
 }
 
-void startDisc() {
-  if (discRunning)
-    return;
-  discPorts = {23, 80, 443, 8080, 5000, 6100, 1515, 4352, 41794};
-  IPAddress myIp = WiFi.localIP();
-  discSubnetBase =
-      String(myIp[0]) + "." + String(myIp[1]) + "." + String(myIp[2]);
-  discFrom = 1;
-  discTo = 254;
+bool startDisc(const String &subnet, uint8_t from, uint8_t to,
+               const std::vector<uint16_t> &ports, uint32_t window) {
+  // Rows keep open ports as a bitmap over the port list.
+  DiscLock lock;
+  if (discRunning || ports.size() > discMaxPorts)
+    return false;
+  discPorts = ports;
+  if (discPorts.empty())
+    discPorts = {23, 80, 443, 8080, 5000, 6100, 1515, 4352, 41794};
+  discSubnetBase = subnet;
+  if (!discSubnetBase.length()) {
+    IPAddress myIp = WiFi.localIP();
+    discSubnetBase =
+        String(myIp[0]) + "." + String(myIp[1]) + "." + String(myIp[2]);
+  }
+  discFrom = from ? from : 1;
+  discTo = to ? to : 254;
+  if (window)
+    discWindow = constrain(window, 1u, 64u);
+  discRunning = true;
   xTaskCreate(discTask, "discTask", 5000, nullptr, 1, nullptr);
+  return true;
+}
+
+// Caller holds a DevLock.
+static DevStatus &devStatusFor(const String &id) {
+  for (auto &s : devStatuses)
+    if (s.id == id)
+      return s;
+  DevStatus ns;
+  ns.id = id;
+  devStatuses.push_back(ns);
+  return devStatuses.back();
 }
 
 void updateDevStatus(const String &id, bool online, const String &ip,
-                     uint16_t port) {
-  DevStatus *found = nullptr;
-  for (auto &s : devStatuses) {
-    if (s.id == id) {
-      found = &s;
-      break;
-    }
+                     uint16_t port, int32_t rttMs) {
+  DevLock lock;
+  DevStatus &s = devStatusFor(id);
+  s.online = online;
+  if (online)
+    s.lastSeenMs = millis();
+  s.lastIp = ip;
+  s.lastPort = port;
+  s.probes++;
+  if (!online)
+    s.fails++;
+  if (rttMs < 0)
+    return;
+
+  s.rtt[s.rttPos] = (uint16_t)min(rttMs, (int32_t)0xFFFF);
+  s.rttPos = (s.rttPos + 1) % devRttSamples;
+  if (s.rttCount < devRttSamples)
+    s.rttCount++;
+  uint16_t sorted[devRttSamples];
+  memcpy(sorted, s.rtt, s.rttCount * sizeof(uint16_t));
+  std::sort(sorted, sorted + s.rttCount);
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < s.rttCount; i++)
+    sum += sorted[i];
+  s.rttMinMs = sorted[0];
+  s.rttAvgMs = sum / s.rttCount;
+  s.rttP95Ms = sorted[(s.rttCount * 95 + 99) / 100 - 1];
+}
+
+// ── Health scheduler ──
+// Each device has its own probe interval: a few quick confirmations after a
+// state change, a steady period while online, and exponential backoff while
+// offline. Due probes run as non-blocking connects (same engine as the
+// sweep), at most monWindow at a time and at most monBudgetPerSec launched
+// per second so a large device list never floods the LAN.
+
+uint16_t monBudgetPerSec = 20;
+uint8_t monWindow = 8;
+
+static const uint16_t monTimeoutMs = 400;
+static const uint32_t monFastMs = 1000;
+static const uint8_t monFastProbes = 3;
+static const uint32_t monSteadyMs = 8000;
+static const uint32_t monOfflineMinMs = 2000;
+static const uint32_t monOfflineMaxMs = 60000;
+
+// Probe targets, rebuilt from deviceRegistry only when it changes.
+struct MonTarget {
+  String id;
+  String ip;
+  IPAddress addr;
+  uint16_t port;
+  uint32_t dueMs = 0;
+  uint32_t intervalMs = 0;
+  uint8_t fastLeft = 0;
+  bool known = false;
+  bool online = false;
+  int fd = -1;
+  uint32_t startMs = 0;
+};
+
+static void monResolve(MonTarget &t, bool ok, int32_t rttMs) {
+  if (!t.known || ok != t.online)
+    t.fastLeft = monFastProbes;
+  t.known = true;
+  t.online = ok;
+  if (t.fastLeft) {
+    t.fastLeft--;
+    t.intervalMs = monFastMs;
+  } else if (ok) {
+    t.intervalMs = monSteadyMs;
+  } else {
+    t.intervalMs = constrain(t.intervalMs * 2, monOfflineMinMs, monOfflineMaxMs);
   }
-  if (!found) {
-    DevStatus ns;
-    ns.id = id;
-    devStatuses.push_back(ns);
-    found = &devStatuses.back();
+  t.dueMs = millis() + t.intervalMs;
+  DevLock lock;
+  updateDevStatus(t.id, ok, t.ip, t.port, rttMs);
+  DevStatus &s = devStatusFor(t.id);
+  s.intervalMs = t.intervalMs;
+  s.nextProbeMs = t.dueMs;
+}
+
+static void monRebuild(std::vector<MonTarget> &targets) {
+  std::vector<MonTarget> next;
+  for (auto &d : deviceRegistry.all()) {
+    if (!d.id.length() || !(uint32_t)d.addr || !d.portHint)
+      continue;
+    MonTarget t;
+    for (auto &old : targets) {
+      // Keep schedule and any in-flight probe for unchanged targets.
+      if (old.id == d.id && old.addr == d.addr && old.port == d.portHint) {
+        t = old;
+        old.fd = -1;
+        break;
+      }
+    }
+    t.id = d.id;
+    t.ip = d.ip;
+    t.addr = d.addr;
+    t.port = d.portHint;
+    next.push_back(t);
   }
-  found->online = online;
-  if (online)
-    found->lastSeenMs = millis();
-  found->lastIp = ip;
-  found->lastPort = port;
+  for (auto &old : targets)
+    if (old.fd >= 0)
+      discClose(old.fd);
+  targets.swap(next);
 }
 
 void deviceMonitorTask(void *) {
+  std::vector<MonTarget> targets;
+  uint32_t targetsGen = 0;
+  float tokens = 0;
+  uint32_t refillMs = millis();
   for (;;) {
-    if (WiFi.status() == WL_CONNECTED) {
-      JsonDocument doc;
-      if (!deserializeJson(doc, cfgJson)) {
-        if (doc["devices"].is<JsonArray>()) {
-          for (JsonObject d : doc["devices"].as<JsonArray>()) {
-            String id = d["id"] | "";
-            String ip = d["ip"] | "";
-            uint16_t port = d["portHint"] | 0;
-            if (!id.length() || !ip.length() || port == 0)
-              continue;
-            IPAddress ipa;
-            if (!ipa.fromString(ip))
-              continue;
-            bool ok = tcpProbe(ipa, port, 120);
-            updateDevStatus(id, ok, ip, port);
-            vTaskDelay(10 / portTICK_PERIOD_MS);
-          }
-        }
+    {
+      CfgLock lock;
+      if (deviceRegistry.generation() != targetsGen) {
+        monRebuild(targets);
+        targetsGen = deviceRegistry.generation();
+      }
+    }
+    if (WiFi.status() != WL_CONNECTED || targets.empty()) {
+      vTaskDelay(500 / portTICK_PERIOD_MS);
+      continue;
+    }
+
+    uint32_t now = millis();
+    tokens = min((float)monBudgetPerSec,
+                 tokens + (now - refillMs) * monBudgetPerSec / 1000.0f);
+    refillMs = now;
+
+    // Launch due probes, most overdue first.
+    size_t inflight = 0;
+    for (auto &t : targets)
+      if (t.fd >= 0)
+        inflight++;
+    while (inflight < monWindow && tokens >= 1) {
+      MonTarget *due = nullptr;
+      for (auto &t : targets)
+        if (t.fd < 0 && (int32_t)(now - t.dueMs) >= 0 &&
+            (!due || (int32_t)(t.dueMs - due->dueMs) < 0))
+          due = &t;
+      if (!due)
+        break;
+      int fd = discConnect(due->addr, due->port);
+      if (fd == -1)
+        break; // out of sockets; retry once some drain
+      tokens -= 1;
+      if (fd < 0) {
+        monResolve(*due, false, -1);
+        continue;
+      }
+      due->fd = fd;
+      due->startMs = now;
+      inflight++;
+    }
+
+    // Wait for a connect to finish, a timeout, or the next due probe.
+    uint32_t waitMs = 250;
+    for (auto &t : targets) {
+      if (t.fd >= 0) {
+        uint32_t age = now - t.startMs;
+        waitMs = min(waitMs, age >= monTimeoutMs ? 0 : monTimeoutMs - age);
+      } else {
+        int32_t until = (int32_t)(t.dueMs - now);
+        waitMs = min(waitMs, (uint32_t)max(until, (int32_t)0));
+      }
+    }
+    if (!inflight) {
+      // Idle, or due probes are waiting on the budget.
+      vTaskDelay(max(waitMs, (uint32_t)20) / portTICK_PERIOD_MS);
+      continue;
+    }
+
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    int maxFd = -1;
+    for (auto &t : targets) {
+      if (t.fd >= 0) {
+        FD_SET(t.fd, &wfds);
+        maxFd = max(maxFd, t.fd);
+      }
+    }
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = max(waitMs, (uint32_t)5) * 1000;
+    int n = select(maxFd + 1, nullptr, &wfds, nullptr, &tv);
+
+    now = millis();
+    for (auto &t : targets) {
+      if (t.fd < 0)
+        continue;
+      if (n > 0 && FD_ISSET(t.fd, &wfds)) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(t.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        discClose(t.fd);
+        t.fd = -1;
+        monResolve(t, err == 0, err == 0 ? (int32_t)(now - t.startMs) : -1);
+      } else if (now - t.startMs >= monTimeoutMs) {
+        discClose(t.fd);
+        t.fd = -1;
+        monResolve(t, false, -1);
       }
     }
-    vTaskDelay(8000 / portTICK_PERIOD_MS);
   }
 }
 
@@ -356,38 +756,3 @@ void sendWol(const String &macStr) {
   udp.endPacket();
   logAll("WoL sent to " + macStr);
 }
-
-String pjlinkCmd(const String &ip, const String &password, const String &cmd) {
-  WiFiClient client;
-  if (!client.connect(ip.c_str(), pjlinkPort))
-    return "ERROR: Connect failed";
-  String banner = client.readStringUntil('\r');
-  if (!banner.startsWith("PJLINK ")) {
-    client.stop();
-    return "ERROR: Invalid banner: " + banner;
-  }
-  bool auth = banner.startsWith("PJLINK 1");
-  String prefix = "";
-  if (auth) {
-    if (password.length() == 0) {
-      client.stop();
-      return "ERROR: Password required";
-    }
-    int sp = banner.indexOf(' ');
-    if (sp > 0) {
-      String salt = banner.substring(sp + 1);
-      salt.trim();
-      MD5Builder md5;
-      md5.begin();
-      md5.add(salt);
-      md5.add(password);
-      md5.calculate();
-      prefix = md5.toString();
-    }
-  }
-  String full = prefix + cmd + "\r";
-  client.print(full);
-  String resp = client.readStringUntil('\r');
-  client.stop();
-  return resp;
-}
@@ -1,10 +1,36 @@
 #include "CaptureProxy.h"
 #include "Utils.h"
+#include "WsStream.h"
 #include <ArduinoJson.h>
 
 
-std::vector<Capture> caps;
-static const size_t MAX_CAPS = 160;
+// Capture arena: records (CaptureRec + payload, padded to 4 bytes) are
+// appended at capTail and evicted from capHead. A record never straddles the
+// end; when one doesn't fit, capWrapAt marks where the live data stops and
+// writing restarts at 0.
+//
+// Two indexes sit beside it, both storing arena offsets / 4 (+1 in the hash
+// table, 0 = empty):
+//  - capById: ids are handed out sequentially and evicted oldest-first, so
+//    the live ids are a contiguous range and id & capIdMask is a direct slot.
+//  - capByHash: open addressing with linear probing on CaptureRec::hash,
+//    which covers source, address, local port and payload. Repeats of any
+//    live capture inside capDedupMs fold into it.
+static const size_t defaultCapBytes = 16384;
+static const size_t maxCapBytes = 4 * 0xFFFF; // offsets / 4 fit in uint16_t
+static uint8_t *capArena = nullptr;
+static size_t capSize = 0;
+static size_t capHead = 0;
+static size_t capTail = 0;
+static size_t capWrapAt = 0;
+static size_t capCount = 0;
+static size_t capUsed = 0;
+static uint32_t capNextId = 1;
+static uint16_t *capById = nullptr;
+static uint32_t capIdMask = 0;
+static uint16_t *capByHash = nullptr;
+static uint32_t capHashMask = 0;
+uint32_t capDedupMs = 1500;
 
 uint16_t learnPort = 5000;
 bool learnEnabled = true;
@@ -23,18 +49,155 @@ struct ProxyPair {
 };
 static ProxyPair proxyPair;
 
-void addCapture(const String &srcIp, uint16_t srcPort, uint16_t localPort,
-                const uint8_t *data, size_t len) {
-  Capture c;
-  c.id = genId();
-  c.ts = millis();
-  c.lastTs = c.ts;
-  c.srcIp = srcIp;
-  c.srcPort = srcPort;
-  c.localPort = localPort;
-  c.hex = bytesToHex(data, len);
-  c.ascii = bytesToAscii(data, len);
-  c.suffixHint = detectSuffix(data, len);
+static size_t capRecSize(size_t len) {
+  return (sizeof(CaptureRec) + len + 3) & ~(size_t)3;
+}
+
+static CaptureRec *capAt(size_t off) { return (CaptureRec *)(capArena + off); }
+
+static size_t capOffsetOf(const CaptureRec *r) {
+  return (const uint8_t *)r - capArena;
+}
+
+static uint32_t nextPow2(uint32_t v) {
+  uint32_t p = 1;
+  while (p < v)
+    p <<= 1;
+  return p;
+}
+
+void captureSetCapacity(size_t bytes) {
+  bytes = constrain(bytes & ~(size_t)3, capRecSize(64), maxCapBytes);
+  // Every record is at least capRecSize(0), which bounds the live count.
+  uint32_t maxRecs = bytes / capRecSize(0) + 1;
+  uint32_t idSlots = nextPow2(maxRecs);
+  uint32_t hashSlots = nextPow2(maxRecs + maxRecs / 2);
+  uint8_t *arena = (uint8_t *)malloc(bytes);
+  uint16_t *byId = (uint16_t *)calloc(idSlots, sizeof(uint16_t));
+  uint16_t *byHash = (uint16_t *)calloc(hashSlots, sizeof(uint16_t));
+  if (!arena || !byId || !byHash) {
+    free(arena);
+    free(byId);
+    free(byHash);
+    return;
+  }
+  free(capArena);
+  free(capById);
+  free(capByHash);
+  capArena = arena;
+  capById = byId;
+  capByHash = byHash;
+  capIdMask = idSlots - 1;
+  capHashMask = hashSlots - 1;
+  capSize = bytes;
+  capHead = capTail = capCount = capUsed = 0;
+  capWrapAt = capSize;
+}
+
+static void capHashInsert(const CaptureRec *r) {
+  uint32_t i = r->hash & capHashMask;
+  while (capByHash[i])
+    i = (i + 1) & capHashMask;
+  capByHash[i] = capOffsetOf(r) / 4 + 1;
+}
+
+// Backward-shift delete keeps probe chains intact without tombstones.
+static void capHashRemove(const CaptureRec *r) {
+  uint16_t want = capOffsetOf(r) / 4 + 1;
+  uint32_t i = r->hash & capHashMask;
+  while (capByHash[i] != want) {
+    if (!capByHash[i])
+      return;
+    i = (i + 1) & capHashMask;
+  }
+  uint32_t j = i;
+  for (;;) {
+    capByHash[i] = 0;
+    for (;;) {
+      j = (j + 1) & capHashMask;
+      if (!capByHash[j])
+        return;
+      uint32_t home = capAt((capByHash[j] - 1) * 4)->hash & capHashMask;
+      // Move j back to i unless its home lies cyclically in (i, j].
+      if (i <= j ? (home <= i || home > j) : (home <= i && home > j))
+        break;
+    }
+    capByHash[i] = capByHash[j];
+    i = j;
+  }
+}
+
+size_t captureCapacity() { return capSize; }
+size_t captureUsed() { return capUsed; }
+size_t captureCount() { return capCount; }
+
+static void capEvictOldest() {
+  CaptureRec *r = capAt(capHead);
+  size_t sz = capRecSize(r->len);
+  capHashRemove(r);
+  capById[r->id & capIdMask] = 0;
+  capHead += sz;
+  capUsed -= sz;
+  if (--capCount == 0) {
+    capHead = capTail = 0;
+    capWrapAt = capSize;
+  } else if (capHead >= capWrapAt) {
+    capHead = 0;
+    capWrapAt = capSize;
+  }
+}
+
+// Makes room for need bytes at capTail, evicting as required.
+static CaptureRec *capAlloc(size_t need) {
+  for (;;) {
+    if (capCount == 0 || capTail > capHead) {
+      if (capTail + need <= capSize)
+        break;
+      capWrapAt = capTail;
+      capTail = 0;
+      continue;
+    }
+    if (capTail + need <= capHead)
+      break;
+    capEvictOldest();
+  }
+  CaptureRec *r = capAt(capTail);
+  capTail += need;
+  capUsed += need;
+  capCount++;
+  return r;
+}
+
+void addCapture(CapSource source, uint32_t srcIp, uint16_t srcPort,
+                uint16_t localPort, const uint8_t *data, size_t len) {
+  if (!capArena)
+    captureSetCapacity(defaultCapBytes);
+  if (!capArena)
+    return;
+  uint32_t now = millis();
+
+  // Keep a single capture to at most half the arena.
+  len = min(len, min((size_t)0xFFFF, capSize / 2 - sizeof(CaptureRec)));
+
+  // The sender's port is left out: polling controllers reconnect from a
+  // new ephemeral port for every command.
+  uint32_t key[3] = {source, srcIp, localPort};
+  uint32_t hash = fnv1a32(data, len, fnv1a32(key, sizeof(key)));
+
+  CaptureRec *dup = nullptr;
+  for (uint32_t i = hash & capHashMask; capByHash[i];
+       i = (i + 1) & capHashMask) {
+    CaptureRec *r = capAt((capByHash[i] - 1) * 4);
+    if (r->hash == hash && r->source == source && r->srcIp == srcIp &&
+        r->localPort == localPort && r->len == len &&
+        !memcmp(r->data(), data, len) && (!dup || r->lastTs > dup->lastTs))
+      dup = r;
+  }
+  if (dup && now - dup->lastTs < capDedupMs) {
+    dup->repeats++;
+    dup->lastTs = now;
+    return;
+  }
 
   int textCount = 0;
   for (size_t i = 0; i < len; i++) {
@@ -43,22 +206,79 @@ void addCapture(const String &srcIp, uint16_t srcPort, uint16_t localPort,
     else if (data[i] == '\r' || data[i] == '\n' || data[i] == '\t')
       textCount++;
   }
-  c.payloadType = (len > 0 && (float)textCount / len > 0.85) ? "ascii" : "hex";
 
-  c.hash = simpleHash(c.srcIp + ":" + String(c.srcPort) + "|" + c.hex);
+  CaptureRec *c = capAlloc(capRecSize(len));
+  memset(c, 0, sizeof(*c));
+  c->id = capNextId++;
+  c->ts = now;
+  c->lastTs = now;
+  c->repeats = 1;
+  c->srcIp = srcIp;
+  c->srcPort = srcPort;
+  c->localPort = localPort;
+  c->len = len;
+  c->source = source;
+  c->payloadType = (len > 0 && (float)textCount / len > 0.85)
+                       ? CAP_PAYLOAD_ASCII
+                       : CAP_PAYLOAD_HEX;
+  c->hash = hash;
+  memcpy((uint8_t *)(c + 1), data, len);
+  capById[c->id & capIdMask] = capOffsetOf(c) / 4;
+  capHashInsert(c);
+}
 
-  if (!caps.empty()) {
-    Capture &last = caps.back();
-    if (last.hash == c.hash && (c.ts - last.lastTs) < 1500) {
-      last.repeats++;
-      last.lastTs = c.ts;
-      return;
+void captureForEach(bool newestFirst,
+                    const std::function<bool(CaptureRec &)> &fn) {
+  if (!newestFirst) {
+    size_t off = capHead;
+    for (size_t i = 0; i < capCount; i++) {
+      if (off >= capWrapAt)
+        off = 0;
+      CaptureRec *r = capAt(off);
+      off += capRecSize(r->len);
+      if (!fn(*r))
+        return;
     }
+    return;
   }
+  for (uint32_t id = capNextId - 1, n = 0; n < capCount; id--, n++)
+    if (!fn(*capAt(capById[id & capIdMask] * 4)))
+      return;
+}
 
-  if (caps.size() >= MAX_CAPS)
-    caps.erase(caps.begin());
-  caps.push_back(c);
+CaptureRec *findCapture(const String &id) {
+  if (!capCount)
+    return nullptr;
+  uint32_t want = strtoul(id.c_str(), nullptr, 16);
+  uint32_t oldest = capAt(capHead)->id;
+  if (want - oldest >= capCount) // also rejects want < oldest
+    return nullptr;
+  return capAt(capById[want & capIdMask] * 4);
+}
+
+String captureSrcIp(const CaptureRec &c) {
+  if (c.source == CAP_SRC_PROXY_RX)
+    return "PROXY RX(target->client)";
+  if (c.source == CAP_SRC_PROXY_TX)
+    return "PROXY TX(client->target)";
+  return IPAddress(c.srcIp).toString();
+}
+
+void captureToJson(const CaptureRec &c, JsonObject o) {
+  char id[16];
+  snprintf(id, sizeof(id), "%08lX", (unsigned long)c.id);
+  o["id"] = id;
+  o["ts"] = c.ts;
+  o["srcIp"] = captureSrcIp(c);
+  o["srcPort"] = c.srcPort;
+  o["localPort"] = c.localPort;
+  o["hex"] = bytesToHex(c.data(), c.len);
+  o["ascii"] = bytesToAscii(c.data(), c.len);
+  o["pinned"] = c.pinned;
+  o["repeats"] = c.repeats;
+  o["lastTs"] = c.lastTs;
+  o["suffixHint"] = detectSuffix(c.data(), c.len);
+  o["payloadType"] = c.payloadType == CAP_PAYLOAD_ASCII ? "ascii" : "hex";
 }
 
 void stopLearn() {
@@ -79,7 +299,7 @@ void startLearn() {
       [](void *, AsyncClient *client) {
         client->onData(
             [](void *, AsyncClient *c, void *data, size_t len) {
-              addCapture(c->remoteIP().toString(), c->remotePort(),
+              addCapture(CAP_SRC_LEARN, c->remoteIP(), c->remotePort(),
                          c->localPort(), (uint8_t *)data, len);
             },
             nullptr);
@@ -90,15 +310,6 @@ void startLearn() {
   logAll("Learner TCP listening on port " + String(learnPort));
 }
 
-bool getCaptureById(const String &id, Capture &out) {
-  for (auto &c : caps)
-    if (c.id == id) {
-      out = c;
-      return true;
-    }
-  return false;
-}
-
 void proxyStop() {
   proxyRunning = false;
 
@@ -123,16 +334,15 @@ static void proxyLog(const char *dir, const uint8_t *data, size_t len) {
   JsonDocument d;
   d["type"] = "data";
   d["dir"] = dir;
-  d["hex"] = bytesToHex(data, len);
-  d["ascii"] = bytesToAscii(data, len);
-  String s;
-  serializeJson(d, s);
-  wsTextAll(wsProxy, s);
-
-  if (proxyCaptureToLearn) {
-    String src = String("PROXY ") + String(dir);
-    addCapture(src, 0, proxyListenPort, data, len);
-  }
+  bool fromTarget = dir[0] == 'R';
+  AsyncClient *src = fromTarget ? proxyPair.outClient : proxyPair.inClient;
+  wsStreamData(wsProxy, WS_CH_PROXY, fromTarget ? WS_DIR_RX : WS_DIR_TX, data,
+               len, d, src ? src->remoteIP() : IPAddress(),
+               src ? src->remotePort() : 0);
+
+  if (proxyCaptureToLearn)
+    addCapture(fromTarget ? CAP_SRC_PROXY_RX : CAP_SRC_PROXY_TX, 0, 0,
+               proxyListenPort, data, len);
 }
 
 void proxyStart() {
@@ -1,9 +1,217 @@
 #include "ConfigManager.h"
 #include "Utils.h"
 #include <ArduinoJson.h>
+#include <memory>
 
 
-String cfgJson;
+DeviceRegistry deviceRegistry;
+TemplateRegistry templateRegistry;
+
+static SemaphoreHandle_t cfgMutex = nullptr;
+static String cfgOther;  // top-level keys other than devices/templates
+static std::shared_ptr<const String> cfgCache; // valid while !cfgDirty
+static bool cfgDirty = true;
+
+CfgLock::CfgLock() {
+  if (!cfgMutex)
+    cfgMutex = xSemaphoreCreateRecursiveMutex();
+  xSemaphoreTakeRecursive(cfgMutex, portMAX_DELAY);
+}
+
+CfgLock::~CfgLock() { xSemaphoreGiveRecursive(cfgMutex); }
+
+// Unknown keys ride along as a serialised JSON object so a config edited by
+// hand through /api/config round-trips.
+static String keepExtra(JsonObjectConst src, const char *const *known,
+                        size_t knownCount) {
+  JsonDocument extra;
+  JsonObject o = extra.to<JsonObject>();
+  for (JsonPairConst kv : src) {
+    bool isKnown = false;
+    for (size_t i = 0; i < knownCount && !isKnown; i++)
+      isKnown = !strcmp(kv.key().c_str(), known[i]);
+    if (!isKnown)
+      o[kv.key()] = kv.value();
+  }
+  if (!o.size())
+    return "";
+  String out;
+  serializeJson(extra, out);
+  return out;
+}
+
+static void mergeExtra(JsonObject dst, const String &extra) {
+  if (!extra.length())
+    return;
+  JsonDocument doc;
+  if (deserializeJson(doc, extra))
+    return;
+  for (JsonPair kv : doc.as<JsonObject>())
+    dst[kv.key()] = kv.value();
+}
+
+static const char *const deviceKeys[] = {
+    "id",         "name", "ip",  "portHint",  "defaultSuffix",     "notes",
+    "templateId", "mac",  "lastSeenMs", "defaultPayloadType"};
+
+const Device *DeviceRegistry::find(const String &id) const {
+  for (auto &d : _devices)
+    if (d.id == id)
+      return &d;
+  return nullptr;
+}
+
+void DeviceRegistry::add(const Device &d) {
+  CfgLock lock;
+  _devices.push_back(d);
+  _generation++;
+  cfgDirty = true;
+}
+
+bool DeviceRegistry::remove(const String &id) {
+  CfgLock lock;
+  for (size_t i = 0; i < _devices.size(); i++) {
+    if (_devices[i].id == id) {
+      _devices.erase(_devices.begin() + i);
+      _generation++;
+      cfgDirty = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+void DeviceRegistry::fromJson(JsonArrayConst arr) {
+  CfgLock lock;
+  _devices.clear();
+  for (JsonObjectConst o : arr) {
+    Device d;
+    d.id = o["id"] | "";
+    d.name = o["name"] | "";
+    d.ip = o["ip"] | "";
+    d.portHint = o["portHint"] | 0;
+    d.defaultSuffix = o["defaultSuffix"] | "";
+    d.notes = o["notes"] | "";
+    d.templateId = o["templateId"] | "";
+    d.defaultPayloadType = o["defaultPayloadType"] | "";
+    d.mac = o["mac"] | "";
+    d.lastSeenMs = o["lastSeenMs"] | 0;
+    d.extra = keepExtra(o, deviceKeys,
+                        sizeof(deviceKeys) / sizeof(deviceKeys[0]));
+    if (!d.addr.fromString(d.ip))
+      d.addr = IPAddress();
+    _devices.push_back(d);
+  }
+  _generation++;
+  cfgDirty = true;
+}
+
+static void deviceToJson(const Device &d, JsonObject o) {
+  o["id"] = d.id;
+  o["name"] = d.name;
+  o["ip"] = d.ip;
+  o["portHint"] = d.portHint;
+  o["defaultSuffix"] = d.defaultSuffix;
+  o["notes"] = d.notes;
+  o["templateId"] = d.templateId;
+  o["defaultPayloadType"] = d.defaultPayloadType;
+  o["mac"] = d.mac;
+  o["lastSeenMs"] = d.lastSeenMs;
+  mergeExtra(o, d.extra);
+}
+
+void DeviceRegistry::toJson(JsonArray arr) const {
+  CfgLock lock;
+  for (auto &d : _devices)
+    deviceToJson(d, arr.add<JsonObject>());
+}
+
+void DeviceRegistry::writeJson(Print &out) const {
+  CfgLock lock;
+  JsonDocument doc;
+  out.print('[');
+  for (size_t i = 0; i < _devices.size(); i++) {
+    if (i)
+      out.print(',');
+    doc.clear();
+    deviceToJson(_devices[i], doc.to<JsonObject>());
+    serializeJson(doc, out);
+  }
+  out.print(']');
+}
+
+static const char *const templateKeys[] = {
+    "id", "name", "kind", "defaultPort", "defaultSuffix", "defaultCommands"};
+
+const DeviceTemplate *TemplateRegistry::find(const String &id) const {
+  for (auto &t : _templates)
+    if (t.id == id)
+      return &t;
+  return nullptr;
+}
+
+void TemplateRegistry::fromJson(JsonArrayConst arr) {
+  CfgLock lock;
+  _templates.clear();
+  for (JsonObjectConst o : arr) {
+    DeviceTemplate t;
+    t.id = o["id"] | "";
+    t.name = o["name"] | "";
+    t.kind = o["kind"] | "";
+    t.defaultPort = o["defaultPort"] | 0;
+    t.defaultSuffix = o["defaultSuffix"] | "";
+    for (JsonObjectConst c : o["defaultCommands"].as<JsonArrayConst>()) {
+      TemplateCommand cmd;
+      cmd.name = c["name"] | "";
+      cmd.payloadType = c["payloadType"] | "";
+      cmd.payload = c["payload"] | "";
+      cmd.suffix = c["suffix"] | "";
+      t.defaultCommands.push_back(cmd);
+    }
+    t.extra = keepExtra(o, templateKeys,
+                        sizeof(templateKeys) / sizeof(templateKeys[0]));
+    _templates.push_back(t);
+  }
+  _generation++;
+  cfgDirty = true;
+}
+
+static void templateToJson(const DeviceTemplate &t, JsonObject o) {
+  o["id"] = t.id;
+  o["name"] = t.name;
+  o["kind"] = t.kind;
+  o["defaultPort"] = t.defaultPort;
+  o["defaultSuffix"] = t.defaultSuffix;
+  JsonArray cmds = o["defaultCommands"].to<JsonArray>();
+  for (auto &c : t.defaultCommands) {
+    JsonObject co = cmds.add<JsonObject>();
+    co["name"] = c.name;
+    co["payloadType"] = c.payloadType;
+    co["payload"] = c.payload;
+    co["suffix"] = c.suffix;
+  }
+  mergeExtra(o, t.extra);
+}
+
+void TemplateRegistry::toJson(JsonArray arr) const {
+  CfgLock lock;
+  for (auto &t : _templates)
+    templateToJson(t, arr.add<JsonObject>());
+}
+
+void TemplateRegistry::writeJson(Print &out) const {
+  CfgLock lock;
+  JsonDocument doc;
+  out.print('[');
+  for (size_t i = 0; i < _templates.size(); i++) {
+    if (i)
+      out.print(',');
+    doc.clear();
+    templateToJson(_templates[i], doc.to<JsonObject>());
+    serializeJson(doc, out);
+  }
+  out.print(']');
+}
 
 String defaultCfgJson() {
   return R"JSON({
@@ -53,62 +261,93 @@ String defaultCfgJson() {
 })JSON";
 }
 
+bool setCfgJson(const char *json, size_t len) {
+  JsonDocument doc;
+  if (deserializeJson(doc, json, len) || !doc.is<JsonObject>())
+    return false;
+  static const char *const topKeys[] = {"devices", "templates"};
+  CfgLock lock;
+  deviceRegistry.fromJson(doc["devices"].as<JsonArrayConst>());
+  templateRegistry.fromJson(doc["templates"].as<JsonArrayConst>());
+  cfgOther = keepExtra(doc.as<JsonObjectConst>(), topKeys, 2);
+  cfgDirty = true;
+  return true;
+}
+
+// Appends to a String, so the config can be serialised one record at a
+// time instead of through a JsonDocument holding all of it.
+class StringPrint : public Print {
+public:
+  explicit StringPrint(String &s) : _s(s) {}
+  size_t write(uint8_t c) override { return _s.concat((char)c) ? 1 : 0; }
+  size_t write(const uint8_t *buf, size_t len) override {
+    return _s.concat((const char *)buf, len) ? len : 0;
+  }
+
+private:
+  String &_s;
+};
+
+std::shared_ptr<const String> cfgSnapshot() {
+  CfgLock lock;
+  if (cfgDirty || !cfgCache) {
+    std::shared_ptr<String> s(new String());
+    if (cfgCache)
+      s->reserve(cfgCache->length() + 64);
+    StringPrint out(*s);
+    out.print("{\"devices\":");
+    deviceRegistry.writeJson(out);
+    out.print(",\"templates\":");
+    templateRegistry.writeJson(out);
+    // cfgOther is a compact object; splice its members in.
+    if (cfgOther.length() > 2) {
+      out.print(',');
+      out.write((const uint8_t *)cfgOther.c_str() + 1, cfgOther.length() - 2);
+    }
+    out.print('}');
+    cfgCache = s;
+    cfgDirty = false;
+  }
+  return cfgCache;
+}
+
+String cfgJson() { return *cfgSnapshot(); }
+
 void loadCfg() {
-  cfgJson = prefs.getString("cfg_json", defaultCfgJson());
-  if (cfgJson.length() < 10)
-    cfgJson = defaultCfgJson();
+  String raw = prefs.getString("cfg_json", "");
+  if (raw.length() < 10 || !setCfgJson(raw.c_str(), raw.length())) {
+    String def = defaultCfgJson();
+    setCfgJson(def.c_str(), def.length());
+  }
 }
 
-void saveCfg() { prefs.putString("cfg_json", cfgJson); }
+void saveCfg() { prefs.putString("cfg_json", *cfgSnapshot()); }
 
 bool updateCfgWithDevice(const String &name, const String &ip,
                          uint16_t portHint, const String &suffixHint,
                          const String &notes, const String &templateId,
                          const String &payloadType, const String &mac) {
-  JsonDocument doc;
-  if (deserializeJson(doc, cfgJson))
-    return false;
-
-  if (!doc["devices"].is<JsonArray>())
-    doc["devices"] = JsonArray();
-
-  JsonArray devs = doc["devices"].as<JsonArray>();
-  JsonObject d = devs.add<JsonObject>();
-  d["id"] = genId();
-  d["name"] = name;
-  d["ip"] = ip;
-  d["portHint"] = portHint;
-  d["defaultSuffix"] = suffixHint;
-  d["notes"] = notes;
-  d["templateId"] = templateId;
-  d["defaultPayloadType"] = payloadType;
-  d["mac"] = mac;
-  d["lastSeenMs"] = millis();
-
-  String out;
-  serializeJson(doc, out);
-  cfgJson = out;
+  Device d;
+  d.id = genId();
+  d.name = name;
+  d.ip = ip;
+  d.portHint = portHint;
+  d.defaultSuffix = suffixHint;
+  d.notes = notes;
+  d.templateId = templateId;
+  d.defaultPayloadType = payloadType;
+  d.mac = mac;
+  d.lastSeenMs = millis();
+  if (!d.addr.fromString(ip))
+    d.addr = IPAddress();
+  deviceRegistry.add(d);
   saveCfg();
   return true;
 }
 
 bool removeDevice(const String &id) {
-  JsonDocument doc;
-  if (deserializeJson(doc, cfgJson))
-    return false;
-  if (!doc["devices"].is<JsonArray>())
+  if (!deviceRegistry.remove(id))
     return false;
-
-  JsonArray devs = doc["devices"].as<JsonArray>();
-  for (int i = 0; i < (int)devs.size(); i++) {
-    if (devs[i]["id"] == id) {
-      devs.remove(i);
-      String out;
-      serializeJson(doc, out);
-      cfgJson = out;
-      saveCfg();
-      return true;
-    }
-  }
-  return false;
+  saveCfg();
+  return true;
 }
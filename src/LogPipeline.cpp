@@ -0,0 +1,277 @@
+#include "LogPipeline.h"
+#include "AppConfig.h"
+#include "RecursiveLock.h"
+#include <algorithm>
+#include <atomic>
+#include <stdarg.h>
+
+// A slot's stamp is the seq it holds once complete and 0 while a producer
+// is filling it. Readers copy the record and recheck the stamp, so a slot
+// overwritten mid-copy is seen as lapped rather than read torn.
+//
+// busy gives the slot to one producer at a time. A producer that laps the
+// ring onto a slot another one is still filling gives its record up and
+// leaves its seq in skipped, so readers know not to wait for it.
+struct LogSlot {
+  std::atomic<uint32_t> stamp{0};
+  std::atomic<uint32_t> skipped{0};
+  std::atomic<bool> busy{false};
+  LogRec rec;
+};
+
+static LogSlot ring[logSlots];
+static std::atomic<uint32_t> logHead{1}; // next seq to claim
+static std::atomic<uint32_t> droppedCount{0};
+static TaskHandle_t writerTask = nullptr;
+
+struct ModLevel {
+  char module[logModuleMax];
+  std::atomic<uint8_t> level;
+};
+
+static const size_t logMaxModules = 16;
+static ModLevel modLevels[logMaxModules];
+// Entries below modCount are complete; only logSetLevel() appends.
+static std::atomic<uint8_t> modCount{0};
+static std::atomic<uint8_t> defaultLevel{LOGLV_INFO};
+static SemaphoreHandle_t logMutex = nullptr;
+
+static const char *const levelNames[] = {"error", "warn", "info", "debug"};
+static const char levelTags[] = "EWID";
+
+// Serializes logSetLevel() only; producers never take it.
+struct LogLock : RecursiveLock {
+  LogLock() : RecursiveLock(logMutex) {}
+};
+
+static ModLevel *findModule(const char *module) {
+  uint8_t n = modCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < n; i++)
+    if (!strcasecmp(modLevels[i].module, module))
+      return &modLevels[i];
+  return nullptr;
+}
+
+bool logEnabled(LogLevel level, const char *module) {
+  ModLevel *m = findModule(module ? module : "app");
+  uint8_t max = m ? m->level.load(std::memory_order_relaxed)
+                  : defaultLevel.load(std::memory_order_relaxed);
+  return level <= max;
+}
+
+// Claims the next slot and marks it in progress, or returns null if a
+// producer a whole lap behind still holds it. A producer only waits for its
+// own copy, never for another task.
+static LogSlot *claim(uint32_t &seq) {
+  seq = logHead.fetch_add(1, std::memory_order_relaxed);
+  LogSlot &s = ring[seq & (logSlots - 1)];
+  if (s.busy.exchange(true, std::memory_order_acquire)) {
+    s.skipped.store(seq, std::memory_order_release);
+    if (writerTask)
+      xTaskNotifyGive(writerTask);
+    return nullptr;
+  }
+  s.stamp.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return &s;
+}
+
+static void commit(LogSlot &s, uint32_t seq, LogLevel level,
+                   const char *module) {
+  s.rec.seq = seq;
+  s.rec.ms = millis();
+  s.rec.level = level;
+  snprintf(s.rec.module, sizeof(s.rec.module), "%s", module ? module : "app");
+  s.stamp.store(seq, std::memory_order_release);
+  s.busy.store(false, std::memory_order_release);
+  if (writerTask)
+    xTaskNotifyGive(writerTask);
+}
+
+static void logText(LogLevel level, const char *module, const char *text) {
+  if (!logEnabled(level, module))
+    return;
+  uint32_t seq;
+  LogSlot *slot = claim(seq);
+  if (!slot)
+    return;
+  snprintf(slot->rec.text, sizeof(slot->rec.text), "%s", text);
+  commit(*slot, seq, level, module);
+}
+
+void logAt(LogLevel level, const char *module, const String &s) {
+  logText(level, module, s.c_str());
+}
+
+void logFmt(LogLevel level, const char *module, const char *fmt, ...) {
+  if (!logEnabled(level, module))
+    return;
+  uint32_t seq;
+  LogSlot *slot = claim(seq);
+  if (!slot)
+    return;
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(slot->rec.text, sizeof(slot->rec.text), fmt, ap);
+  va_end(ap);
+  commit(*slot, seq, level, module);
+}
+
+void logAll(const String &s) {
+  // "SSDP: Scan complete" -> module "SSDP", text "Scan complete"
+  char module[logModuleMax];
+  size_t n = 0;
+  const char *p = s.c_str();
+  while (n < logModuleMax - 1 && (isalnum((unsigned char)p[n]) || p[n] == '_'))
+    n++;
+  if (n && p[n] == ':' && p[n + 1] == ' ') {
+    memcpy(module, p, n);
+    module[n] = 0;
+    logText(LOGLV_INFO, module, p + n + 2);
+  } else {
+    logText(LOGLV_INFO, nullptr, p);
+  }
+}
+
+// False if seq isn't readable yet; lapped is set when it never will be.
+static bool readSlot(uint32_t seq, LogRec &out, bool &lapped) {
+  LogSlot &s = ring[seq & (logSlots - 1)];
+  uint32_t st = s.stamp.load(std::memory_order_acquire);
+  lapped = (st && (int32_t)(st - seq) > 0) ||
+           (int32_t)(s.skipped.load(std::memory_order_acquire) - seq) >= 0;
+  if (st != seq)
+    return false;
+  memcpy(&out, &s.rec, sizeof(out));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (s.stamp.load(std::memory_order_relaxed) != seq) {
+    lapped = true;
+    return false;
+  }
+  return true;
+}
+
+static void writeLine(uint8_t level, const char *module, const char *text) {
+  String line;
+  line.reserve(strlen(text) + 16);
+  if (level != LOGLV_INFO) {
+    line += '[';
+    line += levelTags[level];
+    line += "] ";
+  }
+  if (strcmp(module, "app")) {
+    line += module;
+    line += ": ";
+  }
+  line += text;
+  Serial.println(line);
+  wsTextAll(wsLog, line);
+}
+
+static void writerLoop(void *) {
+  uint32_t next = 1;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    uint32_t head = logHead.load(std::memory_order_acquire);
+    uint32_t lost = 0;
+    if (head - next > logSlots) {
+      lost = head - logSlots - next;
+      next = head - logSlots;
+    }
+    while (next != head) {
+      LogRec r;
+      bool lapped;
+      if (!readSlot(next, r, lapped)) {
+        if (!lapped)
+          break; // still being written; the producer will notify
+        lost++;
+        next++;
+        continue;
+      }
+      next++;
+      writeLine(r.level, r.module, r.text);
+    }
+    if (lost) {
+      droppedCount.fetch_add(lost, std::memory_order_relaxed);
+      char msg[40];
+      snprintf(msg, sizeof(msg), "%lu records dropped", (unsigned long)lost);
+      writeLine(LOGLV_WARN, "log", msg);
+    }
+  }
+}
+
+void logBegin() {
+  if (writerTask)
+    return;
+  logMutex = xSemaphoreCreateRecursiveMutex();
+  xTaskCreatePinnedToCore(writerLoop, "logWriter", 4096, nullptr, 1,
+                          &writerTask, 1);
+}
+
+bool logParseLevel(const String &name, LogLevel &out) {
+  for (uint8_t l = 0; l < 4; l++) {
+    if (name.equalsIgnoreCase(levelNames[l])) {
+      out = (LogLevel)l;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *logLevelName(uint8_t level) {
+  return level < 4 ? levelNames[level] : "?";
+}
+
+bool logSetLevel(const String &module, LogLevel level) {
+  if (module == "*") {
+    defaultLevel.store(level, std::memory_order_relaxed);
+    return true;
+  }
+  if (!module.length() || module.length() >= logModuleMax)
+    return false;
+  LogLock lock;
+  if (ModLevel *m = findModule(module.c_str())) {
+    m->level.store(level, std::memory_order_relaxed);
+    return true;
+  }
+  uint8_t n = modCount.load(std::memory_order_relaxed);
+  if (n >= logMaxModules)
+    return false;
+  snprintf(modLevels[n].module, logModuleMax, "%s", module.c_str());
+  modLevels[n].level.store(level, std::memory_order_relaxed);
+  modCount.store(n + 1, std::memory_order_release);
+  return true;
+}
+
+void logLevelsJson(JsonObject out) {
+  out["*"] = levelNames[defaultLevel.load(std::memory_order_relaxed)];
+  uint8_t n = modCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < n; i++)
+    out[(const char *)modLevels[i].module] =
+        levelNames[modLevels[i].level.load(std::memory_order_relaxed)];
+}
+
+uint32_t logOldestSeq() {
+  uint32_t head = logHead.load(std::memory_order_acquire);
+  return head > logSlots ? head - logSlots : 1;
+}
+
+uint32_t logDropped() { return droppedCount.load(std::memory_order_relaxed); }
+
+void logForEach(uint32_t since,
+                const std::function<bool(const LogRec &)> &fn) {
+  uint32_t head = logHead.load(std::memory_order_acquire);
+  uint32_t seq = std::max(since + 1, logOldestSeq());
+  LogRec r;
+  bool lapped;
+  for (; (int32_t)(head - seq) > 0; seq++)
+    if (readSlot(seq, r, lapped) && !fn(r))
+      return;
+}
+
+void logRecToJson(const LogRec &r, JsonObject o) {
+  o["seq"] = r.seq;
+  o["ms"] = r.ms;
+  o["level"] = logLevelName(r.level);
+  o["module"] = r.module;
+  o["text"] = r.text;
+}
@@ -1,22 +1,162 @@
 #include "MacroHandler.h"
 #include "AppConfig.h"
 #include "RS232Handler.h"
+#include "TcpPool.h"
 #include "Utils.h"
 #include <WiFi.h>
 #include <WiFiUdp.h>
+#include <deque>
 
 MacroHandler macroHandler;
 extern void logAll(const String &s);
 
-void MacroHandler::begin() { load(); }
+static QueueHandle_t macroQueue = nullptr;
+static SemaphoreHandle_t runsMutex = nullptr;
+static SemaphoreHandle_t targetTableMutex = nullptr;
+static std::deque<std::shared_ptr<MacroRun>> macroRuns; // oldest first
+static uint32_t nextRunId = 1;
+
+class RunsLock {
+public:
+  RunsLock() { xSemaphoreTake(runsMutex, portMAX_DELAY); }
+  ~RunsLock() { xSemaphoreGive(runsMutex); }
+};
+
+static void macroWorker(void *parameter);
+
+void MacroHandler::begin() {
+  load();
+  runsMutex = xSemaphoreCreateMutex();
+  targetTableMutex = xSemaphoreCreateMutex();
+  macroQueue = xQueueCreate(macroQueueLen, sizeof(MacroRun *));
+  for (uint8_t i = 0; i < macroWorkers; i++)
+    xTaskCreatePinnedToCore(macroWorker, "MacroWorker", 4096, nullptr, 1,
+                            nullptr, 1);
+}
 
 void MacroHandler::loop() {
-  if (_pendingRun) {
-    _pendingRun = false;
-    doExecute(_pendingId);
+  static uint32_t lastExpire = 0;
+  if (millis() - lastExpire > 1000) {
+    lastExpire = millis();
+    tcpPoolExpire();
   }
 }
 
+static MacroStep stepFromJson(JsonObject s) {
+  MacroStep step;
+  step.type = s["type"].as<String>();
+  step.target = s["target"] | "";
+  step.port = s["port"] | 0;
+  step.payload = s["payload"] | "";
+  step.mode = s["mode"] | "ascii";
+  step.suffix = s["suffix"] | "";
+  step.delayMs = s["delay"] | 500;
+  step.expect = s["expect"] | "";
+  step.timeoutMs = s["timeout"] | 0;
+  return step;
+}
+
+static void stepToJson(const MacroStep &s, JsonObject so) {
+  so["type"] = s.type;
+  so["target"] = s.target;
+  so["port"] = s.port;
+  so["payload"] = s.payload;
+  so["mode"] = s.mode;
+  so["suffix"] = s.suffix;
+  so["delay"] = s.delayMs;
+  if (s.expect.length())
+    so["expect"] = s.expect;
+  if (s.timeoutMs)
+    so["timeout"] = s.timeoutMs;
+}
+
+size_t MacroPlan::sizeBytes() const {
+  size_t n = sizeof(MacroPlan) + steps.size() * sizeof(MacroPlanStep) +
+             bytes.size();
+  for (auto &h : hosts)
+    n += h.length() + 1;
+  return n;
+}
+
+static void compileStep(const MacroStep &s, size_t idx, MacroPlan &plan) {
+  auto fail = [&](const char *why) {
+    plan.errors.push_back("step " + String(idx + 1) + ": " + why);
+  };
+  MacroPlanStep ps = {};
+  ps.hostIdx = -1;
+  ps.delayMs = s.delayMs;
+  ps.atMs = plan.durationMs;
+  if (s.type == "tcp")
+    ps.op = MOP_TCP;
+  else if (s.type == "udp")
+    ps.op = MOP_UDP;
+  else if (s.type == "rs232")
+    ps.op = MOP_RS232;
+  else if (s.type == "delay")
+    ps.op = MOP_DELAY;
+  else
+    return fail("unknown step type");
+
+  if (ps.op != MOP_DELAY) {
+    std::vector<uint8_t> data;
+    if (s.mode == "hex") {
+      if (!parseHexBytes(s.payload, data))
+        return fail("bad hex payload");
+    } else {
+      data.assign((const uint8_t *)s.payload.c_str(),
+                  (const uint8_t *)s.payload.c_str() + s.payload.length());
+    }
+    String suffix = unescapeCtl(s.suffix);
+    data.insert(data.end(), (const uint8_t *)suffix.c_str(),
+                (const uint8_t *)suffix.c_str() + suffix.length());
+    if (data.size() > 0xFFFF)
+      return fail("payload too long");
+    ps.dataOff = plan.bytes.size();
+    ps.dataLen = data.size();
+    plan.bytes.insert(plan.bytes.end(), data.begin(), data.end());
+  }
+
+  if (ps.op == MOP_TCP || ps.op == MOP_UDP) {
+    if (!s.port)
+      return fail("no port");
+    ps.port = s.port;
+    if (!s.target.length())
+      return fail("no target");
+    if (!ps.addr.fromString(s.target)) {
+      // Host names are looked up when the step runs.
+      ps.hostIdx = plan.hosts.size();
+      plan.hosts.push_back(s.target);
+    }
+  }
+
+  if (ps.op == MOP_TCP) {
+    String expect = unescapeCtl(s.expect);
+    if (expect.length() > macroExpectMax)
+      return fail("expect longer than 32 bytes");
+    ps.expectOff = plan.bytes.size();
+    ps.expectLen = expect.length();
+    plan.bytes.insert(plan.bytes.end(), (const uint8_t *)expect.c_str(),
+                      (const uint8_t *)expect.c_str() + expect.length());
+    ps.timeoutMs = s.timeoutMs ? s.timeoutMs : (ps.expectLen ? 2000 : 200);
+  }
+  plan.steps.push_back(ps);
+  plan.durationMs +=
+      plan.spacingMs && ps.op != MOP_DELAY ? plan.spacingMs : ps.delayMs;
+}
+
+static std::shared_ptr<const MacroPlan> compileMacro(const Macro &m) {
+  std::shared_ptr<MacroPlan> plan = std::make_shared<MacroPlan>();
+  plan->name = m.name;
+  plan->spacingMs = m.spacingMs;
+  plan->steps.reserve(m.steps.size());
+  for (size_t i = 0; i < m.steps.size(); i++)
+    compileStep(m.steps[i], i, *plan);
+  plan->bytes.shrink_to_fit();
+  for (auto &e : plan->errors)
+    logAll("Macro " + m.name + ": " + e);
+  return plan;
+}
+
 void MacroHandler::load() {
   _macros.clear();
   String raw = prefs.getString("macros", "[]");
@@ -31,19 +171,12 @@ void MacroHandler::load() {
     macro.id = m["id"].as<String>();
     macro.name = m["name"].as<String>();
     macro.icon = m["icon"] | "▶";
+    macro.spacingMs = m["spacing"] | 0;
     if (m["steps"].is<JsonArray>()) {
-      for (JsonObject s : m["steps"].as<JsonArray>()) {
-        MacroStep step;
-        step.type = s["type"].as<String>();
-        step.target = s["target"] | "";
-        step.port = s["port"] | 0;
-        step.payload = s["payload"] | "";
-        step.mode = s["mode"] | "ascii";
-        step.suffix = s["suffix"] | "";
-        step.delayMs = s["delay"] | 500;
-        macro.steps.push_back(step);
-      }
+      for (JsonObject s : m["steps"].as<JsonArray>())
+        macro.steps.push_back(stepFromJson(s));
     }
+    macro.plan = compileMacro(macro);
     _macros.push_back(macro);
   }
   logAll("Macros: loaded " + String(_macros.size()));
@@ -57,26 +190,121 @@ void MacroHandler::persist() {
     obj["id"] = m.id;
     obj["name"] = m.name;
     obj["icon"] = m.icon;
+    if (m.spacingMs)
+      obj["spacing"] = m.spacingMs;
     JsonArray steps = obj["steps"].to<JsonArray>();
-    for (const auto &s : m.steps) {
-      JsonObject so = steps.add<JsonObject>();
-      so["type"] = s.type;
-      so["target"] = s.target;
-      so["port"] = s.port;
-      so["payload"] = s.payload;
-      so["mode"] = s.mode;
-      so["suffix"] = s.suffix;
-      so["delay"] = s.delayMs;
-    }
+    for (const auto &s : m.steps)
+      stepToJson(s, steps.add<JsonObject>());
   }
   String out;
   serializeJson(doc, out);
   prefs.putString("macros", out);
 }
 
+static const char *runStateName(MacroRunState st) {
+  switch (st) {
+  case RUN_QUEUED:
+    return "queued";
+  case RUN_RUNNING:
+    return "running";
+  case RUN_DONE:
+    return "done";
+  }
+  return "?";
+}
+
+static const char *macroOpName(MacroOp op) {
+  switch (op) {
+  case MOP_TCP:
+    return "tcp";
+  case MOP_UDP:
+    return "udp";
+  case MOP_RS232:
+    return "rs232";
+  case MOP_DELAY:
+    return "delay";
+  }
+  return "?";
+}
+
+static String macroStepTarget(const MacroPlan &plan, const MacroPlanStep &st) {
+  if (st.op == MOP_RS232)
+    return "serial";
+  if (st.op == MOP_DELAY)
+    return String(st.delayMs) + " ms";
+  String host = st.hostIdx >= 0 ? plan.hosts[st.hostIdx] : st.addr.toString();
+  return host + ":" + String(st.port);
+}
+
+// Resolves the step's address, looking up host names when needed.
+static bool macroStepAddr(const MacroPlan &plan, const MacroPlanStep &st,
+                          IPAddress &addr) {
+  if (st.hostIdx < 0) {
+    addr = st.addr;
+    return true;
+  }
+  return WiFi.hostByName(plan.hosts[st.hostIdx].c_str(), addr) == 1;
+}
+
+static const char *outcomeName(MacroOutcome o) {
+  switch (o) {
+  case MOUT_PENDING:
+    return "pending";
+  case MOUT_OK:
+    return "ok";
+  case MOUT_UNRESOLVED:
+    return "unresolved";
+  case MOUT_CONNECT_FAILED:
+    return "connectFailed";
+  case MOUT_SEND_FAILED:
+    return "sendFailed";
+  case MOUT_NO_REPLY:
+    return "noReply";
+  }
+  return "?";
+}
+
+static void traceStepJson(const MacroRun &r, size_t i, JsonObject o) {
+  const MacroPlanStep &st = r.plan->steps[i];
+  const MacroStepTrace &t = r.trace[i];
+  o["i"] = i;
+  o["type"] = macroOpName(st.op);
+  o["target"] = macroStepTarget(*r.plan, st);
+  o["plannedMs"] = t.plannedMs;
+  o["actualMs"] = t.actualMs;
+  o["durationMs"] = t.durationMs;
+  if (st.op == MOP_TCP) {
+    o["connectMs"] = t.connectMs;
+    o["reused"] = t.reused;
+    o["respBytes"] = t.respBytes;
+    o["respLatencyMs"] = t.respLatencyMs;
+  }
+  o["bytesSent"] = t.bytesSent;
+  o["outcome"] = outcomeName(t.outcome);
+}
+
+static void runSummaryJson(const MacroRun &r, JsonObject o) {
+  o["runId"] = r.id;
+  o["macroId"] = r.macroId;
+  o["name"] = r.plan->name;
+  o["state"] = runStateName(r.state);
+  o["step"] = r.step;
+  o["steps"] = r.plan->steps.size();
+  o["failedSteps"] = r.failedSteps;
+  o["queuedMs"] = r.queuedMs;
+  if (r.state != RUN_QUEUED)
+    o["startMs"] = r.startMs;
+  if (r.state == RUN_DONE)
+    o["endMs"] = r.endMs;
+  if (r.step) {
+    o["jitterMaxMs"] = r.jitterMaxMs;
+    o["jitterMeanMs"] = (float)r.jitterSumMs / r.step;
+  }
+}
+
 String MacroHandler::listJson() {
   JsonDocument doc;
-  JsonArray arr = doc.to<JsonArray>();
+  JsonArray arr = doc["macros"].to<JsonArray>();
   for (const auto &m : _macros) {
     JsonObject obj = arr.add<JsonObject>();
     obj["id"] = m.id;
@@ -84,6 +312,15 @@ String MacroHandler::listJson() {
     obj["icon"] = m.icon;
     obj["stepCount"] = m.steps.size();
   }
+  doc["workers"] = macroWorkers;
+  doc["queue"] = macroQueue ? uxQueueMessagesWaiting(macroQueue) : 0;
+  JsonArray runs = doc["runs"].to<JsonArray>();
+  {
+    RunsLock lock;
+    for (auto it = macroRuns.rbegin(); it != macroRuns.rend(); ++it) {
+      runSummaryJson(**it, runs.add<JsonObject>());
+    }
+  }
   String out;
   serializeJson(doc, out);
   return out;
@@ -96,17 +333,17 @@ String MacroHandler::getById(const String &id) {
       doc["id"] = m.id;
       doc["name"] = m.name;
       doc["icon"] = m.icon;
+      doc["spacing"] = m.spacingMs;
       JsonArray steps = doc["steps"].to<JsonArray>();
-      for (const auto &s : m.steps) {
-        JsonObject so = steps.add<JsonObject>();
-        so["type"] = s.type;
-        so["target"] = s.target;
-        so["port"] = s.port;
-        so["payload"] = s.payload;
-        so["mode"] = s.mode;
-        so["suffix"] = s.suffix;
-        so["delay"] = s.delayMs;
-      }
+      for (const auto &s : m.steps)
+        stepToJson(s, steps.add<JsonObject>());
+      JsonObject plan = doc["plan"].to<JsonObject>();
+      plan["steps"] = m.plan->steps.size();
+      plan["bytes"] = m.plan->sizeBytes();
+      plan["durationMs"] = m.plan->durationMs;
+      JsonArray errors = plan["errors"].to<JsonArray>();
+      for (auto &e : m.plan->errors)
+        errors.add(e);
       String out;
       serializeJson(doc, out);
       return out;
@@ -141,21 +378,14 @@ bool MacroHandler::save(const String &json) {
 
   target->name = doc["name"] | "Unnamed Macro";
   target->icon = doc["icon"] | "▶";
+  target->spacingMs = doc["spacing"] | 0;
   target->steps.clear();
 
   if (doc["steps"].is<JsonArray>()) {
-    for (JsonObject s : doc["steps"].as<JsonArray>()) {
-      MacroStep step;
-      step.type = s["type"].as<String>();
-      step.target = s["target"] | "";
-      step.port = s["port"] | 0;
-      step.payload = s["payload"] | "";
-      step.mode = s["mode"] | "ascii";
-      step.suffix = s["suffix"] | "";
-      step.delayMs = s["delay"] | 500;
-      target->steps.push_back(step);
-    }
+    for (JsonObject s : doc["steps"].as<JsonArray>())
+      target->steps.push_back(stepFromJson(s));
   }
+  target->plan = compileMacro(*target);
 
   persist();
   logAll("Macro saved: " + target->name + " (" + String(target->steps.size()) +
@@ -175,129 +405,368 @@ bool MacroHandler::remove(const String &id) {
   return false;
 }
 
-bool MacroHandler::execute(const String &id) {
-  if (_running)
-    return false;
-  _pendingRun = true;
-  _pendingId = id;
-  return true;
+String MacroHandler::traceJson(const String &id) {
+  RunsLock lock;
+  const MacroRun *run = nullptr;
+  for (auto it = macroRuns.rbegin(); it != macroRuns.rend() && !run; ++it)
+    if (String((*it)->id) == id || (*it)->macroId == id)
+      run = it->get();
+  if (!run)
+    return "";
+  JsonDocument doc;
+  runSummaryJson(*run, doc.to<JsonObject>());
+  doc["spacingMs"] = run->plan->spacingMs;
+  JsonArray steps = doc["trace"].to<JsonArray>();
+  for (uint16_t i = 0; i < run->step; i++)
+    traceStepJson(*run, i, steps.add<JsonObject>());
+  String out;
+  serializeJson(doc, out);
+  return out;
 }
 
-// Static FreeRTOS task function
-static void macroTaskCode(void *parameter) {
-  Macro *macroCopy = static_cast<Macro *>(parameter);
-
-  logAll("▶ Macro Task: " + macroCopy->name + " (" +
-         String(macroCopy->steps.size()) + " steps)");
-
-  for (size_t i = 0; i < macroCopy->steps.size(); i++) {
-    const auto &step = macroCopy->steps[i];
-    logAll("  Step " + String(i + 1) + ": " + step.type + " → " + step.target);
+bool MacroHandler::has(const String &id) {
+  for (const auto &m : _macros)
+    if (m.id == id)
+      return true;
+  return false;
+}
 
-    if (step.type == "tcp") {
-      macroHandler.executeTcpStep(step);
-    } else if (step.type == "rs232") {
-      macroHandler.executeRS232Step(step);
-    } else if (step.type == "udp") {
-      macroHandler.executeUdpStep(step);
-    } else if (step.type == "delay") {
-      vTaskDelay(pdMS_TO_TICKS(step.delayMs));
+uint32_t MacroHandler::execute(const String &id) {
+  const Macro *source = nullptr;
+  for (const auto &m : _macros) {
+    if (m.id == id) {
+      source = &m;
+      break;
     }
+  }
+  if (!source) {
+    logAll("Macro not found: " + id);
+    return 0;
+  }
 
-    // Inter-step delay
-    if (step.type != "delay" && step.delayMs > 0) {
-      vTaskDelay(pdMS_TO_TICKS(step.delayMs));
+  // The run holds its own reference to the compiled plan (in case the macro
+  // is saved or deleted while it is queued or running)
+  auto run = std::make_shared<MacroRun>();
+  run->macroId = id;
+  run->plan = source->plan;
+  run->queuedMs = millis();
+  run->trace.resize(run->plan->steps.size());
+
+  RunsLock lock;
+  MacroRun *p = run.get();
+  if (xQueueSend(macroQueue, &p, 0) != pdTRUE)
+    return 0;
+  run->id = nextRunId++;
+  macroRuns.push_back(run);
+  // Forget the oldest finished runs beyond the history size.
+  size_t finished = 0;
+  for (auto &r : macroRuns)
+    if (r->state == RUN_DONE)
+      finished++;
+  for (auto it = macroRuns.begin();
+       finished > macroRunHistory && it != macroRuns.end();) {
+    if ((*it)->state == RUN_DONE) {
+      it = macroRuns.erase(it);
+      finished--;
+    } else {
+      ++it;
     }
   }
+  return run->id;
+}
+
+size_t MacroHandler::planErrorCount(const String &id) {
+  for (const auto &m : _macros)
+    if (m.id == id)
+      return m.plan->errors.size();
+  return 0;
+}
+
+// ── Target serialisation ──
+// A worker holds at most one target at a time and waits on at most one, so
+// macroWorkers slots always suffice.
+struct TargetSlot {
+  uint64_t key;
+  uint8_t users; // holder plus waiters; 0 = slot free
+  SemaphoreHandle_t sem;
+};
 
-  logAll("✓ Macro Task complete: " + macroCopy->name);
+static TargetSlot targetSlots[macroWorkers];
 
-  // Cleanup
-  delete macroCopy;
-  macroHandler.setRunning(false);
-  vTaskDelete(NULL);
+static const uint64_t serialTargetKey = 1ull << 48;
+
+static uint64_t targetKey(const MacroPlanStep &st, const IPAddress &addr) {
+  if (st.op == MOP_RS232)
+    return serialTargetKey;
+  return ((uint64_t)(uint32_t)addr << 16) | st.port;
 }
 
-void MacroHandler::doExecute(const String &id) {
-  const Macro *sourceMacro = nullptr;
-  for (const auto &m : _macros) {
-    if (m.id == id) {
-      sourceMacro = &m;
-      break;
+static TargetSlot *targetAcquire(uint64_t key) {
+  xSemaphoreTake(targetTableMutex, portMAX_DELAY);
+  TargetSlot *slot = nullptr;
+  for (auto &t : targetSlots)
+    if (t.users && t.key == key)
+      slot = &t;
+  if (!slot) {
+    for (auto &t : targetSlots) {
+      if (!t.users) {
+        slot = &t;
+        break;
+      }
     }
+    slot->key = key;
+    if (!slot->sem)
+      slot->sem = xSemaphoreCreateMutex();
   }
+  slot->users++;
+  xSemaphoreGive(targetTableMutex);
+  xSemaphoreTake(slot->sem, portMAX_DELAY);
+  return slot;
+}
 
-  if (!sourceMacro) {
-    logAll("Macro not found: " + id);
+static void targetRelease(TargetSlot *slot) {
+  xSemaphoreGive(slot->sem);
+  xSemaphoreTake(targetTableMutex, portMAX_DELAY);
+  slot->users--;
+  xSemaphoreGive(targetTableMutex);
+}
+
+// Live trace on /wsmacro: a "run" event when a run starts or ends and a
+// "step" event as each step finishes.
+static void macroPush(const MacroRun &run, int stepIdx) {
+  if (!wsMacro.count())
     return;
+  JsonDocument doc;
+  {
+    RunsLock lock;
+    if (stepIdx < 0) {
+      doc["type"] = "run";
+      runSummaryJson(run, doc["run"].to<JsonObject>());
+    } else {
+      doc["type"] = "step";
+      doc["runId"] = run.id;
+      doc["macroId"] = run.macroId;
+      traceStepJson(run, stepIdx, doc["step"].to<JsonObject>());
+    }
   }
+  String out;
+  serializeJson(doc, out);
+  wsTextAll(wsMacro, out);
+}
 
-  _running = true;
-
-  // Make a copy of the macro to pass to the task (in case _macros is modified
-  // while running)
-  Macro *macroCopy = new Macro(*sourceMacro);
-
-  // Spawn FreeRTOS task on Core 1 (App Core) to avoid blocking the
-  // webserver/main loop
-  xTaskCreatePinnedToCore(macroTaskCode, // Task function
-                          "MacroTask",   // Name of task
-                          4096,          // Stack size
-                          macroCopy,     // Parameter
-                          1, // Priority (1 is standard Arduino loop priority)
-                          NULL, // Task handle
-                          1);   // Core to run on (1 = App core)
-}
-
-void MacroHandler::executeTcpStep(const MacroStep &step) {
-  WiFiClient client;
-  if (client.connect(step.target.c_str(), step.port, 3000)) {
-    String data = step.payload;
-    if (step.suffix == "\\r")
-      data += "\r";
-    else if (step.suffix == "\\n")
-      data += "\n";
-    else if (step.suffix == "\\r\\n")
-      data += "\r\n";
-
-    if (step.mode == "hex") {
-      std::vector<uint8_t> bytes;
-      if (parseHexBytes(data, bytes))
-        client.write(bytes.data(), bytes.size());
-    } else {
-      client.print(data);
+static void runMacro(MacroRun &run) {
+  const MacroPlan &plan = *run.plan;
+  logAll("▶ Macro run #" + String(run.id) + ": " + plan.name + " (" +
+         String(plan.steps.size()) + " steps)");
+
+  // Deadlines are absolute offsets from run start, so time spent executing
+  // a step never pushes back the ones after it.
+  const uint32_t t0 = run.startMs;
+  for (size_t i = 0; i < plan.steps.size(); i++) {
+    const MacroPlanStep &step = plan.steps[i];
+    int32_t waitMs = (int32_t)(t0 + step.atMs - millis());
+    if (waitMs > 0)
+      vTaskDelay(pdMS_TO_TICKS(waitMs));
+    MacroStepTrace tr;
+    tr.plannedMs = step.atMs;
+    tr.actualMs = millis() - t0;
+    uint32_t jitterMs = tr.actualMs > step.atMs ? tr.actualMs - step.atMs : 0;
+
+    logAll("  #" + String(run.id) + " step " + String(i + 1) + ": " +
+           macroOpName(step.op) + " → " + macroStepTarget(plan, step));
+
+    bool ok = true;
+    IPAddress addr;
+    if (step.op != MOP_DELAY && step.op != MOP_RS232 &&
+        !macroStepAddr(plan, step, addr)) {
+      logAll("    Cannot resolve " + plan.hosts[step.hostIdx]);
+      tr.outcome = MOUT_UNRESOLVED;
+      ok = false;
+    } else if (step.op != MOP_DELAY) {
+      TargetSlot *slot = targetAcquire(targetKey(step, addr));
+      switch (step.op) {
+      case MOP_TCP:
+        ok = macroHandler.executeTcpStep(plan, step, addr, tr);
+        break;
+      case MOP_RS232:
+        ok = macroHandler.executeRS232Step(plan, step, tr);
+        break;
+      case MOP_UDP:
+        ok = macroHandler.executeUdpStep(plan, step, addr, tr);
+        break;
+      case MOP_DELAY:
+        break;
+      }
+      targetRelease(slot);
     }
+    if (tr.outcome == MOUT_PENDING)
+      tr.outcome = MOUT_OK;
+    tr.durationMs = millis() - t0 - tr.actualMs;
+    {
+      RunsLock lock;
+      run.trace[i] = tr;
+      run.jitterMaxMs = max(run.jitterMaxMs, jitterMs);
+      run.jitterSumMs += jitterMs;
+      run.step = i + 1;
+      if (!ok)
+        run.failedSteps++;
+    }
+    macroPush(run, i);
+  }
+  if (plan.durationMs > millis() - t0) // trailing delay
+    vTaskDelay(pdMS_TO_TICKS(plan.durationMs - (millis() - t0)));
 
-    // Brief read for response
-    delay(200);
-    String resp = "";
-    while (client.available()) {
-      resp += (char)client.read();
+  logAll("✓ Macro run #" + String(run.id) + " complete: " + plan.name +
+         (run.failedSteps ? " (" + String(run.failedSteps) + " failed)" : "") +
+         ", jitter max " + String(run.jitterMaxMs) + " ms");
+}
+
+static void macroWorker(void *) {
+  for (;;) {
+    MacroRun *run = nullptr;
+    if (xQueueReceive(macroQueue, &run, portMAX_DELAY) != pdTRUE)
+      continue;
+    {
+      RunsLock lock;
+      run->state = RUN_RUNNING;
+      run->startMs = millis();
+    }
+    macroPush(*run, -1);
+    runMacro(*run);
+    {
+      RunsLock lock;
+      run->state = RUN_DONE;
+      run->endMs = millis();
     }
-    if (resp.length() > 0) {
-      logAll("    Response: " + resp.substring(0, 80));
+    macroPush(*run, -1);
+  }
+}
+
+// Steps with no expect end once the reply has been quiet this long.
+static const uint16_t tcpStepQuietMs = 30;
+
+bool MacroHandler::executeTcpStep(const MacroPlan &plan,
+                                  const MacroPlanStep &step,
+                                  const IPAddress &addr,
+                                  MacroStepTrace &trace) {
+  const uint8_t *data = plan.bytes.data() + step.dataOff;
+  const uint8_t *expect = plan.bytes.data() + step.expectOff;
+
+  // A pooled connection may have been dropped by the device since its last
+  // use; if the write fails, reconnect once.
+  WiFiClient *client = nullptr;
+  bool reused = false;
+  uint32_t connectMs = 0;
+  trace.outcome = MOUT_CONNECT_FAILED;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    client = tcpPoolAcquire(addr, step.port, 3000, &reused, &connectMs);
+    if (!client)
+      break;
+    trace.outcome = MOUT_PENDING;
+    uint8_t junk[64];
+    while (client->available()) // unsolicited output from earlier
+      client->read(junk, sizeof(junk));
+    if (client->write(data, step.dataLen) == step.dataLen)
+      break;
+    tcpPoolRelease(client, false);
+    client = nullptr;
+    trace.outcome = MOUT_SEND_FAILED;
+    if (!reused)
+      break;
+  }
+  if (!client) {
+    logAll("    TCP " +
+           String(trace.outcome == MOUT_SEND_FAILED ? "send" : "connect") +
+           " failed: " + macroStepTarget(plan, step));
+    return false;
+  }
+  trace.reused = reused;
+  trace.connectMs = connectMs;
+  trace.bytesSent = step.dataLen;
+
+  // Keep the first bytes of the reply for the log and a sliding window of
+  // the last expectLen bytes to spot the terminator.
+  char head[81];
+  size_t headLen = 0;
+  uint8_t tail[macroExpectMax];
+  size_t tailLen = 0;
+  uint32_t t0 = millis();
+  uint32_t firstRxMs = 0, lastRxMs = 0;
+  bool matched = false;
+  while (!matched && millis() - t0 < step.timeoutMs) {
+    int a = client->available();
+    if (a > 0) {
+      uint8_t buf[128];
+      int n = client->read(buf, min(a, (int)sizeof(buf)));
+      if (n <= 0)
+        break;
+      lastRxMs = millis();
+      if (!firstRxMs)
+        firstRxMs = lastRxMs;
+      trace.respBytes += n;
+      for (int i = 0; i < n && !matched; i++) {
+        if (headLen < sizeof(head) - 1)
+          head[headLen++] = (char)buf[i];
+        if (!step.expectLen)
+          continue;
+        if (tailLen == step.expectLen)
+          memmove(tail, tail + 1, --tailLen);
+        tail[tailLen++] = buf[i];
+        matched = tailLen == step.expectLen &&
+                  memcmp(tail, expect, step.expectLen) == 0;
+      }
+    } else {
+      if (!step.expectLen && lastRxMs &&
+          millis() - lastRxMs >= tcpStepQuietMs)
+        break;
+      if (!client->connected())
+        break;
+      vTaskDelay(1);
     }
-    client.stop();
-  } else {
-    logAll("    TCP connect failed: " + step.target + ":" + String(step.port));
   }
+  uint32_t doneMs = millis() - t0;
+  tcpPoolRelease(client, client->connected());
+  if (firstRxMs)
+    trace.respLatencyMs = firstRxMs - t0;
+  if (step.expectLen && !matched)
+    trace.outcome = MOUT_NO_REPLY;
+
+  String timing =
+      reused ? String("reused") : "connect " + String(connectMs) + " ms";
+  if (firstRxMs)
+    timing += ", rtt " + String(firstRxMs - t0) + " ms";
+  if (step.expectLen && !matched)
+    logAll("    No expected reply after " + String(doneMs) + " ms (" + timing +
+           ")");
+  else
+    logAll("    Done in " + String(doneMs) + " ms (" + timing + ")");
+  if (headLen > 0) {
+    head[headLen] = 0;
+    logAll("    Response: " + String(head));
+  }
+  return !step.expectLen || matched;
 }
 
-void MacroHandler::executeRS232Step(const MacroStep &step) {
-  rs232Send(step.payload, step.mode == "hex", step.suffix);
+bool MacroHandler::executeRS232Step(const MacroPlan &plan,
+                                    const MacroPlanStep &step,
+                                    MacroStepTrace &trace) {
+  rs232Write(plan.bytes.data() + step.dataOff, step.dataLen);
+  trace.bytesSent = step.dataLen;
+  return true;
 }
 
-void MacroHandler::executeUdpStep(const MacroStep &step) {
+bool MacroHandler::executeUdpStep(const MacroPlan &plan,
+                                  const MacroPlanStep &step,
+                                  const IPAddress &addr,
+                                  MacroStepTrace &trace) {
   WiFiUDP udp;
-  if (udp.beginPacket(step.target.c_str(), step.port)) {
-    String data = step.payload;
-    if (step.suffix == "\\r")
-      data += "\r";
-    else if (step.suffix == "\\n")
-      data += "\n";
-    else if (step.suffix == "\\r\\n")
-      data += "\r\n";
-    udp.write((uint8_t *)data.c_str(), data.length());
-    udp.endPacket();
-  }
+  trace.outcome = MOUT_SEND_FAILED;
+  if (!udp.beginPacket(addr, step.port))
+    return false;
+  udp.write(plan.bytes.data() + step.dataOff, step.dataLen);
+  if (udp.endPacket() != 1)
+    return false;
+  trace.outcome = MOUT_OK;
+  trace.bytesSent = step.dataLen;
+  return true;
 }
@@ -0,0 +1,272 @@
+#include "MdnsBrowser.h"
+#include "LogPipeline.h"
+#include "RecursiveLock.h"
+#include <mdns.h>
+
+static const uint32_t mdnsQueryMs = 3000;
+static const size_t mdnsQueryResults = 20; // per service type
+static const uint32_t mdnsDefaultTtl = 120; // s, when a record carries none
+static const size_t mdnsCacheMax = 64;
+static const size_t mdnsMaxTypes = 16; // concurrent queries per refresh
+static const char *const mdnsMetaType = "_services._dns-sd._udp";
+
+static const char *const mdnsDefaultTypes[] = {
+    "_airplay._tcp",    "_googlecast._tcp", "_netaudio-arc._udp",
+    "_dante._udp",      "_pjlink._tcp",     "_http._tcp",
+    "_crestron._tcp",   "_nvx._tcp",        "_qsc._tcp",
+    "_ssc._udp",
+};
+
+struct MdnsQuery {
+  String type;
+  mdns_search_once_t *search = nullptr;
+};
+
+static std::vector<MdnsService> cache;
+static std::vector<String> discoveredTypes; // from the meta-query
+static std::vector<String> pendingTypes;
+static std::vector<MdnsQuery> queries;
+static volatile bool refreshPending = false;
+static uint32_t refreshStartMs = 0;
+static uint32_t lastRefreshMs = 0;
+static SemaphoreHandle_t mdnsMutex = nullptr;
+
+// The web server task reads the cache while mdnsScanLoop() fills it.
+struct MdnsLock : RecursiveLock {
+  MdnsLock() : RecursiveLock(mdnsMutex) {}
+};
+
+static bool hasType(const std::vector<String> &v, const String &t) {
+  for (auto &s : v)
+    if (s.equalsIgnoreCase(t))
+      return true;
+  return false;
+}
+
+// "_http._tcp" -> "_http" / "_tcp"
+static bool splitType(const String &type, char *srv, size_t srvLen,
+                      char *proto, size_t protoLen) {
+  int dot = type.lastIndexOf('.');
+  if (dot <= 0)
+    return false;
+  String s = type.substring(0, dot);
+  String p = type.substring(dot + 1);
+  snprintf(srv, srvLen, "%s%s", s.startsWith("_") ? "" : "_", s.c_str());
+  snprintf(proto, protoLen, "%s%s", p.startsWith("_") ? "" : "_", p.c_str());
+  return true;
+}
+
+static String normaliseType(String t) {
+  t.trim();
+  t.toLowerCase();
+  if (t.endsWith(".local"))
+    t.remove(t.length() - 6);
+  if (t.length() && !t.startsWith("_"))
+    t = "_" + t;
+  return t;
+}
+
+static void expire(uint32_t now) {
+  for (size_t i = 0; i < cache.size();) {
+    if ((int32_t)(now - cache[i].expiresMs) >= 0)
+      cache.erase(cache.begin() + i);
+    else
+      i++;
+  }
+}
+
+static void mergeResult(const String &type, const mdns_result_t *r,
+                        uint32_t now) {
+  if (type == mdnsMetaType) {
+    // Meta-query answers name a service type, not an instance.
+    String t;
+    if (r->service_type && r->proto)
+      t = String(r->service_type) + "." + r->proto;
+    else if (r->instance_name)
+      t = r->instance_name;
+    t = normaliseType(t);
+    if (t.length() && !hasType(discoveredTypes, t))
+      discoveredTypes.push_back(t);
+    return;
+  }
+
+  String instance = r->instance_name ? r->instance_name : "";
+  String host = r->hostname ? r->hostname : "";
+  if (!instance.length() && !host.length())
+    return;
+
+  MdnsService *e = nullptr;
+  for (auto &c : cache)
+    if (c.type == type && c.instance == instance &&
+        (instance.length() || c.hostname == host))
+      e = &c;
+
+  // TTL 0 is a goodbye packet; one for an instance we never cached is
+  // dropped rather than added with the default TTL.
+  if (r->ttl == 0) {
+    if (e)
+      cache.erase(cache.begin() + (e - cache.data()));
+    return;
+  }
+
+  if (!e) {
+    if (cache.size() >= mdnsCacheMax) {
+      size_t oldest = 0;
+      for (size_t i = 1; i < cache.size(); i++)
+        if ((int32_t)(cache[i].expiresMs - cache[oldest].expiresMs) < 0)
+          oldest = i;
+      cache.erase(cache.begin() + oldest);
+    }
+    cache.push_back(MdnsService());
+    e = &cache.back();
+    e->type = type;
+    e->instance = instance;
+  }
+  if (host.length())
+    e->hostname = host;
+  if (r->port)
+    e->port = r->port;
+  for (mdns_ip_addr_t *a = r->addr; a; a = a->next) {
+    if (a->addr.type == ESP_IPADDR_TYPE_V4) {
+      e->ip = IPAddress(a->addr.u_addr.ip4.addr);
+      break;
+    }
+  }
+  if (r->txt_count) {
+    e->txt.clear();
+    for (size_t i = 0; i < r->txt_count; i++) {
+      MdnsTxt t;
+      t.key = r->txt[i].key ? r->txt[i].key : "";
+      if (r->txt[i].value) {
+        size_t len = r->txt_value_len ? r->txt_value_len[i]
+                                      : strlen(r->txt[i].value);
+        t.value.concat(r->txt[i].value, len);
+      }
+      e->txt.push_back(t);
+    }
+  }
+  e->seenMs = now;
+  e->expiresMs = now + (r->ttl ? r->ttl : mdnsDefaultTtl) * 1000UL;
+}
+
+bool mdnsBrowse(const std::vector<String> &types) {
+  MdnsLock lock;
+  if (refreshPending || !queries.empty())
+    return false;
+  pendingTypes.clear();
+  for (auto &t : types) {
+    String n = normaliseType(t);
+    if (n.indexOf('.') < 0)
+      n += "._tcp";
+    if (!hasType(pendingTypes, n))
+      pendingTypes.push_back(n);
+  }
+  if (pendingTypes.empty()) {
+    for (const char *t : mdnsDefaultTypes)
+      pendingTypes.push_back(t);
+    // Types seen by earlier meta-queries get browsed too.
+    for (auto &t : discoveredTypes)
+      if (pendingTypes.size() < mdnsMaxTypes && !hasType(pendingTypes, t))
+        pendingTypes.push_back(t);
+  }
+  if (pendingTypes.size() >= mdnsMaxTypes)
+    pendingTypes.resize(mdnsMaxTypes - 1);
+  pendingTypes.push_back(mdnsMetaType);
+  refreshPending = true;
+  return true;
+}
+
+bool mdnsBrowsing() { return refreshPending || !queries.empty(); }
+
+void mdnsResultsToJson(JsonDocument &doc, const String &type) {
+  MdnsLock lock;
+  uint32_t now = millis();
+  expire(now);
+  doc["running"] = mdnsBrowsing();
+  if (lastRefreshMs)
+    doc["ageMs"] = now - lastRefreshMs;
+  JsonArray running = doc["querying"].to<JsonArray>();
+  for (auto &q : queries)
+    running.add(q.type);
+  JsonArray types = doc["types"].to<JsonArray>();
+  for (auto &t : discoveredTypes)
+    types.add(t);
+
+  JsonArray arr = doc["results"].to<JsonArray>();
+  String want = type.length() ? normaliseType(type) : String("");
+  if (want.length() && want.indexOf('.') < 0)
+    want += "._tcp";
+  for (auto &e : cache) {
+    if (want.length() && !e.type.equalsIgnoreCase(want))
+      continue;
+    JsonObject o = arr.add<JsonObject>();
+    o["instance"] = e.instance;
+    o["type"] = e.type;
+    o["hostname"] = e.hostname;
+    o["ip"] = e.ip == IPAddress() ? String("Unknown") : e.ip.toString();
+    o["port"] = e.port;
+    o["ttl"] = (e.expiresMs - now) / 1000;
+    if (!e.txt.empty()) {
+      JsonObject txt = o["txt"].to<JsonObject>();
+      for (auto &t : e.txt)
+        txt[t.key] = t.value;
+    }
+  }
+  doc["count"] = arr.size();
+}
+
+void mdnsBegin() { mdnsMutex = xSemaphoreCreateRecursiveMutex(); }
+
+void mdnsScanLoop() {
+  MdnsLock lock;
+  uint32_t now = millis();
+
+  if (refreshPending) {
+    refreshPending = false;
+    refreshStartMs = now;
+    for (auto &t : pendingTypes) {
+      char srv[64];
+      char proto[16];
+      if (!splitType(t, srv, sizeof(srv), proto, sizeof(proto)))
+        continue;
+      MdnsQuery q;
+      q.type = t;
+      q.search = mdns_query_async_new(NULL, srv, proto, MDNS_TYPE_PTR,
+                                      mdnsQueryMs, mdnsQueryResults, NULL);
+      if (q.search)
+        queries.push_back(q);
+      else
+        logFmt(LOGLV_WARN, "mDNS", "Query for %s.%s failed to start", srv,
+               proto);
+    }
+    logFmt(LOGLV_DEBUG, "mDNS", "Browsing %u service types (%ums)",
+           (unsigned)queries.size(), (unsigned)mdnsQueryMs);
+    return;
+  }
+
+  if (queries.empty())
+    return;
+
+  for (size_t i = 0; i < queries.size();) {
+    mdns_result_t *results = nullptr;
+    if (!mdns_query_async_get_results(queries[i].search, 0, &results) &&
+        now - refreshStartMs <= mdnsQueryMs + 1000) {
+      i++;
+      continue;
+    }
+    mdns_query_async_delete(queries[i].search);
+    for (mdns_result_t *r = results; r; r = r->next)
+      mergeResult(queries[i].type, r, now);
+    if (results)
+      mdns_query_results_free(results);
+    queries.erase(queries.begin() + i);
+  }
+
+  if (queries.empty()) {
+    lastRefreshMs = now;
+    expire(now);
+    logFmt(LOGLV_INFO, "mDNS",
+           "Refresh complete. %u services cached, %u types advertised.",
+           (unsigned)cache.size(), (unsigned)discoveredTypes.size());
+  }
+}
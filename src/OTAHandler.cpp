@@ -1,5 +1,6 @@
 #include "OTAHandler.h"
 #include "AppConfig.h"
+#include "LogPipeline.h"
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <HTTPUpdate.h>
@@ -42,8 +43,9 @@ void OTAHandler::checkUpdate() {
   logAll("OTA: Free heap = " + String(freeHeap) + " bytes");
 
   if (freeHeap < MIN_HEAP_FOR_TLS) {
-    logAll("OTA: Not enough heap for TLS (" + String(freeHeap) + " < " +
-           String(MIN_HEAP_FOR_TLS) + "). Skipping.");
+    logAt(LOGLV_WARN, "OTA",
+          "Not enough heap for TLS (" + String(freeHeap) + " < " +
+              String(MIN_HEAP_FOR_TLS) + "). Skipping.");
     return;
   }
 
@@ -107,10 +109,12 @@ void OTAHandler::checkUpdate() {
       }
 
     } else {
-      logAll("OTA: Failed to parse manifest: " + String(error.c_str()));
+      logAt(LOGLV_ERROR, "OTA",
+            "Failed to parse manifest: " + String(error.c_str()));
     }
   } else {
-    logAll("OTA: Update check failed, HTTP error: " + String(httpCode));
+    logAt(LOGLV_ERROR, "OTA",
+          "Update check failed, HTTP error: " + String(httpCode));
   }
 
   http.end();
@@ -132,7 +136,8 @@ void OTAHandler::performUpdate(const String &url) {
 
   switch (ret) {
   case HTTP_UPDATE_FAILED:
-    logAll("FW Update Failed: " + httpUpdate.getLastErrorString());
+    logAt(LOGLV_ERROR, "OTA",
+          "FW update failed: " + httpUpdate.getLastErrorString());
     break;
   case HTTP_UPDATE_NO_UPDATES:
     logAll("No FW updates");
@@ -156,7 +161,8 @@ void OTAHandler::performFSUpdate(const String &url) {
 
   switch (ret) {
   case HTTP_UPDATE_FAILED:
-    logAll("FS Update Failed: " + httpUpdate.getLastErrorString());
+    logAt(LOGLV_ERROR, "OTA",
+          "FS update failed: " + httpUpdate.getLastErrorString());
     break;
   case HTTP_UPDATE_NO_UPDATES:
     logAll("No FS updates");
@@ -0,0 +1,364 @@
+#include "PJLink.h"
+#include "AppConfig.h"
+#include "RecursiveLock.h"
+#include <AsyncTCP.h>
+#include <MD5Builder.h>
+#include <WiFi.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+static const uint16_t pjlinkPort = 4352;
+static const uint32_t pjlConnectMs = 3000; // connect and banner
+static const uint32_t pjlReplyMs = 3000;
+static const uint32_t pjlIdleMs = 20000; // projectors drop us at 30 s
+static const size_t pjlMaxPending = 32;
+static const size_t pjlHistory = 32; // finished requests kept for status
+
+static const char *const pjlIdleClose = "Idle";
+
+struct PjlSession {
+  enum Phase : uint8_t { CONNECTING, BANNER, READY, WAITING, CLOSING };
+
+  String host;
+  IPAddress ip;
+  bool resolved = false; // ip is valid; names wait for pjlinkLoop()
+  String pass;
+  AsyncClient *client = nullptr;
+  Phase phase = CONNECTING;
+  String digest; // MD5(salt + password) for this connection
+  bool authSent = false;
+  String rx;
+  std::deque<uint32_t> queue;
+  uint32_t current = 0;
+  uint32_t deadlineMs = 0;
+  uint32_t lastUsedMs = 0;
+  uint16_t sent = 0;  // commands sent on this connection
+  const char *closeReason = nullptr;
+  bool closeIssued = false; // close() called on client
+};
+
+static std::vector<std::unique_ptr<PjlSession>> sessions;
+static std::deque<PjlRequest> requests; // oldest first
+static uint32_t nextReqId = 1;
+static SemaphoreHandle_t pjlMutex = nullptr;
+
+// AsyncClient callbacks run on the async_tcp task, pjlinkLoop() on the
+// Arduino loop.
+struct PjlLock : RecursiveLock {
+  PjlLock() : RecursiveLock(pjlMutex) {}
+};
+
+static PjlRequest *findReq(uint32_t id) {
+  for (auto it = requests.rbegin(); it != requests.rend(); ++it)
+    if (it->id == id)
+      return &*it;
+  return nullptr;
+}
+
+static void finishReq(uint32_t id, PjlState st, const String &resp) {
+  PjlRequest *r = findReq(id);
+  if (!r)
+    return;
+  r->state = st;
+  r->response = resp;
+  r->doneMs = millis();
+}
+
+static void failAll(PjlSession &s, const String &why) {
+  if (s.current)
+    finishReq(s.current, PJL_FAILED, why);
+  s.current = 0;
+  for (uint32_t id : s.queue)
+    finishReq(id, PJL_FAILED, why);
+  s.queue.clear();
+}
+
+static void sendNext(PjlSession &s) {
+  if (s.phase != PjlSession::READY || s.queue.empty() || !s.client)
+    return;
+  s.current = s.queue.front();
+  s.queue.pop_front();
+  PjlRequest *r = findReq(s.current);
+  if (!r) {
+    s.current = 0;
+    return sendNext(s);
+  }
+  r->state = PJL_RUNNING;
+  r->sentMs = millis();
+  r->reusedSession = s.sent > 0;
+  // The digest authenticates the connection, so only the first command
+  // carries it.
+  String line = (s.digest.length() && !s.authSent ? s.digest : String("")) +
+                r->cmd + "\r";
+  s.authSent = true;
+  s.sent++;
+  s.client->write(line.c_str(), line.length());
+  s.phase = PjlSession::WAITING;
+  s.deadlineMs = millis() + pjlReplyMs;
+}
+
+// Loop task only: close() runs onDisconnect synchronously, which deletes
+// the client, so it must not be called from the client's own callbacks.
+static void closeSession(PjlSession &s, const char *why) {
+  if (!s.client || s.closeIssued)
+    return;
+  s.closeReason = why;
+  s.phase = PjlSession::CLOSING;
+  s.closeIssued = true;
+  s.client->close(true);
+}
+
+// From onData: pjlinkLoop() does the close.
+static void endSession(PjlSession &s) {
+  s.closeReason = nullptr;
+  s.phase = PjlSession::CLOSING;
+}
+
+static void onLine(PjlSession &s, const String &line) {
+  if (s.phase == PjlSession::BANNER) {
+    if (line.startsWith("PJLINK 0")) {
+      s.digest = "";
+    } else if (line.startsWith("PJLINK 1 ")) {
+      if (!s.pass.length()) {
+        failAll(s, "ERROR: Password required");
+        return endSession(s);
+      }
+      String salt = line.substring(9);
+      salt.trim();
+      MD5Builder md5;
+      md5.begin();
+      md5.add(salt);
+      md5.add(s.pass);
+      md5.calculate();
+      s.digest = md5.toString();
+    } else {
+      failAll(s, "ERROR: Invalid banner: " + line);
+      return endSession(s);
+    }
+    s.phase = PjlSession::READY;
+    s.lastUsedMs = millis();
+    return sendNext(s);
+  }
+
+  if (s.phase != PjlSession::WAITING)
+    return; // unsolicited
+  if (line.startsWith("PJLINK ERRA")) {
+    failAll(s, "ERROR: Auth failed");
+    return endSession(s);
+  }
+  finishReq(s.current, PJL_DONE, line);
+  s.current = 0;
+  s.phase = PjlSession::READY;
+  s.lastUsedMs = millis();
+  sendNext(s);
+}
+
+static void openSession(PjlSession &s);
+
+static void onDisconnect(PjlSession &s, AsyncClient *c) {
+  bool hadCommands = s.sent > 0;
+  const char *why = s.closeReason;
+  PjlSession::Phase phase = s.phase;
+  s.client = nullptr;
+  s.closeReason = nullptr;
+  delete c;
+
+  if (s.current) {
+    finishReq(s.current, PJL_FAILED,
+              String("ERROR: ") + (why ? why : "Connection closed"));
+    s.current = 0;
+  }
+  if (s.queue.empty())
+    return;
+  // Some projectors hang up after every reply; open a fresh session for the
+  // rest of the queue as long as the last one got somewhere. Requests that
+  // arrived while an idle session was closing also get a new one.
+  if ((hadCommands && !why) || why == pjlIdleClose)
+    return openSession(s);
+  failAll(s, String("ERROR: ") +
+                 (why ? why
+                      : phase == PjlSession::CONNECTING ? "Connect failed"
+                                                        : "Connection closed"));
+}
+
+static void openSession(PjlSession &s) {
+  s.phase = PjlSession::CONNECTING;
+  s.digest = "";
+  s.authSent = false;
+  s.rx = "";
+  s.sent = 0;
+  s.closeReason = nullptr;
+  s.closeIssued = false;
+  s.deadlineMs = millis() + pjlConnectMs;
+  AsyncClient *c = new AsyncClient();
+  s.client = c;
+  PjlSession *sp = &s;
+  c->onConnect(
+      [](void *arg, AsyncClient *) {
+        PjlLock lock;
+        PjlSession &s = *static_cast<PjlSession *>(arg);
+        s.phase = PjlSession::BANNER;
+      },
+      sp);
+  c->onData(
+      [](void *arg, AsyncClient *, void *data, size_t len) {
+        PjlLock lock;
+        PjlSession &s = *static_cast<PjlSession *>(arg);
+        const char *p = (const char *)data;
+        for (size_t i = 0; i < len && s.phase != PjlSession::CLOSING; i++) {
+          if (p[i] == '\r') {
+            String line = s.rx;
+            s.rx = "";
+            onLine(s, line);
+          } else if (p[i] != '\n' && s.rx.length() < 256) {
+            s.rx += p[i];
+          }
+        }
+      },
+      sp);
+  c->onDisconnect(
+      [](void *arg, AsyncClient *c) {
+        PjlLock lock;
+        onDisconnect(*static_cast<PjlSession *>(arg), c);
+      },
+      sp);
+  if (!c->connect(s.ip, pjlinkPort)) {
+    s.client = nullptr;
+    delete c;
+    failAll(s, "ERROR: Connect failed");
+  }
+}
+
+static size_t pendingCount() {
+  size_t pending = 0;
+  for (auto &r : requests)
+    if (r.state == PJL_QUEUED || r.state == PJL_RUNNING)
+      pending++;
+  return pending;
+}
+
+static uint32_t submitLocked(const String &host, const String &password,
+                             const String &cmd) {
+  size_t pending = pendingCount();
+  if (pending >= pjlMaxPending)
+    return 0;
+
+  PjlRequest r;
+  r.id = nextReqId++;
+  r.host = host;
+  r.cmd = cmd;
+  r.queuedMs = millis();
+  requests.push_back(r);
+  while (requests.size() > pjlHistory + pending + 1 &&
+         requests.front().state >= PJL_DONE)
+    requests.pop_front();
+
+  PjlSession *s = nullptr;
+  for (auto &sp : sessions)
+    if (sp->host == host && sp->pass == password)
+      s = sp.get();
+  if (!s) {
+    sessions.emplace_back(new PjlSession());
+    s = sessions.back().get();
+    s->host = host;
+    s->resolved = s->ip.fromString(host);
+    s->pass = password;
+  }
+  s->queue.push_back(r.id);
+  if (!s->resolved)
+    return r.id;
+  if (!s->client)
+    openSession(*s);
+  else
+    sendNext(*s);
+  return r.id;
+}
+
+uint32_t pjlinkSubmit(const String &host, const String &password,
+                      const String &cmd) {
+  PjlLock lock;
+  return submitLocked(host, password, cmd);
+}
+
+bool pjlinkSubmitAll(const String &host, const String &password,
+                     const std::vector<String> &cmds,
+                     std::vector<uint32_t> &ids) {
+  PjlLock lock;
+  if (pendingCount() + cmds.size() > pjlMaxPending)
+    return false;
+  for (auto &cmd : cmds)
+    ids.push_back(submitLocked(host, password, cmd));
+  return true;
+}
+
+bool pjlinkRequest(uint32_t id, PjlRequest &out) {
+  PjlLock lock;
+  if (requests.empty())
+    return false;
+  PjlRequest *r = id ? findReq(id) : &requests.back();
+  if (!r)
+    return false;
+  out = *r;
+  return true;
+}
+
+uint8_t pjlinkSessionCount() {
+  PjlLock lock;
+  uint8_t n = 0;
+  for (auto &s : sessions)
+    if (s->client)
+      n++;
+  return n;
+}
+
+void pjlinkBegin() { pjlMutex = xSemaphoreCreateRecursiveMutex(); }
+
+void pjlinkLoop() {
+  // A DNS lookup blocks, so it runs without the lock; only this task
+  // erases sessions, so the pointer stays valid meanwhile.
+  PjlSession *unresolved = nullptr;
+  String host;
+  {
+    PjlLock lock;
+    for (auto &sp : sessions) {
+      if (!sp->resolved) {
+        unresolved = sp.get();
+        host = sp->host;
+        break;
+      }
+    }
+  }
+  IPAddress addr;
+  bool found = unresolved && WiFi.hostByName(host.c_str(), addr) == 1;
+
+  PjlLock lock;
+  if (unresolved) {
+    unresolved->resolved = true;
+    if (found) {
+      unresolved->ip = addr;
+      openSession(*unresolved);
+    } else {
+      failAll(*unresolved, "ERROR: Cannot resolve " + host);
+    }
+  }
+  uint32_t now = millis();
+  for (size_t i = 0; i < sessions.size();) {
+    PjlSession &s = *sessions[i];
+    if (s.client) {
+      if (s.phase == PjlSession::CLOSING) {
+        closeSession(s, s.closeReason);
+      } else if (s.phase == PjlSession::READY) {
+        if (s.queue.empty() && now - s.lastUsedMs >= pjlIdleMs)
+          closeSession(s, pjlIdleClose);
+      } else if ((int32_t)(now - s.deadlineMs) >= 0) {
+        closeSession(s, "Timeout");
+      }
+    }
+    if (!s.client && s.queue.empty() && !s.current) {
+      sessions.erase(sessions.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
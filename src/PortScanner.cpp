@@ -1,57 +1,265 @@
 #include "PortScanner.h"
-#include <WiFiClient.h>
+#include "AVDiscovery.h"
+#include "AppConfig.h"
+#include "RecursiveLock.h"
+#include <algorithm>
+#include <errno.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
 
 PortScanner portScanner;
+static SemaphoreHandle_t psMutex = nullptr;
 
-void PortScanner::begin() { _scanning = false; }
+static const uint16_t psDefaultWindow = 8;
+static const uint16_t psMaxWindow = 32;
+static const uint16_t psDefaultRate = 200; // connects per second
+static const uint16_t psMaxRate = 1000;
+static const uint16_t psDefaultTimeoutMs = 400;
 
-void PortScanner::startScan(const String &ip, const std::vector<int> &ports) {
-  _targetIp = ip;
-  _portsToScan = ports;
+// startScan() and getResultsJson() run on the async_tcp task, loop() on the
+// Arduino loop. Only loop() touches the sockets.
+struct PsLock : RecursiveLock {
+  PsLock() : RecursiveLock(psMutex) {}
+};
+
+void PortScanner::begin() {
+  psMutex = xSemaphoreCreateRecursiveMutex();
+  _scanning = false;
+  _pending = false;
+}
+
+bool PortScanner::isScanning() {
+  PsLock lock;
+  return _scanning || _pending;
+}
+
+bool PortScanner::parsePorts(const String &spec, std::vector<PortRange> &out,
+                             String &err) {
+  out.clear();
+  int pos = 0;
+  while (pos <= (int)spec.length()) {
+    int comma = spec.indexOf(',', pos);
+    if (comma < 0)
+      comma = spec.length();
+    String tok = spec.substring(pos, comma);
+    tok.trim();
+    pos = comma + 1;
+    if (!tok.length())
+      continue;
+    int dash = tok.indexOf('-');
+    String a = dash < 0 ? tok : tok.substring(0, dash);
+    String b = dash < 0 ? tok : tok.substring(dash + 1);
+    a.trim();
+    b.trim();
+    long from = a.toInt();
+    long to = b.toInt();
+    if (from < 1 || to > 65535 || from > to || String(from) != a ||
+        String(to) != b) {
+      err = "bad port range: " + tok;
+      return false;
+    }
+    out.push_back({(uint16_t)from, (uint16_t)to});
+  }
+  if (out.empty()) {
+    err = "no ports";
+    return false;
+  }
+  std::sort(out.begin(), out.end(),
+            [](const PortRange &x, const PortRange &y) { return x.from < y.from; });
+  std::vector<PortRange> merged;
+  for (auto &r : out) {
+    if (!merged.empty() && r.from <= (uint32_t)merged.back().to + 1)
+      merged.back().to = std::max(merged.back().to, r.to);
+    else
+      merged.push_back(r);
+  }
+  out.swap(merged);
+  return true;
+}
+
+bool PortScanner::startScan(const String &host,
+                            const std::vector<PortRange> &ports,
+                            uint32_t window, uint32_t rate,
+                            uint32_t timeoutMs) {
+  PsLock lock;
+  if (_scanning || _pending)
+    return false;
+  _request = {host, ports, window, rate, timeoutMs};
+  _pending = true;
+  return true;
+}
+
+// Loop task, with the lock held.
+void PortScanner::beginScan(const IPAddress &ip) {
+  _pending = false;
+  _error = "";
+  _target = ip;
+  _ranges.swap(_request.ranges);
+  _request.ranges.clear();
+  _rangeIdx = 0;
+  _nextPort = _ranges.empty() ? 0 : _ranges[0].from;
+  _total = 0;
+  for (auto &r : _ranges)
+    _total += (uint32_t)r.to - r.from + 1;
+  _scanned = _closed = _filtered = 0;
   _openPorts.clear();
-  _currentIndex = 0;
+  uint32_t window = _request.window, rate = _request.rate;
+  uint32_t timeoutMs = _request.timeoutMs;
+  _window = constrain(window ? window : psDefaultWindow, 1, psMaxWindow);
+  _rate = constrain(rate ? rate : psDefaultRate, 1, psMaxRate);
+  _timeoutMs = constrain(timeoutMs ? timeoutMs : psDefaultTimeoutMs, 50, 5000);
+  _tokens = _window; // allow an initial burst of one window
+  _startMs = _lastRefillMs = millis();
+  _endMs = 0;
   _scanning = true;
-  _lastScanTime = 0;
 }
 
+void PortScanner::advancePort() {
+  if (_nextPort >= _ranges[_rangeIdx].to) {
+    if (++_rangeIdx < _ranges.size())
+      _nextPort = _ranges[_rangeIdx].from;
+  } else {
+    _nextPort++;
+  }
+}
+
+void PortScanner::finish() {
+  _scanning = false;
+  _endMs = millis();
+  JsonDocument done;
+  done["type"] = "portscan_done";
+  done["host"] = _target.toString();
+  done["scanned"] = _scanned;
+  done["open"] = _openPorts.size();
+  done["elapsedMs"] = _endMs - _startMs;
+  String out;
+  serializeJson(done, out);
+  wsTextAll(wsDisc, out);
+}
+
+// Runs on every main loop pass and never blocks: connects are
+// non-blocking and polled with a zero-timeout select().
 void PortScanner::loop() {
+  // The only blocking step is a DNS lookup for a new request, done without
+  // the lock. startScan() refuses while _pending, so _request holds still.
+  bool pending;
+  {
+    PsLock lock;
+    pending = _pending;
+  }
+  IPAddress ip;
+  bool resolved = pending && (ip.fromString(_request.host) ||
+                              WiFi.hostByName(_request.host.c_str(), ip) == 1);
+
+  PsLock lock;
+  if (pending) {
+    if (resolved) {
+      beginScan(ip);
+    } else {
+      _pending = false;
+      _error = "Unknown host: " + _request.host;
+    }
+  }
   if (!_scanning)
     return;
 
-  // Small delay to yield time to other tasks
-  if (millis() - _lastScanTime < 20)
-    return;
-  _lastScanTime = millis();
+  uint32_t now = millis();
+  _tokens = std::min<float>(_window, _tokens + (now - _lastRefillMs) *
+                                                   _rate / 1000.0f);
+  _lastRefillMs = now;
 
-  if (_currentIndex >= _portsToScan.size()) {
-    _scanning = false;
-    return;
+  while (_inflight.size() < _window && _tokens >= 1 &&
+         _rangeIdx < _ranges.size()) {
+    uint16_t port = _nextPort;
+    int fd = discConnect(_target, port);
+    if (fd == -1)
+      break; // out of sockets, retry this port on the next pass
+    advancePort();
+    _tokens -= 1;
+    if (fd < 0) {
+      _scanned++;
+      _filtered++;
+      continue;
+    }
+    _inflight.push_back({fd, port, now});
   }
 
-  int port = _portsToScan[_currentIndex];
+  if (!_inflight.empty()) {
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    int maxFd = -1;
+    for (auto &p : _inflight) {
+      FD_SET(p.fd, &wfds);
+      maxFd = std::max(maxFd, p.fd);
+    }
+    struct timeval tv = {0, 0};
+    int n = select(maxFd + 1, nullptr, &wfds, nullptr, &tv);
 
-  WiFiClient c;
-  // We use blocking connect, but it is limited to one per loop iteration
-  // The timeout is 200ms, which is safe for the main loop wdt (usually 5s)
-  if (c.connect(_targetIp.c_str(), port, 200)) {
-    _openPorts.push_back(port);
-    c.stop();
-  } else {
-    c.stop();
+    for (size_t i = 0; i < _inflight.size();) {
+      Probe &p = _inflight[i];
+      bool done = true;
+      if (n > 0 && FD_ISSET(p.fd, &wfds)) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err == 0) {
+          _openPorts.push_back(p.port);
+          JsonDocument ev;
+          ev["type"] = "port";
+          ev["host"] = _target.toString();
+          ev["port"] = p.port;
+          String out;
+          serializeJson(ev, out);
+          wsTextAll(wsDisc, out);
+        } else if (err == ECONNREFUSED) {
+          _closed++;
+        } else {
+          _filtered++;
+        }
+      } else if (now - p.startMs >= _timeoutMs) {
+        _filtered++;
+      } else {
+        done = false;
+      }
+      if (done) {
+        _scanned++;
+        discClose(p.fd);
+        _inflight[i] = _inflight.back();
+        _inflight.pop_back();
+      } else {
+        i++;
+      }
+    }
   }
 
-  _currentIndex++;
+  if (_inflight.empty() && _rangeIdx >= _ranges.size())
+    finish();
 }
 
 String PortScanner::getResultsJson() {
+  PsLock lock;
   JsonDocument doc;
-  doc["running"] = _scanning;
-  doc["progress"] = _scanning
-                        ? (_currentIndex * 100 /
-                           (_portsToScan.size() ? _portsToScan.size() : 1))
-                        : 100;
+  uint32_t elapsed = (_scanning || !_endMs ? millis() : _endMs) - _startMs;
+  doc["running"] = _scanning || _pending;
+  if (_error.length())
+    doc["error"] = _error;
+  doc["host"] = _target.toString();
+  doc["progress"] = _pending    ? 0
+                    : _scanning ? (_scanned * 100 / (_total ? _total : 1))
+                                : 100;
+  doc["scanned"] = _scanned;
+  doc["total"] = _total;
+  doc["closed"] = _closed;
+  doc["filtered"] = _filtered;
+  doc["elapsedMs"] = elapsed;
+  doc["portsPerSec"] = elapsed ? _scanned * 1000.0f / elapsed : 0;
+  doc["window"] = _window;
+  doc["rate"] = _rate;
+  doc["timeoutMs"] = _timeoutMs;
   JsonArray open = doc["open"].to<JsonArray>();
-  for (int p : _openPorts)
+  std::vector<uint16_t> sorted = _openPorts;
+  std::sort(sorted.begin(), sorted.end());
+  for (uint16_t p : sorted)
     open.add(p);
   String out;
   serializeJson(doc, out);
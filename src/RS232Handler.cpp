@@ -1,6 +1,7 @@
 #include "RS232Handler.h"
 #include "Utils.h"
 #include "WebAPI.h" // Need this for extern wsRS232
+#include "WsStream.h"
 #include <ArduinoJson.h>
 
 
@@ -45,7 +46,125 @@ static const Profile profiles[] = {
     {"Kramer", 115200, "#POWER-MODE 1\r", "#POWER-MODE 0\r", "#POWER-MODE?\r"}};
 static int currentProfile = 0;
 
+// RX coalescing: received bytes are held and sent to wsRS232 as one frame
+// when the line goes idle for rxGapTenths/10 character times, the frame
+// reaches rxMaxBytes, or its first byte is rxMaxAgeMs old.
+static const uint16_t rxBufSize = 1024;
+static uint8_t rxFrame[rxBufSize];
+static uint16_t rxFrameLen = 0;
+static uint32_t rxFrameStartMs = 0;
+static uint32_t rxLastByteUs = 0;
+static uint16_t rxGapTenths = 15;
+static uint16_t rxMaxBytes = 256;
+static uint16_t rxMaxAgeMs = 50;
+
+// Frame counters, folded into a rate once a second.
+static uint32_t rxFrames = 0;
+static uint32_t rxFrameBytes = 0;
+static uint32_t rxWindowStartMs = 0;
+static uint32_t rxWindowFrames = 0;
+static uint32_t rxWindowBytes = 0;
+static float rxFps = 0;
+static float rxBytesPerFrame = 0;
+
+// RX, the telnet bridge and the timers above run on a dedicated pump task
+// that sleeps until the UART event task reports data (onReceive) or a timer
+// is due. rs232Mutex serialises it against WebSocket actions and macros.
+static TaskHandle_t rs232PumpHandle = nullptr;
+static SemaphoreHandle_t rs232Mutex = nullptr;
+static uint16_t rxRingSize = 4096;
+
+// UART error counters, bumped from the UART event task.
+static volatile uint32_t uartOverruns = 0;   // hardware FIFO overflow
+static volatile uint32_t uartBufferFull = 0; // RX ring full
+static volatile uint32_t uartFrameErrors = 0;
+static volatile uint32_t uartParityErrors = 0;
+static volatile uint32_t uartBreaks = 0;
+
+struct Rs232Lock {
+  Rs232Lock() {
+    if (rs232Mutex)
+      xSemaphoreTakeRecursive(rs232Mutex, portMAX_DELAY);
+  }
+  ~Rs232Lock() {
+    if (rs232Mutex)
+      xSemaphoreGiveRecursive(rs232Mutex);
+  }
+};
+
+// Telnet and WebSocket output is queued under rs232Mutex and sent by the
+// pump task after it lets go of the lock, so a stalled telnet peer (its
+// write() blocks) never holds up WebSocket actions or macros waiting on
+// the UART state. Only the pump touches rs232TelnetClient's socket.
+struct Rs232Out {
+  enum Kind : uint8_t { TEXT, RX, TX } kind;
+  String text;
+  std::vector<uint8_t> data;
+  IPAddress ip;
+  uint16_t port;
+};
+static const size_t rs232OutboxMax = 64;     // messages
+static const size_t rs232TelnetOutMax = 4096; // bytes
+static std::vector<Rs232Out> rs232Outbox;
+static std::vector<uint8_t> rs232TelnetOut;
+
+static void rs232WakePump() {
+  if (rs232PumpHandle && xTaskGetCurrentTaskHandle() != rs232PumpHandle)
+    xTaskNotifyGive(rs232PumpHandle);
+}
+
+// All three are called with rs232Mutex held.
+static void rs232QueueText(const String &s) {
+  if (rs232Outbox.size() >= rs232OutboxMax)
+    return;
+  rs232Outbox.push_back({Rs232Out::TEXT, s, {}, IPAddress(), 0});
+  rs232WakePump();
+}
+
+static void rs232QueueData(Rs232Out::Kind kind, const uint8_t *data,
+                           size_t len, const IPAddress &ip = IPAddress(),
+                           uint16_t port = 0) {
+  if (rs232Outbox.size() >= rs232OutboxMax)
+    return;
+  rs232Outbox.push_back(
+      {kind, String(), std::vector<uint8_t>(data, data + len), ip, port});
+  rs232WakePump();
+}
+
+static void rs232QueueTelnet(const uint8_t *data, size_t len) {
+  if (!rs232TelnetConnected)
+    return;
+  len = min(len, rs232TelnetOutMax - rs232TelnetOut.size());
+  rs232TelnetOut.insert(rs232TelnetOut.end(), data, data + len);
+  rs232WakePump();
+}
+
+// Pump task, without the lock.
+static void rs232SendOut() {
+  std::vector<Rs232Out> out;
+  std::vector<uint8_t> telnet;
+  {
+    Rs232Lock lock;
+    out.swap(rs232Outbox);
+    telnet.swap(rs232TelnetOut);
+  }
+  if (telnet.size() && rs232TelnetConnected && rs232TelnetClient.connected())
+    rs232TelnetClient.write(telnet.data(), telnet.size());
+  for (auto &m : out) {
+    if (m.kind == Rs232Out::TEXT) {
+      wsTextAll(wsRS232, m.text);
+      continue;
+    }
+    JsonDocument doc;
+    doc["type"] = m.kind == Rs232Out::RX ? "rx" : "tx";
+    wsStreamData(wsRS232, WS_CH_RS232,
+                 m.kind == Rs232Out::RX ? WS_DIR_RX : WS_DIR_TX, m.data.data(),
+                 m.data.size(), doc, m.ip, m.port);
+  }
+}
+
 void rs232SendStatus() {
+  Rs232Lock lock;
   JsonDocument doc;
   doc["type"] = "status";
   doc["baud"] = currentBaud;
@@ -57,39 +176,77 @@ void rs232SendStatus() {
   doc["telnet"] = rs232TelnetConnected;
   if (rs232TelnetConnected)
     doc["telnetIP"] = rs232TelnetClient.remoteIP().toString();
+  JsonObject co = doc["coalesce"].to<JsonObject>();
+  co["gap"] = rxGapTenths / 10.0f;
+  co["max"] = rxMaxBytes;
+  co["age"] = rxMaxAgeMs;
+  doc["rxFrames"] = rxFrames;
+  doc["rxBytes"] = rxFrameBytes;
+  doc["rxFps"] = rxFps;
+  doc["rxBytesPerFrame"] = rxBytesPerFrame;
+  doc["rxRing"] = rxRingSize;
+  JsonObject err = doc["errors"].to<JsonObject>();
+  err["overrun"] = uartOverruns;
+  err["bufferFull"] = uartBufferFull;
+  err["framing"] = uartFrameErrors;
+  err["parity"] = uartParityErrors;
+  err["break"] = uartBreaks;
   String out;
   serializeJson(doc, out);
-  wsRS232.textAll(out);
+  rs232QueueText(out);
 }
 
 void rs232BroadcastSys(const String &msg) {
+  Rs232Lock lock;
   JsonDocument doc;
   doc["type"] = "sys";
   doc["msg"] = msg;
   String out;
   serializeJson(doc, out);
-  wsRS232.textAll(out);
+  rs232QueueText(out);
+}
+
+static void rs232FlushRx() {
+  if (!rxFrameLen)
+    return;
+  rs232QueueData(Rs232Out::RX, rxFrame, rxFrameLen);
+  rxFrames++;
+  rxFrameBytes += rxFrameLen;
+  rxWindowFrames++;
+  rxWindowBytes += rxFrameLen;
+  rxFrameLen = 0;
+}
+
+void rs232SetCoalesce(float gapChars, uint16_t maxBytes, uint16_t maxAgeMs) {
+  Rs232Lock lock;
+  rs232FlushRx();
+  rxGapTenths = constrain((int)(gapChars * 10 + 0.5f), 0, 1000);
+  rxMaxBytes = constrain(maxBytes, (uint16_t)1, rxBufSize);
+  rxMaxAgeMs = maxAgeMs;
+  rs232SendStatus();
 }
 
 void rs232SetBaud(uint32_t baud) {
+  Rs232Lock lock;
   if (baud == currentBaud)
     return;
+  rs232FlushRx();
   currentBaud = baud;
-  Serial2.end();
-  delay(10);
-  Serial2.begin(currentBaud);
-  // Re-configure pins if needed, but usually .begin handles it for default pins
+  // Keeps the UART driver and its event task; end()/begin() would drop both.
+  Serial2.updateBaudRate(currentBaud);
   rs232SendStatus();
   rs232BroadcastSys("Baud changed to " + String(currentBaud));
 }
 
 void rs232SetInvert(bool invert) {
+  Rs232Lock lock;
   invertPolarity = invert;
   rs232SendStatus();
   rs232BroadcastSys(String("Invert Polarity: ") + (invert ? "ON" : "OFF"));
 }
 
 void rs232SetProfile(int idx) {
+  Rs232Lock lock;
   if (idx >= 0 && idx < 3) {
     currentProfile = idx;
     rs232SetBaud(profiles[idx].baud);
@@ -117,6 +274,7 @@ void rs232TriggerPreset(int n) {
 }
 
 void rs232StartLoopback() {
+  Rs232Lock lock;
   loopbackRunning = true;
   loopbackStart = millis();
   loopbackBuffer = "";
@@ -126,6 +284,7 @@ void rs232StartLoopback() {
 }
 
 void rs232StartAutoBaud() {
+  Rs232Lock lock;
   autoDetectRunning = true;
   autoDetectIndex = baudOptionsCount - 1; // start highest
   autoDetectGoodBytes = 0;
@@ -137,6 +296,7 @@ void rs232StartAutoBaud() {
 }
 
 void rs232StopAutoBaud() {
+  Rs232Lock lock;
   autoDetectRunning = false;
   rs232BroadcastSys("Auto-baud stopped");
   rs232SendStatus();
@@ -147,55 +307,110 @@ void rs232Send(const String &payload, bool hex, const String &suffix) {
   if (hex) {
     parseHexBytes(payload, data);
   } else {
-    String full = payload;
-    if (suffix == "\\r")
-      full += "\r";
-    else if (suffix == "\\n")
-      full += "\n";
-    else if (suffix == "\\r\\n")
-      full += "\r\n";
-    for (size_t i = 0; i < full.length(); i++)
-      data.push_back((uint8_t)full[i]);
+    String full = payload + unescapeCtl(suffix);
+    data.assign((const uint8_t *)full.c_str(),
+                (const uint8_t *)full.c_str() + full.length());
   }
+  rs232Write(data.data(), data.size());
+}
 
+void rs232Write(const uint8_t *data, size_t len) {
+  Rs232Lock lock;
   if (invertPolarity) {
-    for (size_t i = 0; i < data.size(); i++)
-      data[i] = ~data[i];
+    uint8_t buf[64];
+    for (size_t off = 0; off < len; off += sizeof(buf)) {
+      size_t n = min(len - off, sizeof(buf));
+      for (size_t i = 0; i < n; i++)
+        buf[i] = ~data[off + i];
+      Serial2.write(buf, n);
+    }
+  } else {
+    Serial2.write(data, len);
   }
 
-  Serial2.write(data.data(), data.size());
+  // For telnet, we usually send the "ASCII" version (un-inverted) as it's a
+  // network terminal But if we want it to act EXACTLY like the port...
+  // Standard practice: Telnet is a "terminal view", so send the clean data
+  // (un-inverted). Users connecting via putty don't want inverted garbage.
+  rs232QueueTelnet(data, len);
+  rs232QueueData(Rs232Out::TX, data, len);
+}
 
-  // Restore for display (un-invert)
-  std::vector<uint8_t> displayData = data;
-  if (invertPolarity) {
-    for (size_t i = 0; i < displayData.size(); i++)
-      displayData[i] = ~displayData[i];
-  }
+static void rs232AttachUart() {
+  Serial2.onReceive([]() {
+    if (rs232PumpHandle)
+      xTaskNotifyGive(rs232PumpHandle);
+  });
+  Serial2.onReceiveError([](hardwareSerial_error_t e) {
+    if (e == UART_FIFO_OVF_ERROR)
+      uartOverruns++;
+    else if (e == UART_BUFFER_FULL_ERROR)
+      uartBufferFull++;
+    else if (e == UART_FRAME_ERROR)
+      uartFrameErrors++;
+    else if (e == UART_PARITY_ERROR)
+      uartParityErrors++;
+    else if (e == UART_BREAK_ERROR)
+      uartBreaks++;
+  });
+}
 
-  if (rs232TelnetConnected && rs232TelnetClient.connected()) {
-    // For telnet, we usually send the "ASCII" version (un-inverted) as it's a
-    // network terminal But if we want it to act EXACTLY like the port...
-    // Standard practice: Telnet is a "terminal view", so send the clean data
-    // (displayData). Users connecting via putty don't want inverted garbage.
-    rs232TelnetClient.write(displayData.data(), displayData.size());
-  }
+void rs232SetRxRing(uint16_t size) {
+  Rs232Lock lock;
+  size = constrain(size, (uint16_t)256, (uint16_t)16384);
+  if (size == rxRingSize)
+    return;
+  rs232FlushRx();
+  rxRingSize = size;
+  prefs.putUShort("rs232Ring", rxRingSize);
+  // The RX ring is sized when the driver is installed.
+  Serial2.end();
+  Serial2.setRxBufferSize(rxRingSize);
+  Serial2.begin(currentBaud);
+  rs232AttachUart();
+  rs232SendStatus();
+  rs232BroadcastSys("RX ring set to " + String(rxRingSize) + " bytes");
+}
 
-  JsonDocument doc;
-  doc["type"] = "tx";
-  doc["hex"] = bytesToHex(displayData.data(), displayData.size());
-  doc["ascii"] = bytesToAscii(displayData.data(), displayData.size());
-  String out;
-  serializeJson(doc, out);
-  wsRS232.textAll(out);
+static void rs232Poll();
+
+// How long the pump may sleep with no UART event: until the pending frame's
+// idle gap or age runs out, else the telnet/auto-baud polling interval.
+static uint32_t rs232PumpWaitMs() {
+  if (!rxFrameLen)
+    return 10;
+  uint32_t gapMs = (uint32_t)rxGapTenths * 1000 / currentBaud;
+  uint32_t idle = (micros() - rxLastByteUs) / 1000;
+  uint32_t age = millis() - rxFrameStartMs;
+  uint32_t wait = min(gapMs > idle ? gapMs - idle : 0,
+                      rxMaxAgeMs > age ? rxMaxAgeMs - age : 0);
+  return constrain(wait, (uint32_t)1, (uint32_t)10);
+}
+
+static void rs232PumpTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(rs232PumpWaitMs()));
+    {
+      Rs232Lock lock;
+      rs232Poll();
+    }
+    rs232SendOut();
+  }
 }
 
 void rs232Setup() {
+  rs232Mutex = xSemaphoreCreateRecursiveMutex();
+  rxRingSize = prefs.getUShort("rs232Ring", rxRingSize);
+  Serial2.setRxBufferSize(rxRingSize);
   Serial2.begin(currentBaud);
+  rs232AttachUart();
   rs232TelnetServer.begin();
   rs232TelnetServer.setNoDelay(true);
 
   wsRS232.onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client,
                      AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (wsStreamNegotiate(server, client, type, data, len))
+      return;
     if (type == WS_EVT_CONNECT) {
       rs232SendStatus();
     } else if (type == WS_EVT_DATA) {
@@ -219,14 +434,26 @@ void rs232Setup() {
           rs232StopAutoBaud();
       } else if (action == "loopback")
         rs232StartLoopback();
+      else if (action == "coalesce")
+        rs232SetCoalesce(doc["gap"] | rxGapTenths / 10.0f,
+                         doc["max"] | rxMaxBytes, doc["age"] | rxMaxAgeMs);
+      else if (action == "status")
+        rs232SendStatus();
+      else if (action == "rxring")
+        rs232SetRxRing(doc["size"] | rxRingSize);
       else if (action == "send") {
         rs232Send(doc["data"] | "", doc["mode"] == "hex", doc["suffix"] | "");
       }
     }
   });
+
+  xTaskCreatePinnedToCore(rs232PumpTask, "rs232", 6144, nullptr, 3,
+                          &rs232PumpHandle, 1);
 }
 
-void rs232Loop() {
+// One pump pass: telnet bridge, auto-baud, RX drain and coalescing. Called
+// with rs232Mutex held; output is queued for rs232SendOut().
+static void rs232Poll() {
   // 0. Telnet Client Management
   if (rs232TelnetServer.hasClient()) {
     if (!rs232TelnetConnected || !rs232TelnetClient.connected()) {
@@ -273,13 +500,10 @@ void rs232Loop() {
           }
           Serial2.write(inverted.data(), inverted.size());
 
-          JsonDocument doc;
-          doc["type"] = "tx";
-          doc["hex"] = bytesToHex(v.data(), v.size()); // Show clean data to UI
-          doc["ascii"] = bytesToAscii(v.data(), v.size());
-          String out;
-          serializeJson(doc, out);
-          wsRS232.textAll(out);
+          // Show clean data to UI
+          rs232QueueData(Rs232Out::TX, v.data(), v.size(),
+                         rs232TelnetClient.remoteIP(),
+                         rs232TelnetClient.remotePort());
         }
       }
     }
@@ -324,9 +548,9 @@ void rs232Loop() {
     return; // Skip normal RX processing during scan
   }
 
-  // 2. Normal RX
+  // 2. Normal RX: drain everything the driver has buffered.
   static uint8_t buf[256];
-  if (Serial2.available()) {
+  while (Serial2.available()) {
     int n = Serial2.read(buf, sizeof(buf));
     if (n > 0) {
       if (invertPolarity) {
@@ -357,19 +581,37 @@ void rs232Loop() {
           dispBuf[i] = ~dispBuf[i];
       }
 
-      if (rs232TelnetConnected && rs232TelnetClient.connected()) {
-        rs232TelnetClient.write(dispBuf, n);
+      rs232QueueTelnet(dispBuf, n);
+
+      for (int i = 0; i < n;) {
+        if (!rxFrameLen)
+          rxFrameStartMs = millis();
+        uint16_t take = min((int)(rxMaxBytes - rxFrameLen), n - i);
+        memcpy(rxFrame + rxFrameLen, dispBuf + i, take);
+        rxFrameLen += take;
+        i += take;
+        if (rxFrameLen >= rxMaxBytes)
+          rs232FlushRx();
       }
-
-      JsonDocument doc;
-      doc["type"] = "rx";
-      doc["hex"] = bytesToHex(dispBuf, n);
-      doc["ascii"] = bytesToAscii(dispBuf, n);
-      String out;
-      serializeJson(doc, out);
-      wsRS232.textAll(out);
+      rxLastByteUs = micros();
     }
   }
 
-  wsRS232.cleanupClients();
+  if (rxFrameLen) {
+    // 10 bit times per character (8N1).
+    uint32_t gapUs = (uint64_t)rxGapTenths * 1000000 / currentBaud;
+    if (micros() - rxLastByteUs >= gapUs ||
+        millis() - rxFrameStartMs >= rxMaxAgeMs)
+      rs232FlushRx();
+  }
+
+  if (millis() - rxWindowStartMs >= 1000) {
+    uint32_t elapsed = millis() - rxWindowStartMs;
+    rxFps = rxWindowFrames * 1000.0f / elapsed;
+    rxBytesPerFrame =
+        rxWindowFrames ? (float)rxWindowBytes / rxWindowFrames : 0;
+    rxWindowFrames = 0;
+    rxWindowBytes = 0;
+    rxWindowStartMs = millis();
+  }
 }
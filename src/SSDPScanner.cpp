@@ -1,12 +1,292 @@
 #include "SSDPScanner.h"
+#include "LogPipeline.h"
+#include "RecursiveLock.h"
 
+#include <AsyncTCP.h>
+#include <algorithm>
 #include <WiFi.h>
+#include <map>
+#include <memory>
 
 extern void logAll(const String &s);
 
 SSDPScanner ssdpScanner;
 
+static const uint8_t ssdpFetchMax = 4;        // concurrent description GETs
+static const uint32_t ssdpFetchTimeoutMs = 3000;
+static const size_t ssdpFetchBodyMax = 16384; // give up on huge documents
+static const size_t ssdpCacheMax = 48;
+static const uint32_t ssdpNegTtlMs = 60000; // retry failed fetches after this
+static const size_t ssdpPacketMax = 1472;   // one Ethernet-sized datagram
+static const size_t ssdpMaxResults = 128;
+
+// Incremental scan of a device description. Only the first occurrence of
+// each field counts, which is the root device's; embedded devices come
+// later in the document. Nothing but the three values is kept.
+struct DescParser {
+  static const uint8_t fields = 3;
+  String val[fields]; // friendlyName, manufacturer, modelName
+  bool have[fields] = {false, false, false};
+  bool statusOk = false;
+  bool inBody = false;
+  bool inTag = false;
+  bool tagEnded = false; // past the name, in attributes
+  int8_t field = -1;     // element whose text is being captured
+  uint8_t hdrPos = 0;
+  uint8_t crlf = 0;
+  uint8_t tagLen = 0;
+  char tag[24];
+  size_t bodyBytes = 0;
+
+  bool complete() const {
+    return (have[0] && have[1] && have[2]) || bodyBytes >= ssdpFetchBodyMax;
+  }
+
+  void endTag() {
+    tag[tagLen] = 0;
+    if (tag[0] == '/' || tag[0] == '?' || tag[0] == '!')
+      return;
+    const char *name = strchr(tag, ':'); // drop a namespace prefix
+    name = name ? name + 1 : tag;
+    static const char *const names[fields] = {"friendlyName", "manufacturer",
+                                              "modelName"};
+    for (uint8_t i = 0; i < fields; i++)
+      if (!have[i] && !strcmp(name, names[i]))
+        field = i;
+  }
+
+  void feed(const char *p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      char c = p[i];
+      if (!inBody) {
+        // "HTTP/1.x 200" - the status code sits at offsets 9..11
+        if (hdrPos >= 9 && hdrPos < 12)
+          statusOk = (hdrPos == 9 || statusOk) && c == "200"[hdrPos - 9];
+        if (hdrPos < 255)
+          hdrPos++;
+        crlf = (c == (crlf & 1 ? '\n' : '\r')) ? crlf + 1 : (c == '\r');
+        inBody = crlf == 4;
+        continue;
+      }
+      if (++bodyBytes >= ssdpFetchBodyMax)
+        return;
+      if (c == '<') {
+        if (field >= 0)
+          have[field] = true;
+        field = -1;
+        inTag = true;
+        tagEnded = false;
+        tagLen = 0;
+      } else if (inTag) {
+        if (c == '>') {
+          inTag = false;
+          endTag();
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+                   c == '/') {
+          tagEnded = tagEnded || tagLen > 0;
+          if (!tagLen && c == '/')
+            tag[tagLen++] = c;
+        } else if (!tagEnded && tagLen < sizeof(tag) - 1) {
+          tag[tagLen++] = c;
+        }
+      } else if (field >= 0 && val[field].length() < 96) {
+        val[field] += c;
+      }
+    }
+  }
+};
+
+struct SsdpFetch {
+  String url;
+  String host; // as written in the URL, for the Host header
+  String path;
+  IPAddress ip;
+  uint16_t port = 80;
+  AsyncClient *client = nullptr;
+  DescParser parser;
+  uint32_t startMs = 0;
+  bool done = false; // parser has all it needs; pumpFetches() closes
+};
+
+struct SsdpDesc {
+  String friendlyName;
+  String manufacturer;
+  String modelName;
+  bool ok = false;
+  uint32_t storedMs = 0;
+  uint32_t usedMs = 0;
+};
+
+// Keyed by USN (or LOCATION when a device sends none). Survives across
+// scans, so a repeat scan only fetches devices it has not seen before.
+static std::map<String, SsdpDesc> descCache;
+static std::vector<String> fetchQueue; // LOCATION URLs still to fetch
+static std::vector<std::unique_ptr<SsdpFetch>> fetches;
+static SemaphoreHandle_t ssdpMutex = nullptr;
+
+// Results are read by the web server task and fetches complete on the
+// async_tcp task, while loop() runs on the Arduino loop.
+struct SsdpLock : RecursiveLock {
+  SsdpLock() : RecursiveLock(ssdpMutex) {}
+};
+
+static String xmlUnescape(String s) {
+  s.trim();
+  s.replace("&lt;", "<");
+  s.replace("&gt;", ">");
+  s.replace("&quot;", "\"");
+  s.replace("&apos;", "'");
+  s.replace("&amp;", "&");
+  return s;
+}
+
+static String cacheKey(const SSDPDevice &d) {
+  return d.usn.length() ? d.usn : d.url;
+}
+
+static void applyDesc(SSDPDevice &d, const SsdpDesc &e) {
+  d.friendlyName = e.friendlyName;
+  d.manufacturer = e.manufacturer;
+  d.modelName = e.modelName;
+}
+
+static void cacheStore(const String &key, const SsdpDesc &e) {
+  if (!descCache.count(key) && descCache.size() >= ssdpCacheMax) {
+    auto lru = descCache.begin();
+    for (auto it = descCache.begin(); it != descCache.end(); ++it)
+      if ((int32_t)(it->second.usedMs - lru->second.usedMs) < 0)
+        lru = it;
+    descCache.erase(lru);
+  }
+  descCache[key] = e;
+}
+
+// A header value inside the packet buffer.
+struct SsdpSpan {
+  const char *p = nullptr;
+  size_t len = 0;
+  bool eq(const String &s) const {
+    return s.length() == len && !memcmp(s.c_str(), p, len);
+  }
+  String str() const {
+    String s;
+    s.concat(p, len);
+    return s;
+  }
+};
+
+struct SsdpHeaders {
+  SsdpSpan location;
+  SsdpSpan usn;
+  SsdpSpan st;
+  bool ended = false; // reached the blank line after the headers
+};
+
+// One pass over the header lines, matching names case-insensitively and
+// trimming values in place. Rejects anything that is not an HTTP response
+// (our own M-SEARCH and NOTIFY traffic can land on the socket too).
+static bool parseSsdpHeaders(const char *buf, size_t len, SsdpHeaders &h) {
+  if (len < 12 || strncmp(buf, "HTTP/1.", 7))
+    return false;
+  const char *end = buf + len;
+  const char *line = (const char *)memchr(buf, '\n', len);
+  while (line && ++line < end) {
+    const char *eol = (const char *)memchr(line, '\n', end - line);
+    const char *stop = eol ? eol : end;
+    if (stop > line && stop[-1] == '\r')
+      stop--;
+    if (stop == line) {
+      h.ended = true; // blank line ends the headers
+      break;
+    }
+    const char *colon = (const char *)memchr(line, ':', stop - line);
+    if (colon) {
+      size_t nameLen = colon - line;
+      const char *v = colon + 1;
+      const char *ve = stop;
+      while (v < ve && (*v == ' ' || *v == '\t'))
+        v++;
+      while (ve > v && (ve[-1] == ' ' || ve[-1] == '\t'))
+        ve--;
+      SsdpSpan *dst = nullptr;
+      if (nameLen == 8 && !strncasecmp(line, "LOCATION", 8))
+        dst = &h.location;
+      else if (nameLen == 3 && !strncasecmp(line, "USN", 3))
+        dst = &h.usn;
+      else if (nameLen == 2 && !strncasecmp(line, "ST", 2))
+        dst = &h.st;
+      if (dst) {
+        dst->p = v;
+        dst->len = ve - v;
+      }
+    }
+    line = eol;
+  }
+  return h.location.len || h.usn.len || h.st.len;
+}
+
+// Only plain http:// URLs. A host name that is not an address falls back to
+// the responder's IP rather than blocking on DNS.
+static bool parseLocation(const String &url, const String &fromIp,
+                          SsdpFetch &f) {
+  String u = url;
+  u.toLowerCase();
+  if (!u.startsWith("http://"))
+    return false;
+  int slash = url.indexOf('/', 7);
+  String hostPort = slash < 0 ? url.substring(7) : url.substring(7, slash);
+  f.path = slash < 0 ? String("/") : url.substring(slash);
+  f.host = hostPort;
+  int colon = hostPort.lastIndexOf(':');
+  String host = colon < 0 ? hostPort : hostPort.substring(0, colon);
+  f.port = colon < 0 ? 80 : hostPort.substring(colon + 1).toInt();
+  if (!f.port)
+    return false;
+  return f.ip.fromString(host) || f.ip.fromString(fromIp);
+}
+
+static void launchFetch(SsdpFetch &f) {
+  f.startMs = millis();
+  AsyncClient *c = new AsyncClient();
+  f.client = c;
+  c->onConnect(
+      [](void *arg, AsyncClient *c) {
+        SsdpLock lock;
+        SsdpFetch &f = *static_cast<SsdpFetch *>(arg);
+        // HTTP/1.0 so the body is never chunked
+        String req = "GET " + f.path + " HTTP/1.0\r\nHost: " + f.host +
+                     "\r\nConnection: close\r\n\r\n";
+        c->write(req.c_str(), req.length());
+      },
+      &f);
+  c->onData(
+      [](void *arg, AsyncClient *, void *data, size_t len) {
+        SsdpLock lock;
+        SsdpFetch &f = *static_cast<SsdpFetch *>(arg);
+        if (f.done)
+          return;
+        f.parser.feed((const char *)data, len);
+        // Closing here would delete c (see onDisconnect) while AsyncTCP is
+        // still in this callback.
+        if (f.parser.complete() || (f.parser.inBody && !f.parser.statusOk))
+          f.done = true;
+      },
+      &f);
+  c->onDisconnect(
+      [](void *arg, AsyncClient *c) {
+        SsdpLock lock;
+        static_cast<SsdpFetch *>(arg)->client = nullptr;
+        delete c;
+      },
+      &f);
+  if (!c->connect(f.ip, f.port)) {
+    f.client = nullptr;
+    delete c;
+  }
+}
+
 void SSDPScanner::begin() {
+  ssdpMutex = xSemaphoreCreateRecursiveMutex();
   _scanning = false;
   _pendingScan = false;
 }
@@ -21,12 +301,15 @@ void SSDPScanner::startScan() {
 // Called from loop() - safe to do UDP here
 void SSDPScanner::doStartScan() {
   _pendingScan = false;
-  _results.clear();
+  {
+    SsdpLock lock;
+    _results.clear();
+  }
   _scanning = true;
   _scanStartTime = millis();
 
   if (WiFi.status() != WL_CONNECTED) {
-    logAll("SSDP: WiFi STA not connected.");
+    logAt(LOGLV_WARN, "SSDP", "WiFi STA not connected.");
     _scanning = false;
     return;
   }
@@ -38,9 +321,9 @@ void SSDPScanner::doStartScan() {
 
   // Simple bind on ephemeral port - SSDP devices respond via unicast
   if (!_udp.begin(WiFi.localIP(), 8888)) {
-    logAll("SSDP: UDP begin failed, trying without IP bind...");
+    logAt(LOGLV_WARN, "SSDP", "UDP begin failed, trying without IP bind...");
     if (!_udp.begin(8888)) {
-      logAll("SSDP: UDP begin(8888) also failed!");
+      logAt(LOGLV_ERROR, "SSDP", "UDP begin(8888) also failed!");
       _scanning = false;
       return;
     }
@@ -63,12 +346,15 @@ void SSDPScanner::doStartScan() {
       if (_udp.endPacket()) {
         sent++;
       } else {
-        logAll("SSDP: endPacket FAILED for packet " + String(i + 1));
+        logAt(LOGLV_WARN, "SSDP",
+              "endPacket failed for packet " + String(i + 1));
       }
     } else {
-      logAll("SSDP: beginPacket FAILED for packet " + String(i + 1));
+      logAt(LOGLV_WARN, "SSDP",
+            "beginPacket failed for packet " + String(i + 1));
     }
   }
+  _packets = _truncated = _dropped = 0;
   logAll("SSDP: Sent " + String(sent) +
          "/3 M-SEARCH packets. Listening for 5s...");
 }
@@ -82,94 +368,172 @@ void SSDPScanner::loop() {
   if (!_scanning)
     return;
 
+  if (_fetching) {
+    pumpFetches();
+    return;
+  }
+
   // Timeout check (5 seconds)
   if (millis() - _scanStartTime > 5000) {
-    _scanning = false;
-    logAll("SSDP: Scan complete. Found " + String(_results.size()) +
-           " devices.");
+    logAll("SSDP: M-SEARCH window closed. Found " + String(_results.size()) +
+           " devices in " + String(_packets) + " packets (" +
+           String(_truncated) + " truncated, " + String(_dropped) +
+           " dropped).");
     _udp.stop();
+    startFetches();
     return;
   }
 
-  // Poll for packets
-  int limit = 5;
-  while (limit--) {
-    int len = _udp.parsePacket();
-    if (len <= 0)
-      break;
-
-    // Read payload
-    String data = "";
-    while (_udp.available())
-      data += (char)_udp.read();
-
-    String fromIP = _udp.remoteIP().toString();
-    logAll("SSDP: Rx " + String(len) + " bytes from " + fromIP);
+  // Drain everything queued; a large UPnP network answers in one burst and
+  // the socket drops whatever does not fit.
+  static uint8_t pkt[ssdpPacketMax];
+  int len;
+  while ((len = _udp.parsePacket()) > 0) {
+    _packets++;
+    int n = _udp.read(pkt, sizeof(pkt));
+    if (n < len)
+      _udp.flush();
+    if (n <= 0)
+      continue;
 
-    // Parse - Case Insensitive Header Search
-    SSDPDevice dev;
-    dev.ip = fromIP;
-
-    String dataUpper = data;
-    dataUpper.toUpperCase();
-
-    int locIdx = dataUpper.indexOf("LOCATION:");
-    if (locIdx != -1) {
-      int end = dataUpper.indexOf("\r", locIdx);
-      if (end == -1)
-        end = dataUpper.indexOf("\n", locIdx);
-      if (end > locIdx) {
-        String s = data.substring(locIdx + 9, end);
-        s.trim();
-        dev.url = s;
-      }
-    }
-
-    int usnIdx = dataUpper.indexOf("USN:");
-    if (usnIdx != -1) {
-      int end = dataUpper.indexOf("\r", usnIdx);
-      if (end == -1)
-        end = dataUpper.indexOf("\n", usnIdx);
-      if (end > usnIdx) {
-        String s = data.substring(usnIdx + 4, end);
-        s.trim();
-        dev.usn = s;
-      }
+    SsdpHeaders h;
+    if (!parseSsdpHeaders((const char *)pkt, n, h)) {
+      _dropped++;
+      continue;
     }
+    // WiFiUDP cuts a datagram to its own buffer before parsePacket()
+    // reports the length, so a cut reply shows as headers with no end.
+    if (n < len || !h.ended)
+      _truncated++;
 
-    int stIdx = dataUpper.indexOf("ST:");
-    if (stIdx != -1) {
-      int end = dataUpper.indexOf("\r", stIdx);
-      if (end == -1)
-        end = dataUpper.indexOf("\n", stIdx);
-      if (end > stIdx) {
-        String s = data.substring(stIdx + 3, end);
-        s.trim();
-        dev.st = s;
-      }
-    }
+    IPAddress from = _udp.remoteIP();
+    char fromIP[16];
+    snprintf(fromIP, sizeof(fromIP), "%u.%u.%u.%u", from[0], from[1], from[2],
+             from[3]);
 
-    // Deduplicate
+    // Deduplicate before anything is copied out of the packet
     bool exists = false;
     for (const auto &d : _results) {
-      if (d.usn.length() > 0 && d.usn == dev.usn) {
+      if (h.usn.len && h.usn.eq(d.usn)) {
         exists = true;
         break;
       }
-      if (d.ip == dev.ip && d.st == dev.st) {
+      if (d.ip == fromIP && h.st.eq(d.st)) {
         exists = true;
         break;
       }
     }
+    if (exists)
+      continue;
+    if (_results.size() >= ssdpMaxResults) {
+      _dropped++;
+      continue;
+    }
 
-    if (!exists)
-      _results.push_back(dev);
+    SSDPDevice dev;
+    dev.ip = fromIP;
+    dev.url = h.location.str();
+    dev.usn = h.usn.str();
+    dev.st = h.st.str();
+    SsdpLock lock;
+    _results.push_back(dev);
+  }
+}
+
+void SSDPScanner::startFetches() {
+  SsdpLock lock;
+  uint32_t now = millis();
+  _cacheHits = 0;
+  fetchQueue.clear();
+  for (auto &d : _results) {
+    auto it = descCache.find(cacheKey(d));
+    if (it != descCache.end() &&
+        (it->second.ok || now - it->second.storedMs < ssdpNegTtlMs)) {
+      it->second.usedMs = now;
+      applyDesc(d, it->second);
+      _cacheHits++;
+      continue;
+    }
+    // Devices announce several USNs that share one LOCATION; fetch it once.
+    if (d.url.length() &&
+        std::find(fetchQueue.begin(), fetchQueue.end(), d.url) ==
+            fetchQueue.end())
+      fetchQueue.push_back(d.url);
+  }
+  logAll("SSDP: " + String(_cacheHits) + " descriptions cached, " +
+         String(fetchQueue.size()) + " to fetch.");
+  _fetching = true;
+  pumpFetches();
+}
+
+void SSDPScanner::pumpFetches() {
+  SsdpLock lock;
+  uint32_t now = millis();
+
+  for (size_t i = 0; i < fetches.size();) {
+    SsdpFetch &f = *fetches[i];
+    if (f.client) {
+      if (f.done || now - f.startMs >= ssdpFetchTimeoutMs)
+        f.client->close(true);
+      i++;
+      continue;
+    }
+    // Finished (or never connected): publish to every result and cache
+    // under every key that points at this LOCATION.
+    SsdpDesc e;
+    DescParser &p = f.parser;
+    e.ok = p.statusOk && (p.have[0] || p.have[1] || p.have[2]);
+    if (e.ok) {
+      e.friendlyName = xmlUnescape(p.val[0]);
+      e.manufacturer = xmlUnescape(p.val[1]);
+      e.modelName = xmlUnescape(p.val[2]);
+    } else {
+      logAt(LOGLV_WARN, "SSDP", "Description fetch failed: " + f.url);
+    }
+    e.storedMs = e.usedMs = now;
+    for (auto &d : _results) {
+      if (d.url != f.url)
+        continue;
+      applyDesc(d, e);
+      cacheStore(cacheKey(d), e);
+    }
+    fetches.erase(fetches.begin() + i);
+  }
+
+  while (fetches.size() < ssdpFetchMax && !fetchQueue.empty()) {
+    std::unique_ptr<SsdpFetch> f(new SsdpFetch());
+    f->url = fetchQueue.back();
+    fetchQueue.pop_back();
+    String fromIp;
+    for (auto &d : _results)
+      if (d.url == f->url)
+        fromIp = d.ip;
+    if (!parseLocation(f->url, fromIp, *f)) {
+      logAll("SSDP: Unsupported LOCATION: " + f->url);
+      continue;
+    }
+    fetches.push_back(std::move(f));
+    launchFetch(*fetches.back());
+  }
+
+  if (fetches.empty() && fetchQueue.empty()) {
+    _fetching = false;
+    _scanning = false;
+    logAll("SSDP: Scan complete. Found " + String(_results.size()) +
+           " devices.");
   }
 }
 
 String SSDPScanner::getResultsJson() {
+  SsdpLock lock;
   JsonDocument doc;
   doc["running"] = _scanning;
+  doc["fetching"] = fetchQueue.size() + fetches.size();
+  doc["cacheHits"] = _cacheHits;
+  doc["cacheSize"] = descCache.size();
+  doc["packets"] = _packets;
+  doc["truncated"] = _truncated;
+  doc["dropped"] = _dropped;
   JsonArray arr = doc["results"].to<JsonArray>();
 
   for (const auto &d : _results) {
@@ -178,7 +542,9 @@ String SSDPScanner::getResultsJson() {
     obj["url"] = d.url;
     obj["usn"] = d.usn;
     obj["st"] = d.st;
-    obj["friendlyName"] = d.st; // fallback
+    obj["friendlyName"] = d.friendlyName;
+    obj["manufacturer"] = d.manufacturer;
+    obj["modelName"] = d.modelName;
   }
 
   String out;
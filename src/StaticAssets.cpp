@@ -0,0 +1,77 @@
+#include "StaticAssets.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+
+struct StaticAsset {
+  String path;
+  String etag; // quoted
+  String type;
+  bool br = false;
+  bool gzip = false;
+  bool immutable = false;
+};
+
+static const char *const cacheImmutable = "public, max-age=31536000, immutable";
+static const char *const cacheRevalidate = "no-cache";
+
+static void serveAsset(AsyncWebServerRequest *req, const StaticAsset &a) {
+  const char *cache = a.immutable ? cacheImmutable : cacheRevalidate;
+  // One ETag covers every encoding of the same content.
+  if (req->hasHeader("If-None-Match") &&
+      req->getHeader("If-None-Match")->value().indexOf(a.etag) >= 0) {
+    AsyncWebServerResponse *r = req->beginResponse(304);
+    r->addHeader("ETag", a.etag);
+    r->addHeader("Cache-Control", cache);
+    req->send(r);
+    return;
+  }
+  String accept = req->hasHeader("Accept-Encoding")
+                      ? req->getHeader("Accept-Encoding")->value()
+                      : String("");
+  // Only the compressed copies are on flash; every browser takes gzip.
+  const char *enc = nullptr;
+  String file = a.path;
+  if (a.br && accept.indexOf("br") >= 0) {
+    enc = "br";
+    file += ".br";
+  } else if (a.gzip) {
+    enc = "gzip";
+    file += ".gz";
+  }
+  AsyncWebServerResponse *r = req->beginResponse(LittleFS, file, a.type);
+  if (enc)
+    r->addHeader("Content-Encoding", enc);
+  r->addHeader("ETag", a.etag);
+  r->addHeader("Cache-Control", cache);
+  r->addHeader("Vary", "Accept-Encoding");
+  req->send(r);
+}
+
+bool setupStaticAssets(AsyncWebServer &server) {
+  File f = LittleFS.open("/assets.json", "r");
+  if (!f)
+    return false;
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, f);
+  f.close();
+  if (err || !doc.is<JsonObject>())
+    return false;
+
+  for (JsonPair kv : doc.as<JsonObject>()) {
+    StaticAsset a;
+    a.path = kv.key().c_str();
+    a.etag = "\"" + String(kv.value()["etag"] | "") + "\"";
+    a.type = kv.value()["type"] | "application/octet-stream";
+    a.immutable = kv.value()["immutable"] | false;
+    for (JsonVariant e : kv.value()["enc"].as<JsonArray>()) {
+      a.br |= e == "br";
+      a.gzip |= e == "gzip";
+    }
+    server.on(a.path.c_str(), HTTP_GET,
+              [a](AsyncWebServerRequest *req) { serveAsset(req, a); });
+    if (a.path == "/index.html")
+      server.on("/", HTTP_GET,
+                [a](AsyncWebServerRequest *req) { serveAsset(req, a); });
+  }
+  return true;
+}
@@ -0,0 +1,134 @@
+#include "TcpPool.h"
+#include <memory>
+#include <vector>
+
+uint32_t tcpPoolIdleMs = 30000;
+
+static const size_t tcpPoolMax = 8;
+
+struct PoolConn {
+  IPAddress addr;
+  uint16_t port = 0;
+  WiFiClient client;
+  uint32_t lastUsedMs = 0;
+  bool busy = false;
+};
+
+// Entries are heap-allocated so the WiFiClient pointers handed out stay
+// valid while the vector changes.
+static std::vector<std::unique_ptr<PoolConn>> pool;
+static SemaphoreHandle_t poolMutex = nullptr;
+static TcpPoolStats stats;
+
+class PoolLock {
+public:
+  PoolLock() {
+    if (!poolMutex)
+      poolMutex = xSemaphoreCreateMutex();
+    xSemaphoreTake(poolMutex, portMAX_DELAY);
+  }
+  ~PoolLock() { xSemaphoreGive(poolMutex); }
+};
+
+// Caller holds the lock.
+static void dropAt(size_t i) {
+  pool[i]->client.stop();
+  pool[i] = std::move(pool.back());
+  pool.pop_back();
+}
+
+WiFiClient *tcpPoolAcquire(const IPAddress &addr, uint16_t port,
+                           uint16_t connectTimeoutMs, bool *reused,
+                           uint32_t *connectMs) {
+  {
+    PoolLock lock;
+    for (size_t i = 0; i < pool.size();) {
+      PoolConn &c = *pool[i];
+      if (c.busy || c.port != port || c.addr != addr) {
+        i++;
+        continue;
+      }
+      if (!c.client.connected()) {
+        dropAt(i); // peer closed it while idle
+        continue;
+      }
+      c.busy = true;
+      stats.reuses++;
+      if (reused)
+        *reused = true;
+      if (connectMs)
+        *connectMs = 0;
+      return &c.client;
+    }
+  }
+
+  // Connect without holding the lock; this can take connectTimeoutMs.
+  std::unique_ptr<PoolConn> c(new PoolConn());
+  c->addr = addr;
+  c->port = port;
+  c->busy = true;
+  uint32_t t0 = millis();
+  if (!c->client.connect(addr, port, connectTimeoutMs))
+    return nullptr;
+  c->client.setNoDelay(true);
+  if (reused)
+    *reused = false;
+  if (connectMs)
+    *connectMs = millis() - t0;
+
+  PoolLock lock;
+  stats.connects++;
+  if (pool.size() >= tcpPoolMax) {
+    // Make room by closing the least recently used idle connection.
+    int lru = -1;
+    for (size_t i = 0; i < pool.size(); i++)
+      if (!pool[i]->busy &&
+          (lru < 0 || pool[i]->lastUsedMs < pool[lru]->lastUsedMs))
+        lru = i;
+    if (lru >= 0)
+      dropAt(lru);
+  }
+  pool.push_back(std::move(c));
+  return &pool.back()->client;
+}
+
+void tcpPoolRelease(WiFiClient *client, bool keep) {
+  PoolLock lock;
+  for (size_t i = 0; i < pool.size(); i++) {
+    if (&pool[i]->client != client)
+      continue;
+    if (!keep || !client->connected() || pool.size() > tcpPoolMax) {
+      dropAt(i);
+    } else {
+      pool[i]->busy = false;
+      pool[i]->lastUsedMs = millis();
+    }
+    return;
+  }
+}
+
+void tcpPoolExpire() {
+  PoolLock lock;
+  uint32_t now = millis();
+  for (size_t i = 0; i < pool.size();) {
+    PoolConn &c = *pool[i];
+    if (!c.busy && (now - c.lastUsedMs >= tcpPoolIdleMs ||
+                    !c.client.connected())) {
+      stats.expired++;
+      dropAt(i);
+    } else {
+      i++;
+    }
+  }
+}
+
+TcpPoolStats tcpPoolStats() {
+  PoolLock lock;
+  TcpPoolStats s = stats;
+  s.open = pool.size();
+  s.busy = 0;
+  for (auto &c : pool)
+    if (c->busy)
+      s.busy++;
+  return s;
+}
@@ -1,6 +1,8 @@
 #include "TcpServerHandler.h"
+#include "LogPipeline.h"
 #include "Utils.h"
 #include "WebAPI.h" // For wsTcpServer
+#include "WsStream.h"
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h> // Pulls in AsyncServer
 #include <algorithm>
@@ -22,7 +24,8 @@ void TcpServerHandler::begin(uint16_t port) {
       nullptr);
 
   _server->begin();
-  Serial.println("TCPS: Server started on port " + String(_port));
+  logFmt(LOGLV_INFO, "TCPS", "Server started on port %u",
+         (unsigned)_port);
 }
 
 void TcpServerHandler::end() {
@@ -58,7 +61,8 @@ void TcpServerHandler::broadcast(const String &msg) {
 }
 
 void TcpServerHandler::handleNewClient(AsyncClient *client) {
-  Serial.println("TCPS: New Client - " + client->remoteIP().toString());
+  logFmt(LOGLV_INFO, "TCPS", "New client %s",
+         client->remoteIP().toString().c_str());
   _clients.push_back(client);
 
   // Notify UI
@@ -68,7 +72,7 @@ void TcpServerHandler::handleNewClient(AsyncClient *client) {
   doc["ip"] = client->remoteIP().toString();
   String s;
   serializeJson(doc, s);
-  wsTcpServer.textAll(s);
+  wsTextAll(wsTcpServer, s);
 
   client->onData([](void *, AsyncClient *c, void *data,
                     size_t len) { tcpServerHandler.handleData(c, data, len); },
@@ -80,19 +84,16 @@ void TcpServerHandler::handleNewClient(AsyncClient *client) {
 }
 
 void TcpServerHandler::handleData(AsyncClient *client, void *data, size_t len) {
-  Serial.printf("TCPS: Data len=%u\n", len);
+  logFmt(LOGLV_DEBUG, "TCPS", "Data len=%u", (unsigned)len);
   JsonDocument doc;
   doc["type"] = "rx";
   doc["from"] = client->remoteIP().toString();
-  doc["ascii"] = bytesToAscii((uint8_t *)data, len);
-  doc["hex"] = bytesToHex((uint8_t *)data, len);
-  String s;
-  serializeJson(doc, s);
-  wsTcpServer.textAll(s);
+  wsStreamData(wsTcpServer, WS_CH_TCPSERVER, WS_DIR_RX, (uint8_t *)data, len,
+               doc, client->remoteIP(), client->remotePort());
 }
 
 void TcpServerHandler::handleDisconnect(AsyncClient *client) {
-  Serial.println("TCPS: Client Disconnected");
+  logAt(LOGLV_INFO, "TCPS", "Client disconnected");
   // Notify UI
   JsonDocument doc;
   doc["type"] = "event";
@@ -100,7 +101,7 @@ void TcpServerHandler::handleDisconnect(AsyncClient *client) {
   doc["ip"] = client->remoteIP().toString();
   String s;
   serializeJson(doc, s);
-  wsTcpServer.textAll(s);
+  wsTextAll(wsTcpServer, s);
 
   // Remove from vector
   auto it = std::find(_clients.begin(), _clients.end(), client);
@@ -1,6 +1,8 @@
 #include "TerminalHandler.h"
+#include "LogPipeline.h"
 #include "Utils.h"
 #include "WebAPI.h" // For wsTerm
+#include "WsStream.h"
 #include <ArduinoJson.h>
 
 static AsyncClient *termClient = nullptr;
@@ -16,17 +18,14 @@ void termSendStatus() {
   d["port"] = termPort;
   String s;
   serializeJson(d, s);
-  wsTerm.textAll(s);
+  wsTextAll(wsTerm, s);
 }
 
 static void _onData(void *arg, AsyncClient *c, void *data, size_t len) {
   JsonDocument d;
   d["type"] = "rx";
-  d["hex"] = bytesToHex((uint8_t *)data, len);
-  d["ascii"] = bytesToAscii((uint8_t *)data, len);
-  String s;
-  serializeJson(d, s);
-  wsTerm.textAll(s);
+  wsStreamData(wsTerm, WS_CH_TERM, WS_DIR_RX, (uint8_t *)data, len, d,
+               c->remoteIP(), c->remotePort());
 }
 
 static void _onConnect(void *arg, AsyncClient *c) {
@@ -37,7 +36,7 @@ static void _onConnect(void *arg, AsyncClient *c) {
   d["msg"] = "TCP Connected";
   String s;
   serializeJson(d, s);
-  wsTerm.textAll(s);
+  wsTextAll(wsTerm, s);
 }
 
 static void _onDisconnect(void *arg, AsyncClient *c) {
@@ -55,13 +54,13 @@ static void _onError(void *arg, AsyncClient *c, int8_t error) {
   d["msg"] = String("TCP Error: ") + error;
   String s;
   serializeJson(d, s);
-  wsTerm.textAll(s);
+  wsTextAll(wsTerm, s);
 }
 
 void termRequestConnect(String host, uint16_t port) {
-  Serial.println("TERM: Connect Request");
+  logAt(LOGLV_DEBUG, "TERM", "Connect request");
   if (termClient) {
-    Serial.println("TERM: Closing existing");
+    logAt(LOGLV_DEBUG, "TERM", "Closing existing");
     if (termClient->connected())
       termClient->close(true);
     delete termClient;
@@ -72,10 +71,9 @@ void termRequestConnect(String host, uint16_t port) {
   termPort = port;
   termConnected = false;
 
-  Serial.println("TERM: Allocating AsyncClient");
   termClient = new AsyncClient();
   if (!termClient) {
-    Serial.println("TERM: Allocation failed!");
+    logAt(LOGLV_ERROR, "TERM", "Allocation failed");
     return;
   }
 
@@ -88,10 +86,8 @@ void termRequestConnect(String host, uint16_t port) {
   IPAddress ip;
   bool isIp = ip.fromString(host);
 
-  Serial.print("TERM: Connecting to ");
-  Serial.print(host);
-  Serial.print(":");
-  Serial.println(port);
+  logFmt(LOGLV_INFO, "TERM", "Connecting to %s:%u", host.c_str(),
+         (unsigned)port);
 
   bool result = false;
   const int maxRetries = 3;
@@ -99,7 +95,7 @@ void termRequestConnect(String host, uint16_t port) {
   for (int attempt = 1; attempt <= maxRetries && !result; attempt++) {
     if (attempt > 1) {
       delay(500); // Brief delay between retries
-      Serial.printf("TERM: Retry attempt %d/%d\n", attempt, maxRetries);
+      logFmt(LOGLV_WARN, "TERM", "Retry attempt %d/%d", attempt, maxRetries);
     }
 
     if (isIp) {
@@ -110,23 +106,23 @@ void termRequestConnect(String host, uint16_t port) {
   }
 
   if (!result) {
-    Serial.println("TERM: Connect failed after retries");
+    logAt(LOGLV_WARN, "TERM", "Connect failed after retries");
     JsonDocument d;
     d["type"] = "error";
     d["msg"] = "Connect failed after " + String(maxRetries) + " attempts";
     String s;
     serializeJson(d, s);
-    wsTerm.textAll(s);
+    wsTextAll(wsTerm, s);
     delete termClient;
     termClient = nullptr;
   } else {
-    Serial.println("TERM: Connect initiated");
+    logAt(LOGLV_DEBUG, "TERM", "Connect initiated");
     JsonDocument d;
     d["type"] = "log";
     d["msg"] = "Connecting to " + host + ":" + String(port) + "...";
     String s;
     serializeJson(d, s);
-    wsTerm.textAll(s);
+    wsTextAll(wsTerm, s);
   }
 }
 
@@ -142,9 +138,9 @@ void termRequestSend(const uint8_t *data, size_t len) {
       termClient->write((const char *)data, len);
     } else {
       // buffer full
-      wsTerm.textAll("{\"type\":\"error\",\"msg\":\"TX Buffer Full\"}");
+      wsTextAll(wsTerm, "{\"type\":\"error\",\"msg\":\"TX Buffer Full\"}");
     }
   } else {
-    wsTerm.textAll("{\"type\":\"error\",\"msg\":\"Not connected\"}");
+    wsTextAll(wsTerm, "{\"type\":\"error\",\"msg\":\"Not connected\"}");
   }
 }
@@ -1,5 +1,6 @@
 #include "UdpHandler.h"
 #include "Utils.h"
+#include "WsStream.h"
 
 UdpHandler udpHandler;
 
@@ -44,12 +45,8 @@ void UdpHandler::loop() {
       doc["type"] = "rx";
       doc["from"] = _udp.remoteIP().toString();
       doc["port"] = _udp.remotePort();
-      doc["ascii"] = bytesToAscii(_packetBuffer, len);
-      doc["hex"] = bytesToHex(_packetBuffer, len);
-
-      String out;
-      serializeJson(doc, out);
-      wsUdp.textAll(out);
+      wsStreamData(wsUdp, WS_CH_UDP, WS_DIR_RX, _packetBuffer, len, doc,
+                   _udp.remoteIP(), _udp.remotePort());
     }
   }
 }
@@ -1,15 +1,77 @@
 #include "Utils.h"
 #include <Arduino.h>
 
+// "00" "01" ... "FF": the two hex digits of every byte value, indexed by
+// 2 * byte. Built from literals so it lives in flash.
+#define HEX_ROW(h)                                                             \
+  h "0" h "1" h "2" h "3" h "4" h "5" h "6" h "7" h "8" h "9" h "A" h "B" h "C" \
+      h "D" h "E" h "F"
+static const char hexPairs[] =
+    HEX_ROW("0") HEX_ROW("1") HEX_ROW("2") HEX_ROW("3") HEX_ROW("4")
+        HEX_ROW("5") HEX_ROW("6") HEX_ROW("7") HEX_ROW("8") HEX_ROW("9")
+            HEX_ROW("A") HEX_ROW("B") HEX_ROW("C") HEX_ROW("D") HEX_ROW("E")
+                HEX_ROW("F");
+#undef HEX_ROW
+
+size_t bytesToHex(const uint8_t *data, size_t len, char *out, size_t outLen) {
+  if (!len || outLen < 2)
+    return 0;
+  // Each byte takes 3 chars ("XX "), except the last which takes 2.
+  size_t n = min(len, (outLen + 1) / 3);
+  char *p = out;
+  for (size_t i = 0; i + 1 < n; i++) {
+    memcpy(p, &hexPairs[data[i] * 2], 2);
+    p[2] = ' ';
+    p += 3;
+  }
+  memcpy(p, &hexPairs[data[n - 1] * 2], 2);
+  return p + 2 - out;
+}
+
+// A byte is printable when it is in 0x20..0x7E. For a 32-bit word, bit 7 of
+// each lane in the result is set where the byte is not.
+static inline uint32_t nonPrintableMask(uint32_t w) {
+  uint32_t high = w;                                  // >= 0x80
+  uint32_t low = ~((w | 0x80808080u) - 0x20202020u);  // < 0x20
+  uint32_t del = (w & 0x7F7F7F7Fu) + 0x01010101u;     // == 0x7F
+  return (high | low | del) & 0x80808080u;
+}
+
+size_t bytesToAscii(const uint8_t *data, size_t len, char *out,
+                    size_t outLen) {
+  size_t n = min(len, outLen);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32_t w;
+    memcpy(&w, data + i, 4);
+    if (nonPrintableMask(w)) {
+      for (size_t k = i; k < i + 4; k++)
+        out[k] = (uint8_t)(data[k] - 32) < 95 ? (char)data[k] : '.';
+    } else {
+      memcpy(out + i, &w, 4);
+    }
+  }
+  for (; i < n; i++)
+    out[i] = (uint8_t)(data[i] - 32) < 95 ? (char)data[i] : '.';
+  return n;
+}
+
+// The String wrappers encode through a stack buffer so the result is built
+// with one reserve() and a few block appends.
 String bytesToHex(const uint8_t *data, size_t len) {
-  static const char *h = "0123456789ABCDEF";
   String out;
-  out.reserve(len * 3);
-  for (size_t i = 0; i < len; i++) {
-    out += h[(data[i] >> 4) & 0xF];
-    out += h[data[i] & 0xF];
-    if (i + 1 < len)
-      out += ' ';
+  if (!len)
+    return out;
+  out.reserve(hexLen(len));
+  char buf[384];
+  while (len) {
+    size_t n = min(len, sizeof(buf) / 3);
+    size_t w = bytesToHex(data, n, buf, sizeof(buf));
+    len -= n;
+    data += n;
+    if (len)
+      buf[w++] = ' ';
+    out.concat(buf, w);
   }
   return out;
 }
@@ -17,9 +79,12 @@ String bytesToHex(const uint8_t *data, size_t len) {
 String bytesToAscii(const uint8_t *data, size_t len) {
   String out;
   out.reserve(len);
-  for (size_t i = 0; i < len; i++) {
-    char c = (char)data[i];
-    out += (c >= 32 && c <= 126) ? c : '.';
+  char buf[256];
+  while (len) {
+    size_t n = bytesToAscii(data, len, buf, sizeof(buf));
+    out.concat(buf, n);
+    len -= n;
+    data += n;
   }
   return out;
 }
@@ -64,15 +129,13 @@ String detectSuffix(const uint8_t *data, size_t len) {
   return "";
 }
 
-String simpleHash(const String &s) {
-  uint32_t h = 2166136261u;
-  for (size_t i = 0; i < s.length(); i++) {
-    h ^= (uint8_t)s[i];
+uint32_t fnv1a32(const void *data, size_t len, uint32_t h) {
+  const uint8_t *p = (const uint8_t *)data;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
     h *= 16777619u;
   }
-  char buf[16];
-  snprintf(buf, sizeof(buf), "%08lX", (unsigned long)h);
-  return String(buf);
+  return h;
 }
 
 String genId() {
@@ -109,3 +172,11 @@ bool parseHexBytes(const String &hex, std::vector<uint8_t> &out) {
   }
   return true;
 }
+
+String unescapeCtl(const String &s) {
+  String out = s;
+  out.replace("\\r", "\r");
+  out.replace("\\n", "\n");
+  out.replace("\\t", "\t");
+  return out;
+}
@@ -10,126 +10,23 @@
 #include "CaptureProxy.h"
 #include "ConfigManager.h"
 #include "MacroHandler.h"
+#include "LogPipeline.h"
+#include "MdnsBrowser.h"
 #include "OTAHandler.h"
+#include "PJLink.h"
 #include "PortScanner.h"
 #include "RS232Handler.h"
 #include "SSDPScanner.h"
-
-// mDNS scan state
-#include <Arduino.h>
-#include <ArduinoJson.h>
-#include <IPAddress.h>
-#include <mdns.h>
-
-static volatile bool mdnsScanPending = false;
-static volatile bool mdnsScanning = false;
-static String mdnsPendingService = "";
-static String mdnsPendingProto = "";
-static String mdnsResultsJson = "{\"running\":false,\"results\":[]}";
-static mdns_search_once_t *mdnsSearch = nullptr;
-static uint32_t mdnsScanStartTime = 0;
-
-void mdnsScanLoop() {
-  if (mdnsScanPending && !mdnsScanning) {
-    mdnsScanPending = false;
-    mdnsScanning = true;
-
-    String service = mdnsPendingService;
-    String proto = mdnsPendingProto;
-
-    // Strip leading underscore for ESP-IDF mdns_query_async_new
-    if (service.startsWith("_"))
-      service.remove(0, 1);
-    if (proto.startsWith("_"))
-      proto.remove(0, 1);
-
-    char srv[64];
-    char prt[32];
-    snprintf(srv, sizeof(srv), "_%s", service.c_str());
-    snprintf(prt, sizeof(prt), "_%s", proto.c_str());
-
-    Serial.printf(
-        "mDNS: Starting async query for service=%s proto=%s (4500ms)\n", srv,
-        prt);
-
-    // Start an async query for 4500ms
-    mdnsSearch =
-        mdns_query_async_new(NULL, srv, prt, MDNS_TYPE_PTR, 4500, 20, NULL);
-    mdnsScanStartTime = millis();
-
-    // Update JSON to indicate running
-    mdnsResultsJson = "{\"running\":true,\"results\":[]}";
-    return;
-  }
-
-  if (mdnsScanning && mdnsSearch) {
-    mdns_result_t *results = nullptr;
-    // Check if the query has finished (or if 5000ms safety timeout hit)
-    if (mdns_query_async_get_results(mdnsSearch, 0, &results) ||
-        (millis() - mdnsScanStartTime > 5000)) {
-      mdns_query_async_delete(mdnsSearch);
-      mdnsSearch = nullptr;
-
-      int count = 0;
-      JsonDocument res;
-      res["running"] = false;
-      JsonArray arr = res["results"].to<JsonArray>();
-
-      mdns_result_t *r = results;
-      while (r) {
-        count++;
-        JsonObject o = arr.add<JsonObject>();
-        if (r->hostname)
-          o["hostname"] = String(r->hostname);
-        o["port"] = r->port;
-
-        // Extract IP
-        if (r->addr) {
-          if (r->addr->addr.type == ESP_IPADDR_TYPE_V4) {
-            o["ip"] = IPAddress(r->addr->addr.u_addr.ip4.addr).toString();
-          } else if (r->addr->addr.type == ESP_IPADDR_TYPE_V6) {
-            o["ip"] = "IPv6"; // Ignore IPv6 for now
-          }
-        } else {
-          o["ip"] = "Unknown";
-        }
-        r = r->next;
-      }
-
-      res["count"] = count;
-      serializeJson(res, mdnsResultsJson);
-      if (results)
-        mdns_query_results_free(results);
-
-      Serial.printf("mDNS: Async scan complete. Found %d services.\n", count);
-      mdnsScanning = false;
-    }
-  }
-}
-
-// PJLink non-blocking execution state
-volatile bool pjlPending = false;
-volatile bool pjlFinished = false;
-String pjlPendingIp = "";
-String pjlPendingPass = "";
-String pjlPendingCmd = "";
-volatile char pjlResultBuf[256] = {0};
-
-void pjlinkLoop() {
-  if (pjlPending) {
-    String res = pjlinkCmd(pjlPendingIp, pjlPendingPass, pjlPendingCmd);
-    strncpy((char *)pjlResultBuf, res.c_str(), sizeof(pjlResultBuf) - 1);
-    pjlResultBuf[sizeof(pjlResultBuf) - 1] = '\0';
-    pjlFinished = true;
-    pjlPending = false;
-  }
-}
+#include "StaticAssets.h"
+#include "TcpPool.h"
 
 #include "TcpServerHandler.h" // Added
 #include "TerminalHandler.h"
 #include "UdpHandler.h" // Added
 #include "Utils.h"
 #include "WiFiHelper.h"
+#include "WsFanout.h"
+#include "WsStream.h"
 
 extern bool learnEnabled;
 extern uint16_t learnPort;
@@ -142,6 +39,70 @@ AsyncWebSocket wsDisc("/wsdisc");
 AsyncWebSocket wsRS232("/wsrs232");
 AsyncWebSocket wsUdp("/wsudp");             // New UDP WebSocket
 AsyncWebSocket wsTcpServer("/wstcpserver"); // TCP Server WebSocket
+AsyncWebSocket wsMacro("/wsmacro");         // Macro run/step traces
+
+// ?since=<cursor>&limit=<n>&fields=a,b for the list endpoints. Lists are
+// written record by record into an AsyncResponseStream, so no endpoint
+// holds a JsonDocument of the whole list plus a String copy of it.
+struct ListQuery {
+  bool hasSince = false;
+  uint32_t since = 0;
+  size_t limit = 0; // 0: no limit
+  std::vector<String> fields;
+};
+
+static ListQuery listQuery(AsyncWebServerRequest *req, int sinceBase) {
+  ListQuery q;
+  if (req->hasParam("since")) {
+    q.hasSince = true;
+    q.since = strtoul(req->getParam("since")->value().c_str(), nullptr,
+                      sinceBase);
+  }
+  if (req->hasParam("limit"))
+    q.limit = req->getParam("limit")->value().toInt();
+  if (req->hasParam("fields")) {
+    String f = req->getParam("fields")->value();
+    int pos = 0;
+    while (pos < (int)f.length()) {
+      int comma = f.indexOf(',', pos);
+      if (comma < 0)
+        comma = f.length();
+      String name = f.substring(pos, comma);
+      name.trim();
+      if (name.length())
+        q.fields.push_back(name);
+      pos = comma + 1;
+    }
+  }
+  return q;
+}
+
+static void writeRecord(Print &out, JsonObjectConst rec, const ListQuery &q,
+                        bool &first) {
+  if (!first)
+    out.print(',');
+  first = false;
+  if (q.fields.empty()) {
+    serializeJson(rec, out);
+    return;
+  }
+  JsonDocument sub;
+  for (auto &f : q.fields)
+    if (!rec[f].isNull())
+      sub[f] = rec[f];
+  serializeJson(sub, out);
+}
+
+// Writes head's members followed by `"key":[`, leaving the object open.
+static void beginList(Print &out, JsonDocument &head, const char *key) {
+  String s;
+  serializeJson(head, s);
+  s.remove(s.length() - 1);
+  out.print(s);
+  if (head.size())
+    out.print(',');
+  out.printf("\"%s\":[", key);
+}
 
 void setupRoutes() {
 
@@ -205,11 +166,88 @@ void setupRoutes() {
     doc["disc"]["running"] = discRunning;
     doc["disc"]["progress"] = discProgress;
 
+    wsFanStatsJson(doc["ws"].to<JsonArray>());
+
     String out;
     serializeJson(doc, out);
     req->send(200, "application/json", out);
   });
 
+  // Tail of the log ring, oldest first. Poll with since=<cursor>; "gap" is
+  // set when records after since were already overwritten.
+  server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *req) {
+    ListQuery q = listQuery(req, 10);
+    LogLevel maxLevel = LOGLV_DEBUG;
+    if (req->hasParam("level") &&
+        !logParseLevel(req->getParam("level")->value(), maxLevel)) {
+      req->send(400, "application/json", "{\"error\":\"bad level\"}");
+      return;
+    }
+    String module =
+        req->hasParam("module") ? req->getParam("module")->value() : "";
+    uint32_t cursor = q.since;
+    bool gap = logOldestSeq() > q.since + 1;
+    size_t n = 0;
+    bool more = false;
+    bool first = true;
+    JsonDocument rec;
+    AsyncResponseStream *res = req->beginResponseStream("application/json");
+    res->print("{\"records\":[");
+    logForEach(q.since, [&](const LogRec &r) {
+      if (q.limit && n >= q.limit) {
+        more = true;
+        return false;
+      }
+      cursor = r.seq;
+      if (r.level > maxLevel ||
+          (module.length() && !module.equalsIgnoreCase(r.module)))
+        return true;
+      rec.clear();
+      logRecToJson(r, rec.to<JsonObject>());
+      writeRecord(*res, rec.as<JsonObjectConst>(), q, first);
+      n++;
+      return true;
+    });
+    JsonDocument tail;
+    tail["cursor"] = cursor;
+    tail["more"] = more;
+    tail["gap"] = gap && q.hasSince;
+    tail["dropped"] = logDropped();
+    logLevelsJson(tail["levels"].to<JsonObject>());
+    String s;
+    serializeJson(tail, s);
+    s[0] = ',';
+    res->print(']');
+    res->print(s);
+    req->send(res);
+  });
+
+  server.on(
+      "/api/logs/level", HTTP_POST, [](AsyncWebServerRequest *req) {}, nullptr,
+      [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
+         size_t) {
+        JsonDocument doc;
+        if (deserializeJson(doc, data, len)) {
+          req->send(400, "application/json", "{\"error\":\"bad json\"}");
+          return;
+        }
+        LogLevel level;
+        if (!logParseLevel(doc["level"] | "", level)) {
+          req->send(400, "application/json", "{\"error\":\"bad level\"}");
+          return;
+        }
+        if (!logSetLevel(doc["module"] | "*", level)) {
+          req->send(400, "application/json",
+                    "{\"error\":\"bad module or table full\"}");
+          return;
+        }
+        JsonDocument res;
+        logLevelsJson(res["levels"].to<JsonObject>());
+        String out;
+        serializeJson(res, out);
+        req->send(200, "application/json", out);
+      });
+
   server.on("/update", HTTP_GET, [](AsyncWebServerRequest *request) {
     request->send(200, "text/html",
                   "<form method='POST' action='/update' "
@@ -247,7 +285,8 @@ void setupRoutes() {
         }
         if (final) {
           if (Update.end(true)) {
-            Serial.printf("Update Success: %uB\n", index + len);
+            logFmt(LOGLV_INFO, "OTA", "Update success: %uB",
+                   (unsigned)(index + len));
           } else {
             Update.printError(Serial);
           }
@@ -311,19 +350,38 @@ void setupRoutes() {
         if (deserializeJson(doc, data, len)) {
           return req->send(400, "text/plain", "Invalid JSON");
         }
-        if (doc["host"].is<String>() && doc["ports"].is<JsonArray>()) {
-          String ip = doc["host"];
-          JsonArray ports = doc["ports"];
-          std::vector<int> portList;
-          for (JsonVariant v : ports) {
-            portList.push_back(v.as<int>());
-          }
-          portScanner.startScan(ip, portList);
-          req->send(200, "application/json", "{\"status\":\"started\"}");
+        if (!doc["host"].is<String>() || doc["ports"].isNull()) {
+          return req->send(400, "text/plain",
+                           "Bad Request: Missing 'host' or 'ports'");
+        }
+        // A name is resolved by portScanner.loop(), not on async_tcp.
+        String host = doc["host"];
+
+        // "ports" is a range spec ("1-1024,4352,41794") or a plain array.
+        String spec;
+        if (doc["ports"].is<JsonArray>()) {
+          for (JsonVariant v : doc["ports"].as<JsonArray>())
+            spec += v.as<String>() + ",";
         } else {
-          req->send(400, "text/plain",
-                    "Bad Request: Missing 'host' or 'ports'");
+          spec = doc["ports"].as<String>();
         }
+        std::vector<PortRange> ranges;
+        String err;
+        if (!PortScanner::parsePorts(spec, ranges, err))
+          return req->send(400, "text/plain", "Bad Request: " + err);
+
+        if (!portScanner.startScan(host, ranges, doc["window"] | 0u,
+                                   doc["rate"] | 0u, doc["timeout"] | 0u))
+          return req->send(409, "text/plain", "Conflict: Scan in progress");
+        uint32_t total = 0;
+        for (auto &r : ranges)
+          total += (uint32_t)r.to - r.from + 1;
+        JsonDocument res;
+        res["status"] = "started";
+        res["ports"] = total;
+        String out;
+        serializeJson(res, out);
+        req->send(200, "application/json", out);
       });
 
   // GET /api/portscan/status
@@ -388,36 +446,45 @@ void setupRoutes() {
         req->send(200, "application/json", "{\"ok\":true}");
       });
 
-  // API: MDNS Scan (async — runs on background task)
+  // API: MDNS Scan (queued; mdnsScanLoop() runs the queries from loop())
   server.on(
       "/api/mdns/scan", HTTP_POST, [](AsyncWebServerRequest *req) {}, nullptr,
       [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
          size_t) {
-        if (mdnsScanning) {
-          req->send(200, "application/json",
-                    "{\"status\":\"already_running\"}");
-          return;
-        }
         JsonDocument doc;
-        if (deserializeJson(doc, data, len)) {
+        if (len && deserializeJson(doc, data, len)) {
           req->send(400, "application/json", "{\"error\":\"bad json\"}");
           return;
         }
-        String service = doc["service"] | "_http";
-        String proto = doc["proto"] | "tcp";
-
-        // Set pending flag — main loop will run the query
-        mdnsPendingService = service;
-        mdnsPendingProto = proto;
-        mdnsResultsJson = "{\"running\":true,\"results\":[]}";
-        mdnsScanPending = true;
+        // "services": ["_airplay._tcp", ...], or a single service/proto
+        // pair. Neither browses the default AV set.
+        std::vector<String> types;
+        for (JsonVariant t : doc["services"].as<JsonArray>())
+          types.push_back(t.as<String>());
+        if (doc["service"].is<const char *>()) {
+          String proto = doc["proto"] | "tcp";
+          if (proto.startsWith("_"))
+            proto.remove(0, 1);
+          types.push_back(doc["service"].as<String>() + "._" + proto);
+        }
 
+        // The main loop runs the queries; the cache stays readable meanwhile
+        if (!mdnsBrowse(types)) {
+          req->send(200, "application/json",
+                    "{\"status\":\"already_running\"}");
+          return;
+        }
         req->send(200, "application/json", "{\"status\":\"started\"}");
       });
 
-  // API: MDNS Status/Results
+  // API: MDNS Status/Results (?type=_airplay._tcp to filter)
   server.on("/api/mdns/status", HTTP_GET, [](AsyncWebServerRequest *req) {
-    req->send(200, "application/json", mdnsResultsJson);
+    String type = req->hasParam("type") ? req->getParam("type")->value() : "";
+    JsonDocument doc;
+    mdnsResultsToJson(doc, type);
+    String out;
+    serializeJson(doc, out);
+    req->send(200, "application/json", out);
   });
 
   // API: SSDP Scan Start
@@ -434,18 +501,26 @@ void setupRoutes() {
   wsLog.onEvent([](AsyncWebSocket *, AsyncWebSocketClient *c, AwsEventType t,
                    void *, uint8_t *, size_t) {
     if (t == WS_EVT_CONNECT)
-      c->text("log connected");
+      wsFanText(wsLog, c->id(), "log connected");
   });
 
   wsUdp.onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client,
                    AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    wsStreamNegotiate(server, client, type, data, len);
     // Optional: handle UDP send requests from UI via WS if we want
   });
 
+  wsProxy.onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client,
+                     AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    wsStreamNegotiate(server, client, type, data, len);
+  });
+
   // TCP Server WS
   wsTcpServer.onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client,
                          AwsEventType type, void *arg, uint8_t *data,
                          size_t len) {
+    if (wsStreamNegotiate(server, client, type, data, len))
+      return;
     if (type == AwsEventType::WS_EVT_CONNECT) {
       // Send initial status?
     }
@@ -458,9 +533,45 @@ void setupRoutes() {
   server.addHandler(&wsDisc);
   server.addHandler(&wsRS232);
   server.addHandler(&wsUdp); // Register UDP WS
+  server.addHandler(&wsMacro);
+
+  // Logs, discovery events and macro step traces tolerate gaps (the
+  // oldest go first); byte streams must not silently skip.
+  wsFanConfigure(wsLog, WS_FAN_DROP_OLDEST);
+  wsFanConfigure(wsDisc, WS_FAN_DROP_OLDEST);
+  wsFanConfigure(wsMacro, WS_FAN_DROP_OLDEST);
+  wsFanConfigure(wsTerm, WS_FAN_DISCONNECT);
+  wsFanConfigure(wsRS232, WS_FAN_DISCONNECT);
+  wsFanConfigure(wsProxy, WS_FAN_DISCONNECT);
+  wsFanConfigure(wsUdp, WS_FAN_DISCONNECT);
+  wsFanConfigure(wsTcpServer, WS_FAN_DISCONNECT);
+
+  server.on(
+      "/api/ws/policy", HTTP_POST, [](AsyncWebServerRequest *req) {}, nullptr,
+      [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
+         size_t) {
+        JsonDocument doc;
+        if (deserializeJson(doc, data, len)) {
+          req->send(400, "application/json", "{\"error\":\"bad json\"}");
+          return;
+        }
+        WsFanPolicy policy;
+        if (!wsFanParsePolicy(doc["policy"] | "", policy)) {
+          req->send(400, "application/json", "{\"error\":\"bad policy\"}");
+          return;
+        }
+        if (!wsFanConfigure(doc["channel"] | "", policy, doc["budget"] | 0)) {
+          req->send(404, "application/json",
+                    "{\"error\":\"unknown channel\"}");
+          return;
+        }
+        req->send(200, "application/json", "{\"status\":\"ok\"}");
+      });
 
-  wsTerm.onEvent([](AsyncWebSocket *, AsyncWebSocketClient *c, AwsEventType t,
+  wsTerm.onEvent([](AsyncWebSocket *s, AsyncWebSocketClient *c, AwsEventType t,
                     void *, uint8_t *data, size_t len) {
+    if (wsStreamNegotiate(s, c, t, data, len))
+      return;
     if (t != WS_EVT_DATA)
       return;
 
@@ -490,7 +601,8 @@ void setupRoutes() {
 
     if (action == "send") {
       if (!termConnected) {
-        c->text(R"({"type":"error","msg":"Not connected"})");
+        wsFanText(wsTerm, c->id(),
+                  R"({"type":"error","msg":"Not connected"})");
         return;
       }
       String mode = doc["mode"] | "ascii";
@@ -499,7 +611,8 @@ void setupRoutes() {
       if (mode == "hex") {
         std::vector<uint8_t> bytes;
         if (!parseHexBytes(payload, bytes)) {
-          c->text(R"({"type":"error","msg":"Bad hex"})");
+          wsFanText(wsTerm, c->id(),
+                    R"({"type":"error","msg":"Bad hex"})");
           return;
         }
         termRequestSend(bytes.data(), bytes.size());
@@ -515,7 +628,7 @@ void setupRoutes() {
           out += suffix;
         termRequestSend((const uint8_t *)out.c_str(), out.length());
       }
-      c->text(R"({"type":"tx","ok":true})");
+      wsFanText(wsTerm, c->id(), R"({"type":"tx","ok":true})");
       return;
     }
   });
@@ -595,12 +708,11 @@ void setupRoutes() {
   });
 
   server.on("/api/scan/subnet", HTTP_POST, [](AsyncWebServerRequest *req) {
-    if (discRunning) {
+    if (!startDisc()) {
       req->send(409, "application/json",
                 "{\"error\":\"scan already running\"}");
       return;
     }
-    startDisc();
     req->send(200, "application/json", "{\"ok\":true}");
   });
 
@@ -625,31 +737,62 @@ void setupRoutes() {
               ports.push_back(p);
           }
         }
-        if (ports.empty())
-          ports = {23, 80, 443, 5000, 1515, 6100};
-        if (!subnet.length()) {
-          IPAddress ip = WiFi.localIP();
-          subnet = String(ip[0]) + "." + String(ip[1]) + "." + String(ip[2]);
+        if (ports.size() > discMaxPorts) {
+          req->send(400, "application/json",
+                    "{\"error\":\"at most " + String(discMaxPorts) +
+                        " ports\"}");
+          return;
+        }
+        // Full width; startDisc() clamps it.
+        uint32_t window = doc["window"] | 0u;
+        if (!startDisc(subnet, from, to, ports, window)) {
+          req->send(409, "application/json",
+                    "{\"error\":\"scan already running\"}");
+          return;
         }
-        bool ok = true; // startDiscovery implementation needed
-        // For now, call the one we have
-        startDisc();
         req->send(200, "application/json", "{\"ok\":true}");
       });
 
+  // The cursor is (sweep << 16) | row index; a cursor from an earlier sweep
+  // starts over from row 0 and sets "reset".
   server.on("/api/discovery/results", HTTP_GET, [](AsyncWebServerRequest *req) {
-    JsonDocument doc;
-    doc["running"] = discRunning;
-    doc["progress"] = discProgress;
-    JsonArray arr = doc["results"].to<JsonArray>();
-    for (auto &line : discFound) {
-      JsonDocument row;
-      if (!deserializeJson(row, line))
-        arr.add(row.as<JsonObject>());
+    ListQuery q = listQuery(req, 10);
+    DiscLock lock; // rows and the sweep's port list change together
+    size_t from = 0;
+    bool reset = false;
+    if (q.hasSince) {
+      if ((q.since >> 16) == discSweep)
+        from = q.since & 0xFFFF;
+      else
+        reset = true;
     }
-    String out;
-    serializeJson(doc, out);
-    req->send(200, "application/json", out);
+    JsonDocument head;
+    head["running"] = discRunning;
+    head["progress"] = discProgress;
+    head["probes"] = discStats.probes;
+    head["probesPerSec"] = discStats.probesPerSec;
+    head["elapsedMs"] = discStats.elapsedMs;
+    head["window"] = discStats.window;
+    head["timeoutMs"] = discStats.timeoutMs;
+    if (reset)
+      head["reset"] = true;
+
+    AsyncResponseStream *res = req->beginResponseStream("application/json");
+    beginList(*res, head, "results");
+    size_t total = discFound.size();
+    size_t to = q.limit ? std::min(total, from + q.limit) : total;
+    bool first = true;
+    JsonDocument row;
+    for (size_t i = from; i < to; i++) {
+      row.clear();
+      discHostToJson(discFound[i], row.to<JsonObject>());
+      writeRecord(*res, row.as<JsonObjectConst>(), q, first);
+    }
+    res->printf("],\"cursor\":%lu,\"more\":%s}",
+                (unsigned long)(((uint32_t)discSweep << 16) |
+                                std::max(from, to)),
+                to < total ? "true" : "false");
+    req->send(res);
   });
 
   server.on("/api/captures", HTTP_GET, [](AsyncWebServerRequest *req) {
@@ -657,31 +800,57 @@ void setupRoutes() {
         req->hasParam("filter") ? req->getParam("filter")->value() : "";
     bool pinnedOnly =
         req->hasParam("pinned") && req->getParam("pinned")->value() == "1";
-    JsonDocument doc;
-    JsonArray arr = doc["captures"].to<JsonArray>();
-    for (int i = (int)caps.size() - 1; i >= 0; i--) {
-      const auto &c = caps[i];
+    // Without since: newest first, and "before" (when more is set) pages
+    // back with ?before=. With since (a capture id, hex as returned in
+    // "cursor"): only later captures, oldest first, so a poll can page
+    // forward with the returned cursor. In newest-first mode cursor is the
+    // newest capture overall, ready for the first forward poll.
+    ListQuery q = listQuery(req, 16);
+    bool hasBefore = !q.hasSince && req->hasParam("before");
+    uint32_t before =
+        hasBefore ? strtoul(req->getParam("before")->value().c_str(), nullptr,
+                            16)
+                  : 0;
+    uint32_t cursor = q.since;
+    uint32_t oldest = 0;
+    size_t n = 0;
+    bool more = false;
+    bool first = true;
+    JsonDocument rec;
+    AsyncResponseStream *res = req->beginResponseStream("application/json");
+    res->print("{\"captures\":[");
+    captureForEach(!q.hasSince, [&](CaptureRec &c) {
+      if (q.hasSince && (int32_t)(c.id - q.since) <= 0)
+        return true;
+      if (!q.hasSince)
+        cursor = std::max(cursor, c.id);
+      if (hasBefore && (int32_t)(c.id - before) >= 0)
+        return true;
+      if (q.limit && n >= q.limit) {
+        more = true;
+        return false;
+      }
+      if (q.hasSince)
+        cursor = c.id;
+      else
+        oldest = c.id;
       if (pinnedOnly && !c.pinned)
-        continue;
-      if (filter.length() && c.srcIp.indexOf(filter) < 0)
-        continue;
-      JsonObject o = arr.add<JsonObject>();
-      o["id"] = c.id;
-      o["ts"] = c.ts;
-      o["srcIp"] = c.srcIp;
-      o["srcPort"] = c.srcPort;
-      o["localPort"] = c.localPort;
-      o["hex"] = c.hex;
-      o["ascii"] = c.ascii;
-      o["pinned"] = c.pinned;
-      o["repeats"] = c.repeats;
-      o["lastTs"] = c.lastTs;
-      o["suffixHint"] = c.suffixHint;
-      o["payloadType"] = c.payloadType;
-    }
-    String out;
-    serializeJson(doc, out);
-    req->send(200, "application/json", out);
+        return true;
+      if (filter.length() && captureSrcIp(c).indexOf(filter) < 0)
+        return true;
+      rec.clear();
+      captureToJson(c, rec.to<JsonObject>());
+      writeRecord(*res, rec.as<JsonObjectConst>(), q, first);
+      n++;
+      return true;
+    });
+    res->printf("],\"cursor\":\"%08lX\",\"more\":%s,",
+                (unsigned long)cursor, more ? "true" : "false");
+    if (!q.hasSince && more)
+      res->printf("\"before\":\"%08lX\",", (unsigned long)oldest);
+    res->printf("\"capacity\":%u,\"used\":%u}", (unsigned)captureCapacity(),
+                (unsigned)captureUsed());
+    req->send(res);
   });
 
   server.on(
@@ -695,46 +864,43 @@ void setupRoutes() {
         }
         String id = doc["id"] | "";
         bool pin = doc["pin"] | true;
-        for (auto &c : caps)
-          if (c.id == id) {
-            c.pinned = pin;
-            break;
-          }
+        CaptureRec *c = findCapture(id);
+        if (c)
+          c->pinned = pin;
         req->send(200, "application/json", "{\"ok\":true}");
       });
 
+  // Streams the shared snapshot in chunks instead of copying it into the
+  // response; a config change meanwhile swaps in a new snapshot.
   server.on("/api/config", HTTP_GET, [](AsyncWebServerRequest *req) {
-    req->send(200, "application/json", cfgJson);
+    std::shared_ptr<const String> snap = cfgSnapshot();
+    req->send(req->beginResponse(
+        "application/json", snap->length(),
+        [snap](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+          size_t n = std::min(maxLen, snap->length() - index);
+          memcpy(buf, snap->c_str() + index, n);
+          return n;
+        }));
   });
 
   server.on(
       "/api/config", HTTP_POST, [](AsyncWebServerRequest *req) {}, nullptr,
       [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
          size_t) {
-        JsonDocument tmp;
-        if (deserializeJson(tmp, data, len)) {
+        if (!setCfgJson((const char *)data, len)) {
           req->send(400, "application/json", "{\"error\":\"bad json\"}");
           return;
         }
-        cfgJson = String((const char *)data).substring(0, len);
         saveCfg();
         req->send(200, "application/json", "{\"ok\":true}");
       });
 
-  server.on("/api/devices", HTTP_GET, [](AsyncWebServerRequest *req) {
-    JsonDocument doc;
-    if (deserializeJson(doc, cfgJson)) {
-      req->send(500, "application/json", "{\"error\":\"cfg parse\"}");
-      return;
-    }
-    String out;
-    serializeJson(doc["devices"], out);
-    req->send(200, "application/json", out);
-  });
-
   server.on("/api/devices/status", HTTP_GET, [](AsyncWebServerRequest *req) {
     JsonDocument doc;
+    doc["probeBudgetPerSec"] = monBudgetPerSec;
+    doc["window"] = monWindow;
     JsonArray arr = doc["status"].to<JsonArray>();
+    DevLock lock;
     for (auto &s : devStatuses) {
       JsonObject o = arr.add<JsonObject>();
       o["id"] = s.id;
@@ -742,12 +908,59 @@ void setupRoutes() {
       o["lastSeenMs"] = s.lastSeenMs;
       o["ip"] = s.lastIp;
       o["port"] = s.lastPort;
+      o["probes"] = s.probes;
+      o["fails"] = s.fails;
+      o["intervalMs"] = s.intervalMs;
+      o["nextProbeMs"] = s.nextProbeMs;
+      if (s.rttCount) {
+        JsonObject rtt = o["rttMs"].to<JsonObject>();
+        rtt["min"] = s.rttMinMs;
+        rtt["avg"] = s.rttAvgMs;
+        rtt["p95"] = s.rttP95Ms;
+        rtt["samples"] = s.rttCount;
+      }
     }
     String out;
     serializeJson(doc, out);
     req->send(200, "application/json", out);
   });
 
+  // After /api/devices/status, which it would otherwise shadow.
+  server.on("/api/devices", HTTP_GET, [](AsyncWebServerRequest *req) {
+    JsonDocument doc;
+    deviceRegistry.toJson(doc.to<JsonArray>());
+    String out;
+    serializeJson(doc, out);
+    req->send(200, "application/json", out);
+  });
+
+  server.on(
+      "/api/devices/monitor", HTTP_POST, [](AsyncWebServerRequest *req) {},
+      nullptr,
+      [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
+         size_t) {
+        JsonDocument doc;
+        if (deserializeJson(doc, data, len)) {
+          req->send(400, "application/json", "{\"error\":\"bad json\"}");
+          return;
+        }
+        JsonVariant budget = doc["probeBudgetPerSec"];
+        JsonVariant window = doc["window"];
+        if ((!budget.isNull() && !budget.is<uint32_t>()) ||
+            (!window.isNull() && !window.is<uint32_t>())) {
+          req->send(400, "application/json",
+                    "{\"error\":\"expected a non-negative integer\"}");
+          return;
+        }
+        // Read full width so an oversized value clamps instead of being
+        // dropped.
+        if (!budget.isNull())
+          monBudgetPerSec = constrain(budget.as<uint32_t>(), 1u, 200u);
+        if (!window.isNull())
+          monWindow = constrain(window.as<uint32_t>(), 1u, 16u);
+        req->send(200, "application/json", "{\"ok\":true}");
+      });
+
   server.on(
       "/api/devices/add", HTTP_POST, [](AsyncWebServerRequest *req) {}, nullptr,
       [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
@@ -810,26 +1023,64 @@ void setupRoutes() {
           req->send(400, "application/json", "{\"error\":\"missing ip\"}");
           return;
         }
-
-        pjlPendingIp = ip;
-        pjlPendingPass = doc["pass"] | "";
-        pjlPendingCmd = doc["cmd"] | "";
-        pjlPending = true;
-        pjlFinished = false;
-
-        req->send(200, "application/json", "{\"status\":\"started\"}");
+        // A name is resolved by pjlinkLoop(); a lookup here would stall
+        // async_tcp for the DNS timeout.
+        String pass = doc["pass"] | "";
+
+        // "cmd" for one command, or "cmds" to queue several on one session.
+        std::vector<String> cmds;
+        if (doc["cmds"].is<JsonArray>()) {
+          for (JsonVariant c : doc["cmds"].as<JsonArray>())
+            cmds.push_back(c | "");
+        } else {
+          cmds.push_back(doc["cmd"] | "");
+        }
+        // An empty command would put a bare CR on the wire.
+        bool blank = cmds.empty();
+        for (auto &c : cmds)
+          blank |= !c.length();
+        if (blank) {
+          req->send(400, "application/json", "{\"error\":\"missing cmd\"}");
+          return;
+        }
+        // All or nothing, so no queued command is left without its id.
+        std::vector<uint32_t> ids;
+        if (!pjlinkSubmitAll(ip, pass, cmds, ids)) {
+          req->send(429, "application/json",
+                    "{\"error\":\"too many pending requests\"}");
+          return;
+        }
+        JsonDocument res;
+        JsonArray reqs = res["reqs"].to<JsonArray>();
+        for (uint32_t id : ids)
+          reqs.add(id);
+        res["status"] = "started";
+        res["req"] = reqs[0];
+        String out;
+        serializeJson(res, out);
+        req->send(200, "application/json", out);
       });
 
   server.on("/api/pjlink/status", HTTP_GET, [](AsyncWebServerRequest *req) {
+    static const char *const names[] = {"queued", "running", "done", "error"};
+    uint32_t id =
+        req->hasParam("req") ? req->getParam("req")->value().toInt() : 0;
     JsonDocument doc;
-    if (pjlPending) {
-      doc["status"] = "running";
-    } else if (pjlFinished) {
-      doc["status"] = "done";
-      doc["response"] = (const char *)pjlResultBuf;
+    PjlRequest r;
+    if (!pjlinkRequest(id, r)) {
+      doc["status"] = id ? "unknown" : "idle";
     } else {
-      doc["status"] = "idle";
+      doc["req"] = r.id;
+      doc["ip"] = r.host;
+      doc["cmd"] = r.cmd;
+      doc["status"] = names[r.state];
+      if (r.state >= PJL_DONE) {
+        doc["response"] = r.response;
+        doc["ms"] = r.doneMs - r.queuedMs;
+      }
+      doc["reusedSession"] = r.reusedSession;
     }
+    doc["sessions"] = pjlinkSessionCount();
     String out;
     serializeJson(doc, out);
     req->send(200, "application/json", out);
@@ -892,6 +1143,10 @@ void setupRoutes() {
           learnEnabled = doc["enabled"];
         if (doc["port"].is<uint16_t>())
           learnPort = doc["port"];
+        if (doc["dedupMs"].is<uint32_t>())
+          capDedupMs = doc["dedupMs"];
+        if (doc["capBytes"].is<uint32_t>())
+          captureSetCapacity(doc["capBytes"].as<uint32_t>());
 
         // If enabling, we might want to ensure the server is restarted or
         // relevant logic applied, but for now just updating globals as
@@ -901,27 +1156,10 @@ void setupRoutes() {
 
   server.on("/api/capture/get", HTTP_GET, [](AsyncWebServerRequest *req) {
     String id = req->hasParam("id") ? req->getParam("id")->value() : "";
-    JsonDocument doc;
-    bool found = false;
-    for (const auto &c : caps) {
-      if (c.id == id) {
-        doc["id"] = c.id;
-        doc["ts"] = c.ts;
-        doc["srcIp"] = c.srcIp;
-        doc["srcPort"] = c.srcPort;
-        doc["localPort"] = c.localPort;
-        doc["hex"] = c.hex;
-        doc["ascii"] = c.ascii;
-        doc["pinned"] = c.pinned;
-        doc["repeats"] = c.repeats;
-        doc["lastTs"] = c.lastTs;
-        doc["suffixHint"] = c.suffixHint;
-        doc["payloadType"] = c.payloadType;
-        found = true;
-        break;
-      }
-    }
-    if (found) {
+    CaptureRec *c = findCapture(id);
+    if (c) {
+      JsonDocument doc;
+      captureToJson(*c, doc.to<JsonObject>());
       String out;
       serializeJson(doc, out);
       req->send(200, "application/json", out);
@@ -936,8 +1174,13 @@ void setupRoutes() {
     req->send(200, "application/json", "{\"ok\":true}");
   });
   // ── Macro API ──
-  server.on("/api/macros", HTTP_GET, [](AsyncWebServerRequest *req) {
-    req->send(200, "application/json", macroHandler.listJson());
+  server.on("/api/macros/trace", HTTP_GET, [](AsyncWebServerRequest *req) {
+    String id = req->hasParam("id") ? req->getParam("id")->value() : "";
+    String json = macroHandler.traceJson(id);
+    if (json.length())
+      req->send(200, "application/json", json);
+    else
+      req->send(404, "application/json", "{\"error\":\"not found\"}");
   });
 
   server.on("/api/macros/get", HTTP_GET, [](AsyncWebServerRequest *req) {
@@ -946,6 +1189,12 @@ void setupRoutes() {
     req->send(200, "application/json", json);
   });
 
+  // After the /api/macros/... GET routes: a handler for a path also takes
+  // every path below it.
+  server.on("/api/macros", HTTP_GET, [](AsyncWebServerRequest *req) {
+    req->send(200, "application/json", macroHandler.listJson());
+  });
+
   server.on(
       "/api/macros/save", HTTP_POST, [](AsyncWebServerRequest *req) {}, nullptr,
       [](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t,
@@ -980,12 +1229,20 @@ void setupRoutes() {
         if (deserializeJson(doc, data, len))
           return req->send(400);
         String id = doc["id"] | "";
-        if (macroHandler.execute(id))
+        if (!macroHandler.has(id))
+          return req->send(404, "application/json",
+                           "{\"error\":\"not found\"}");
+        if (macroHandler.planErrorCount(id))
+          return req->send(422, "application/json",
+                           "{\"error\":\"Macro has compile errors\"}");
+        uint32_t runId = macroHandler.execute(id);
+        if (runId)
           req->send(200, "application/json",
-                    "{\"ok\":true,\"msg\":\"Running. See logs.\"}");
+                    "{\"ok\":true,\"runId\":" + String(runId) +
+                        ",\"msg\":\"Queued. See logs.\"}");
         else
           req->send(409, "application/json",
-                    "{\"error\":\"Macro already running\"}");
+                    "{\"error\":\"Macro queue full\"}");
       });
 
   // ── Dashboard aggregate endpoint ──
@@ -1003,15 +1260,25 @@ void setupRoutes() {
     doc["learn_enabled"] = learnEnabled;
     doc["rs232_telnet"] = rs232TelnetConnected;
     doc["macros_count"] = 0; // placeholder — count from macroHandler
+    TcpPoolStats pool = tcpPoolStats();
+    JsonObject po = doc["macro_pool"].to<JsonObject>();
+    po["open"] = pool.open;
+    po["busy"] = pool.busy;
+    po["connects"] = pool.connects;
+    po["reuses"] = pool.reuses;
+    po["expired"] = pool.expired;
 
     // Device statuses
     JsonArray devArr = doc["devices"].to<JsonArray>();
-    for (auto &s : devStatuses) {
-      JsonObject o = devArr.add<JsonObject>();
-      o["id"] = s.id;
-      o["online"] = s.online;
-      o["ip"] = s.lastIp;
-      o["port"] = s.lastPort;
+    {
+      DevLock lock;
+      for (auto &s : devStatuses) {
+        JsonObject o = devArr.add<JsonObject>();
+        o["id"] = s.id;
+        o["online"] = s.online;
+        o["ip"] = s.lastIp;
+        o["port"] = s.lastPort;
+      }
     }
 
     String out;
@@ -1021,24 +1288,16 @@ void setupRoutes() {
 
   // ── Templates endpoint ──
   server.on("/api/templates", HTTP_GET, [](AsyncWebServerRequest *req) {
-    // Return templates from config
-    JsonDocument cfgDoc;
-    if (deserializeJson(cfgDoc, cfgJson)) {
-      req->send(500, "application/json", "{\"error\":\"cfg parse\"}");
-      return;
-    }
-    JsonDocument out;
-    JsonArray arr = out["templates"].to<JsonArray>();
-    if (cfgDoc["templates"].is<JsonArray>()) {
-      for (JsonObject t : cfgDoc["templates"].as<JsonArray>()) {
-        arr.add(t);
-      }
-    }
-    String s;
-    serializeJson(out, s);
-    req->send(200, "application/json", s);
+    AsyncResponseStream *res = req->beginResponseStream("application/json");
+    res->print("{\"templates\":");
+    templateRegistry.writeJson(*res);
+    res->print('}');
+    req->send(res);
   });
 
+  // Compressed, hash-validated UI from the build manifest; serveStatic
+  // covers anything else (and a filesystem uploaded without the manifest).
+  setupStaticAssets(server);
   server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
   server.serveStatic("/rs232_pro.html", LittleFS, "/rs232_pro.html");
 }
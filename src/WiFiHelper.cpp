@@ -1,4 +1,5 @@
 #include "WiFiHelper.h"
+#include "LogPipeline.h"
 #include <ArduinoJson.h>
 #include <esp_wifi.h>
 
@@ -98,7 +99,7 @@ String _genScanJson(int n) {
 void tryScanAsync() {
   if (WiFi.scanComplete() != WIFI_SCAN_RUNNING) {
     WiFi.scanNetworks(true); // Async = true
-    Serial.println("WIFI: Async Scan started");
+    logAt(LOGLV_DEBUG, "WIFI", "Async scan started");
   }
 }
 
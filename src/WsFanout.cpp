@@ -0,0 +1,225 @@
+#include "WsFanout.h"
+#include "RecursiveLock.h"
+#include <deque>
+#include <vector>
+
+struct FanFrame {
+  bool binary;
+  std::vector<uint8_t> data;
+};
+
+struct FanClient {
+  AsyncWebSocket *ws;
+  uint32_t id;
+  std::deque<FanFrame> held; // not yet handed to AsyncWebSocket
+  size_t heldBytes = 0;
+  // Sizes of frames in the socket's own queue, oldest first. The socket
+  // doesn't report completions, so a shrinking queueLen() retires them.
+  std::deque<size_t> inSocket;
+  size_t socketBytes = 0;
+  uint32_t queued = 0; // frames accepted for this client
+  uint32_t sent = 0;
+  uint32_t dropped = 0;
+};
+
+struct FanChannel {
+  AsyncWebSocket *ws;
+  WsFanPolicy policy;
+  size_t budget;
+  uint32_t disconnects = 0;
+};
+
+static std::vector<FanChannel> channels;
+static std::vector<FanClient> fanClients;
+static SemaphoreHandle_t fanMutex = nullptr;
+
+static const char *const policyNames[] = {"coalesce", "drop-oldest",
+                                          "disconnect"};
+
+// Senders run on the loop, the async_tcp task and worker tasks.
+struct FanLock : RecursiveLock {
+  FanLock() : RecursiveLock(fanMutex) {}
+};
+
+static FanChannel &channelFor(AsyncWebSocket &ws) {
+  for (auto &ch : channels)
+    if (ch.ws == &ws)
+      return ch;
+  channels.push_back({&ws, WS_FAN_DROP_OLDEST, wsFanDefaultBudget});
+  return channels.back();
+}
+
+static FanClient &clientFor(AsyncWebSocket &ws, uint32_t id) {
+  for (auto &c : fanClients)
+    if (c.ws == &ws && c.id == id)
+      return c;
+  fanClients.emplace_back();
+  FanClient &c = fanClients.back();
+  c.ws = &ws;
+  c.id = id;
+  return c;
+}
+
+static void eraseClient(FanClient &c) {
+  fanClients.erase(fanClients.begin() + (&c - fanClients.data()));
+}
+
+static void reconcile(FanClient &c, AsyncWebSocketClient *wc) {
+  size_t left = wc->queueLen();
+  while (c.inSocket.size() > left) {
+    c.socketBytes -= c.inSocket.front();
+    c.inSocket.pop_front();
+    c.sent++;
+  }
+}
+
+static void flush(FanClient &c, AsyncWebSocketClient *wc, size_t budget) {
+  while (!c.held.empty() && wc->canSend()) {
+    FanFrame &f = c.held.front();
+    // An empty socket queue always takes one frame, however large.
+    if (c.socketBytes && c.socketBytes + f.data.size() > budget)
+      break;
+    if (f.binary)
+      wc->binary(f.data.data(), f.data.size());
+    else
+      wc->text((const char *)f.data.data(), f.data.size());
+    c.inSocket.push_back(f.data.size());
+    c.socketBytes += f.data.size();
+    c.heldBytes -= f.data.size();
+    c.held.pop_front();
+  }
+}
+
+static void enqueue(AsyncWebSocket &ws, AsyncWebSocketClient *wc, bool binary,
+                    const uint8_t *data, size_t len) {
+  FanChannel &ch = channelFor(ws);
+  FanClient &c = clientFor(ws, wc->id());
+  reconcile(c, wc);
+  c.queued++;
+
+  size_t pending = c.socketBytes + c.heldBytes;
+  if (pending && pending + len > ch.budget) {
+    switch (ch.policy) {
+    case WS_FAN_DISCONNECT:
+      ch.disconnects++;
+      wc->close(1008, "slow consumer");
+      eraseClient(c);
+      return;
+    case WS_FAN_COALESCE:
+      c.dropped += c.held.size();
+      c.held.clear();
+      c.heldBytes = 0;
+      break;
+    case WS_FAN_DROP_OLDEST:
+      while (!c.held.empty() && c.socketBytes + c.heldBytes + len > ch.budget) {
+        c.heldBytes -= c.held.front().data.size();
+        c.held.pop_front();
+        c.dropped++;
+      }
+      // What the socket already has can't be recalled.
+      if (c.socketBytes + c.heldBytes + len > ch.budget && c.socketBytes) {
+        c.dropped++;
+        return;
+      }
+      break;
+    }
+  }
+  c.held.push_back({binary, std::vector<uint8_t>(data, data + len)});
+  c.heldBytes += len;
+  flush(c, wc, ch.budget);
+}
+
+void wsFanConfigure(AsyncWebSocket &ws, WsFanPolicy policy, size_t budget) {
+  FanLock lock;
+  FanChannel &ch = channelFor(ws);
+  ch.policy = policy;
+  ch.budget = budget;
+}
+
+bool wsFanConfigure(const String &url, WsFanPolicy policy, size_t budget) {
+  FanLock lock;
+  for (auto &ch : channels) {
+    if (url != ch.ws->url())
+      continue;
+    ch.policy = policy;
+    if (budget)
+      ch.budget = budget;
+    return true;
+  }
+  return false;
+}
+
+bool wsFanParsePolicy(const String &name, WsFanPolicy &out) {
+  for (uint8_t p = 0; p < 3; p++) {
+    if (name == policyNames[p]) {
+      out = (WsFanPolicy)p;
+      return true;
+    }
+  }
+  return false;
+}
+
+void wsFanText(AsyncWebSocket &ws, uint32_t clientId, const String &s) {
+  FanLock lock;
+  AsyncWebSocketClient *wc = ws.client(clientId);
+  if (wc && wc->status() == WS_CONNECTED)
+    enqueue(ws, wc, false, (const uint8_t *)s.c_str(), s.length());
+}
+
+void wsFanBinary(AsyncWebSocket &ws, uint32_t clientId, const uint8_t *data,
+                 size_t len) {
+  FanLock lock;
+  AsyncWebSocketClient *wc = ws.client(clientId);
+  if (wc && wc->status() == WS_CONNECTED)
+    enqueue(ws, wc, true, data, len);
+}
+
+void wsFanTextAll(AsyncWebSocket &ws, const String &s) {
+  FanLock lock;
+  std::vector<uint32_t> ids;
+  for (auto &c : ws.getClients())
+    if (c.status() == WS_CONNECTED)
+      ids.push_back(c.id());
+  for (uint32_t id : ids)
+    wsFanText(ws, id, s);
+}
+
+void wsFanBegin() { fanMutex = xSemaphoreCreateRecursiveMutex(); }
+
+void wsFanLoop() {
+  FanLock lock;
+  for (size_t i = 0; i < fanClients.size();) {
+    FanClient &c = fanClients[i];
+    AsyncWebSocketClient *wc = c.ws->client(c.id);
+    if (!wc || wc->status() != WS_CONNECTED) {
+      fanClients.erase(fanClients.begin() + i);
+      continue;
+    }
+    reconcile(c, wc);
+    flush(c, wc, channelFor(*c.ws).budget);
+    i++;
+  }
+}
+
+void wsFanStatsJson(JsonArray out) {
+  FanLock lock;
+  for (auto &ch : channels) {
+    JsonObject o = out.add<JsonObject>();
+    o["channel"] = ch.ws->url();
+    o["policy"] = policyNames[ch.policy];
+    o["budget"] = ch.budget;
+    o["disconnects"] = ch.disconnects;
+    JsonArray arr = o["clients"].to<JsonArray>();
+    for (auto &c : fanClients) {
+      if (c.ws != ch.ws)
+        continue;
+      JsonObject co = arr.add<JsonObject>();
+      co["id"] = c.id;
+      co["queued"] = c.queued;
+      co["sent"] = c.sent;
+      co["dropped"] = c.dropped;
+      co["pendingBytes"] = c.socketBytes + c.heldBytes;
+      co["held"] = c.held.size();
+    }
+  }
+}
@@ -0,0 +1,130 @@
+#include "WsStream.h"
+#include "Utils.h"
+#include "WsFanout.h"
+
+// Clients that asked for binary frames. Fixed slots so senders on other
+// tasks never see the table reallocate under them.
+struct BinClient {
+  AsyncWebSocket *ws;
+  uint32_t id;
+};
+static const size_t maxBinClients = 16;
+static BinClient binClients[maxBinClients];
+
+static bool isBinary(AsyncWebSocket *ws, uint32_t id) {
+  for (auto &b : binClients)
+    if (b.ws == ws && b.id == id)
+      return true;
+  return false;
+}
+
+static void setBinary(AsyncWebSocket *ws, uint32_t id, bool on) {
+  for (auto &b : binClients) {
+    if (b.ws == ws && b.id == id) {
+      if (!on)
+        b.ws = nullptr;
+      return;
+    }
+  }
+  if (!on)
+    return;
+  for (auto &b : binClients) {
+    if (!b.ws) {
+      b.id = id;
+      b.ws = ws;
+      return;
+    }
+  }
+}
+
+bool wsStreamNegotiate(AsyncWebSocket *ws, AsyncWebSocketClient *client,
+                       AwsEventType type, uint8_t *data, size_t len) {
+  if (type == WS_EVT_DISCONNECT) {
+    setBinary(ws, client->id(), false);
+    return false;
+  }
+  if (type != WS_EVT_DATA)
+    return false;
+
+  // Cheap pre-check so ordinary commands aren't parsed twice.
+  static const char key[] = "\"binary\"";
+  if (len < sizeof(key) - 1 ||
+      !memmem(data, len, key, sizeof(key) - 1))
+    return false;
+  JsonDocument doc;
+  if (deserializeJson(doc, data, len))
+    return false;
+  if (String(doc["action"] | "") != "binary")
+    return false;
+
+  bool on = doc["on"] | true;
+  setBinary(ws, client->id(), on);
+  on = isBinary(ws, client->id()); // false if the table was full
+  JsonDocument res;
+  res["type"] = "binary";
+  res["on"] = on;
+  res["version"] = WS_STREAM_VERSION;
+  String out;
+  serializeJson(res, out);
+  wsFanText(*ws, client->id(), out);
+  return true;
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+void wsStreamData(AsyncWebSocket &ws, WsChannel ch, WsDir dir,
+                  const uint8_t *data, size_t len, JsonDocument &json,
+                  const IPAddress &srcIp, uint16_t srcPort) {
+  bool anyBinary = false, anyJson = false;
+  for (auto &c : ws.getClients()) {
+    if (c.status() != WS_CONNECTED)
+      continue;
+    if (isBinary(&ws, c.id()))
+      anyBinary = true;
+    else
+      anyJson = true;
+  }
+
+  if (anyBinary) {
+    uint32_t ts = millis();
+    uint32_t ip = (uint32_t)srcIp;
+    std::vector<uint8_t> frame;
+    size_t off = 0;
+    do {
+      uint16_t n = min(len - off, (size_t)0xFFFF);
+      frame.resize(WS_STREAM_HEADER + n);
+      uint8_t *h = frame.data();
+      h[0] = WS_STREAM_VERSION;
+      h[1] = ch;
+      h[2] = dir;
+      h[3] = 0;
+      put32(h + 4, ts);
+      memcpy(h + 8, &ip, 4); // IPAddress already holds network order
+      put16(h + 12, srcPort);
+      put16(h + 14, n);
+      memcpy(h + WS_STREAM_HEADER, data + off, n);
+      for (auto &c : ws.getClients())
+        if (c.status() == WS_CONNECTED && isBinary(&ws, c.id()))
+          wsFanBinary(ws, c.id(), frame.data(), frame.size());
+      off += n;
+    } while (off < len);
+  }
+
+  if (anyJson) {
+    json["hex"] = bytesToHex(data, len);
+    json["ascii"] = bytesToAscii(data, len);
+    String out;
+    serializeJson(json, out);
+    for (auto &c : ws.getClients())
+      if (c.status() == WS_CONNECTED && !isBinary(&ws, c.id()))
+        wsFanText(ws, c.id(), out);
+  }
+}
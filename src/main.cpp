@@ -2,8 +2,11 @@
 #include "AppConfig.h"
 #include "CaptureProxy.h"
 #include "ConfigManager.h"
+#include "LogPipeline.h"
 #include "MacroHandler.h"
+#include "MdnsBrowser.h"
 #include "OTAHandler.h"
+#include "PJLink.h"
 #include "PortScanner.h"
 #include "RS232Handler.h"
 #include "SSDPScanner.h"
@@ -11,29 +14,23 @@
 #include "Utils.h"
 #include "WebAPI.h"
 #include "WiFiHelper.h"
+#include "WsFanout.h"
 #include <ArduinoOTA.h>
 #include <ESPmDNS.h>
 #include <LittleFS.h>
 
-// Defined in WebAPI.cpp
-extern void mdnsScanLoop();
-extern void pjlinkLoop();
-
 Preferences prefs;
 uint32_t bootMs;
 bool shouldReboot = false;
 
-void logAll(const String &s) {
-  Serial.println(s);
-  wsTextAll(wsLog, s);
-}
-
-void wsTextAll(AsyncWebSocket &ws, const String &s) { ws.textAll(s); }
+void wsTextAll(AsyncWebSocket &ws, const String &s) { wsFanTextAll(ws, s); }
 
 void setup() {
   Serial.begin(115200);
   delay(150);
   bootMs = millis();
+  wsFanBegin();
+  logBegin();
 
   if (!LittleFS.begin(true)) {
     Serial.println("LittleFS mount failed");
@@ -53,6 +50,13 @@ void setup() {
     Serial.println("Error setting up MDNS responder!");
   }
 
+  // Mutexes the handlers and tasks below rely on.
+  portScanner.begin();
+  ssdpScanner.begin();
+  mdnsBegin();
+  pjlinkBegin();
+  discBegin();
+
   rs232Setup(); // Initialize Serial2 and RS232 WebSocket handler
   setupRoutes();
   server.begin();
@@ -62,8 +66,6 @@ void setup() {
 
   logAll(String("Ready FW ") + FW_VERSION + " UI: /  OTA: /update");
 
-  portScanner.begin();
-  ssdpScanner.begin();
   macroHandler.begin();
 
   otaHandler.setManifestUrl(OTA_UPDATE_URL);
@@ -75,7 +77,6 @@ void loop() {
     delay(500);
     ESP.restart();
   }
-  rs232Loop();
 
   ArduinoOTA.handle();
 
@@ -95,4 +96,6 @@ void loop() {
   wsRS232.cleanupClients();
   wsUdp.cleanupClients();
   wsTcpServer.cleanupClients();
+  wsMacro.cleanupClients();
+  wsFanLoop();
 }
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Stage the web UI for the LittleFS image.
+
+Copies data/ into .pio/webfs with every text asset pre-compressed (gzip, and
+brotli when the `brotli` module is installed) and writes /assets.json, the
+manifest the firmware serves from (see src/StaticAssets.cpp). Each asset's
+ETag is a hash of its content; index.html references to app.js and style.css
+get ?v=<hash> so those can be cached as immutable.
+
+As a PlatformIO pre-script it points the filesystem build at the staging
+directory. Run it directly to see the transfer sizes:
+
+    python3 tools/compress_assets.py
+"""
+
+import gzip
+import hashlib
+import json
+import os
+import re
+import shutil
+import sys
+
+try:
+    import brotli
+except ImportError:
+    brotli = None
+
+TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+}
+COMPRESSIBLE = {".html", ".js", ".css", ".json", ".svg"}
+FIRST_PAINT = ["index.html", "app.js", "style.css"]
+
+
+def etag_of(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def version_refs(html, tags):
+    # src="app.js?v=2" / href="style.css" -> ?v=<content hash>
+    def sub(m):
+        name = m.group(2)
+        if name not in tags:
+            return m.group(0)
+        return '%s="%s?v=%s"' % (m.group(1), name, tags[name][:8])
+
+    return re.sub(r'(src|href)="([^"?#:]+)(\?[^"]*)?"', sub, html)
+
+
+def stage(src, dst):
+    if os.path.isdir(dst):
+        shutil.rmtree(dst)
+    os.makedirs(dst)
+
+    files = {}
+    for root, _, names in os.walk(src):
+        for name in sorted(names):
+            path = os.path.join(root, name)
+            rel = os.path.relpath(path, src).replace(os.sep, "/")
+            with open(path, "rb") as f:
+                files[rel] = f.read()
+
+    # Hash everything but HTML first so pages can reference the hashes.
+    tags = {rel: etag_of(data) for rel, data in files.items()
+            if not rel.endswith(".html")}
+    for rel in files:
+        if rel.endswith(".html"):
+            files[rel] = version_refs(files[rel].decode(), tags).encode()
+            tags[rel] = etag_of(files[rel])
+
+    manifest = {}
+    sizes = {}
+    for rel, data in files.items():
+        ext = os.path.splitext(rel)[1].lower()
+        out = os.path.join(dst, rel)
+        os.makedirs(os.path.dirname(out), exist_ok=True)
+        enc = []
+        sizes[rel] = {"raw": len(data)}
+        if ext in COMPRESSIBLE:
+            if brotli:
+                br = brotli.compress(data, quality=11)
+                with open(out + ".br", "wb") as f:
+                    f.write(br)
+                enc.append("br")
+                sizes[rel]["br"] = len(br)
+            gz = gzip.compress(data, compresslevel=9, mtime=0)
+            with open(out + ".gz", "wb") as f:
+                f.write(gz)
+            enc.append("gzip")
+            sizes[rel]["gzip"] = len(gz)
+        else:
+            with open(out, "wb") as f:
+                f.write(data)
+        manifest["/" + rel] = {
+            "etag": tags[rel],
+            "type": TYPES.get(ext, "application/octet-stream"),
+            "enc": enc,
+            # HTML is fetched by its plain URL, so it must revalidate.
+            "immutable": not rel.endswith(".html"),
+        }
+
+    with open(os.path.join(dst, "assets.json"), "w") as f:
+        json.dump(manifest, f, separators=(",", ":"), sort_keys=True)
+    return sizes
+
+
+def report(sizes):
+    cols = ["raw", "gzip"] + (["br"] if brotli else [])
+    print("%-14s" % "asset" + "".join("%10s" % c for c in cols))
+    total = dict.fromkeys(cols, 0)
+    for rel in FIRST_PAINT:
+        if rel not in sizes:
+            continue
+        row = sizes[rel]
+        print("%-14s" % rel + "".join("%10d" % row.get(c, row["raw"])
+                                      for c in cols))
+        for c in cols:
+            total[c] += row.get(c, row["raw"])
+    print("%-14s" % "first paint" + "".join("%10d" % total[c] for c in cols))
+
+
+def project_dir():
+    return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    proj = env.subst("$PROJECT_DIR")
+    staged = os.path.join(env.subst("$PROJECT_WORKSPACE_DIR"), "webfs")
+    stage(os.path.join(proj, "data"), staged)
+    env.Replace(PROJECT_DATA_DIR=staged)
+elif __name__ == "__main__":
+    proj = project_dir()
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.join(proj, ".pio",
+                                                             "webfs")
+    report(stage(os.path.join(proj, "data"), out))